@@ -0,0 +1,112 @@
+#include "crc.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//CRC of each 4-bit value, MSb first (16 bytes / 64 bytes of program memory)
+#if (CRC_WIDTH == 32)
+static const crc_t crcTable[16] = {
+    0x00000000, 0x04C11DB7, 0x09823B6E, 0x0D4326D9, 0x130476DC, 0x17C56B6B, 0x1A864DB2, 0x1E475005,
+    0x2608EDB8, 0x22C9F00F, 0x2F8AD6D6, 0x2B4BCB61, 0x350C9B64, 0x31CD86D3, 0x3C8EA00A, 0x384FBDBD
+};
+#else
+static const crc_t crcTable[16] = {
+    0x0000, 0x1021, 0x2042, 0x3063, 0x4084, 0x50A5, 0x60C6, 0x70E7,
+    0x8108, 0x9129, 0xA14A, 0xB16B, 0xC18C, 0xD1AD, 0xE1CE, 0xF1EF
+};
+#endif
+
+#ifndef CRC_USE_HARDWARE
+//Software CRC used in place of the CRC module
+static crc_t softwareCRC = CRC_SEED;
+#endif
+
+//Adds a byte to a software CRC
+crc_t CRC_update(crc_t crc, uint8_t data)
+{
+    //Upper nibble, then lower nibble
+    crc = (crc << 4) ^ crcTable[((uint8_t) (crc >> (CRC_WIDTH - 4)) ^ (data >> 4)) & 0x0F];
+    crc = (crc << 4) ^ crcTable[((uint8_t) (crc >> (CRC_WIDTH - 4)) ^ data) & 0x0F];
+    
+    return crc;
+}
+
+//Returns byte POS (0 = MSB) of a CRC, in the order it is sent
+uint8_t CRC_getByte(crc_t crc, uint8_t pos)
+{
+    return (uint8_t) (crc >> ((CRC_SIZE - 1 - pos) * 8));
+}
+
+//Starts a new CRC on the CRC module
+void CRC_startHardware(void)
+{
+#ifdef CRC_USE_HARDWARE
+    CRCCON0 = 0x00;
+    
+    //Augmented mode (ACCM), MSb first
+    CRCCON0bits.ACCM = 1;
+    CRCCON0bits.SHIFTM = 0;
+    
+    //Polynomial length - 1, data length - 1
+    CRCCON1 = CRC_WIDTH - 1;
+    CRCCON2 = 7;
+    
+    //Polynomial - the LSb is implied
+    CRCXORL = (uint8_t) CRC_POLYNOMIAL;
+    CRCXORH = (uint8_t) (CRC_POLYNOMIAL >> 8);
+#if (CRC_WIDTH == 32)
+    CRCXORU = (uint8_t) (CRC_POLYNOMIAL >> 16);
+    CRCXORT = (uint8_t) (CRC_POLYNOMIAL >> 24);
+#endif
+    
+    //Seed
+    CRCACCL = (uint8_t) CRC_SEED;
+    CRCACCH = (uint8_t) (CRC_SEED >> 8);
+#if (CRC_WIDTH == 32)
+    CRCACCU = (uint8_t) (CRC_SEED >> 16);
+    CRCACCT = (uint8_t) (CRC_SEED >> 24);
+#endif
+    
+    //Enable and start
+    CRCCON0bits.EN = 1;
+    CRCCON0bits.GO = 1;
+#else
+    softwareCRC = CRC_SEED;
+#endif
+}
+
+//Adds a byte to the hardware CRC
+void CRC_updateHardware(uint8_t data)
+{
+#ifdef CRC_USE_HARDWARE
+    //A byte takes 8 instruction cycles - usually done before the next one
+    while (CRCCON0bits.FULL);
+    
+    CRCDATAL = data;
+#else
+    softwareCRC = CRC_update(softwareCRC, data);
+#endif
+}
+
+//Waits for the CRC module and returns the result
+crc_t CRC_getHardware(void)
+{
+#ifdef CRC_USE_HARDWARE
+    crc_t result;
+    
+    while (CRCCON0bits.BUSY);
+    
+    result = ((crc_t) CRCACCH << 8) | CRCACCL;
+#if (CRC_WIDTH == 32)
+    result |= ((crc_t) CRCACCT << 24) | ((crc_t) CRCACCU << 16);
+#endif
+    
+    //Stop the module
+    CRCCON0bits.GO = 0;
+    
+    return result;
+#else
+    return softwareCRC;
+#endif
+}
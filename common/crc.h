@@ -0,0 +1,81 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef CRC_H
+#define	CRC_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//CRC width - 16 (CRC-16/CCITT-FALSE) or 32 (CRC-32/MPEG-2)
+#define CRC_WIDTH 16
+    
+//If defined, CRC_startHardware / CRC_updateHardware use the CRC module
+//Otherwise they fall back to the table-driven software CRC
+#define CRC_USE_HARDWARE
+    
+#if (CRC_WIDTH == 32)
+    
+    typedef uint32_t crc_t;
+    
+#define CRC_POLYNOMIAL 0x04C11DB7UL
+#define CRC_SEED 0xFFFFFFFFUL
+    
+#else
+    
+    typedef uint16_t crc_t;
+    
+#define CRC_POLYNOMIAL 0x1021
+#define CRC_SEED 0xFFFF
+    
+#endif
+    
+//Number of CRC bytes appended to a frame (sent MSB first)
+#define CRC_SIZE (CRC_WIDTH / 8)
+    
+//CRC of a frame including its appended CRC bytes
+#define CRC_RESIDUE 0
+    
+    //Adds a byte to a software CRC. Start with CRC_SEED
+    crc_t CRC_update(crc_t crc, uint8_t data);
+    
+    //Returns byte POS (0 = MSB) of a CRC, in the order it is sent
+    uint8_t CRC_getByte(crc_t crc, uint8_t pos);
+    
+    //Starts a new CRC on the CRC module with CRC_SEED
+    //Only one hardware CRC can run at a time
+    void CRC_startHardware(void);
+    
+    //Adds a byte to the hardware CRC
+    void CRC_updateHardware(uint8_t data);
+    
+    //Waits for the CRC module and returns the result
+    crc_t CRC_getHardware(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* CRC_H */
+
@@ -0,0 +1,201 @@
+#include "spi1_trace.h"
+#include "spi_config.h"
+#include "interrupts.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//The tick is 1 byte of the log header
+_Static_assert(SPI1_TRACE_TICK_US <= 0xFF, "SPI1_TRACE_TICK_US does not fit the log header");
+
+//Ring of records (head is the next record written)
+static SPI1_traceRecord_t ring[SPI1_TRACE_RECORDS];
+static uint8_t ringHead = 0, ringCount = 0;
+
+//Records overwritten before they were dumped
+static uint16_t lostRecords = 0;
+
+//Device ID stored with blocking transfers
+static uint8_t traceDevice = SPI1_TRACE_DEVICE_NONE;
+
+//Timer0 overflows since the ring was cleared (high half of the timestamps)
+static volatile uint16_t timerWraps = 0;
+
+//Returns the free-running Timer0 count
+static uint16_t SPI1_traceReadTimer(void)
+{
+    //TMR0H is latched when TMR0L is read
+    uint8_t low = TMR0L;
+    return ((uint16_t) TMR0H << 8) | low;
+}
+
+//Returns the 32-bit timestamp. Interrupts must be off
+static uint32_t SPI1_traceReadTime(void)
+{
+    uint16_t low = SPI1_traceReadTimer();
+    uint16_t high = timerWraps;
+    
+    if ((PIR3bits.TMR0IF) && (low < 0x8000))
+    {
+        //Timer0 overflowed, but the ISR has not run yet
+        high++;
+    }
+    
+    return ((uint32_t) high << 16) | low;
+}
+
+//Copies up to COUNT bytes of DATA, and clears the rest of the slot
+static void SPI1_traceCopy(uint8_t* slot, const uint8_t* data, uint16_t dataLen, uint8_t count)
+{
+    for (uint8_t i = 0; i < count; i++)
+    {
+        slot[i] = (i < dataLen) ? data[i] : 0x00;
+    }
+}
+
+//Clears the ring, and starts Timer0 if it is not running
+void SPI1_traceClear(void)
+{
+    if (!T0CON0bits.EN)
+    {
+        //Same timebase as the host timeouts
+        //16-bit, FOSC / 4, prescaler of spi_config.h
+        T0CON0 = 0x00;
+        T0CON1 = SPI_TIMER0_CON1_IMAGE;
+        T0CON0bits.MD16 = 1;
+        T0CON0bits.EN = 1;
+    }
+    
+    bool gie = INTCON0bits.GIE;
+    INTCON0bits.GIE = 0;
+    
+    ringHead = 0;
+    ringCount = 0;
+    lostRecords = 0;
+    
+    //Count overflows from now on. The flag may be left from the timeouts
+    timerWraps = 0;
+    PIR3bits.TMR0IF = 0;
+    PIE3bits.TMR0IE = 1;
+    
+    INTCON0bits.GIE = gie;
+}
+
+//Sets the device ID stored with blocking transfers
+void SPI1_traceSetDevice(uint8_t device)
+{
+    traceDevice = device;
+}
+
+//Returns the device ID stored with blocking transfers
+uint8_t SPI1_traceGetDevice(void)
+{
+    return traceDevice;
+}
+
+//Appends a record
+void SPI1_traceAdd(uint8_t flags, uint8_t device, const uint8_t* txData, uint16_t txLen, const uint8_t* rxData, uint16_t rxLen, uint16_t len)
+{
+    //Called from the main loop and ISRs
+    bool gie = INTCON0bits.GIE;
+    INTCON0bits.GIE = 0;
+    
+    SPI1_traceRecord_t* record = &ring[ringHead];
+    
+    record->timestamp = SPI1_traceReadTime();
+    record->flags = flags;
+    record->device = device;
+    record->len = len;
+    
+    if ((flags & (SPI1_TRACE_TX | SPI1_TRACE_RX)) == (SPI1_TRACE_TX | SPI1_TRACE_RX))
+    {
+        //First half sent, then first half received
+        SPI1_traceCopy(&record->data[0], txData, txLen, SPI1_TRACE_DATA_BYTES / 2);
+        SPI1_traceCopy(&record->data[SPI1_TRACE_DATA_BYTES / 2], rxData, rxLen, SPI1_TRACE_DATA_BYTES / 2);
+    }
+    else if (flags & SPI1_TRACE_RX)
+    {
+        SPI1_traceCopy(&record->data[0], rxData, rxLen, SPI1_TRACE_DATA_BYTES);
+    }
+    else
+    {
+        SPI1_traceCopy(&record->data[0], txData, (flags & SPI1_TRACE_TX) ? txLen : 0, SPI1_TRACE_DATA_BYTES);
+    }
+    
+    ringHead = (ringHead + 1) % SPI1_TRACE_RECORDS;
+    
+    if (ringCount < SPI1_TRACE_RECORDS)
+    {
+        ringCount++;
+    }
+    else if (lostRecords != 0xFFFF)
+    {
+        //Oldest record was overwritten
+        lostRecords++;
+    }
+    
+    INTCON0bits.GIE = gie;
+}
+
+//Returns the number of records in the ring
+uint8_t SPI1_traceGetCount(void)
+{
+    return ringCount;
+}
+
+//Writes the binary log through putChar
+void SPI1_traceDump(void (*putChar)(char))
+{
+    SPI1_traceRecord_t record;
+    
+    //Snapshot the ring position
+    bool gie = INTCON0bits.GIE;
+    INTCON0bits.GIE = 0;
+    uint8_t count = ringCount;
+    uint8_t index = (uint8_t) ((ringHead + SPI1_TRACE_RECORDS - count) % SPI1_TRACE_RECORDS);
+    uint16_t lost = lostRecords;
+    INTCON0bits.GIE = gie;
+    
+    putChar('S');
+    putChar('P');
+    putChar('T');
+    putChar('R');
+    putChar(SPI1_TRACE_VERSION);
+    putChar(SPI1_TRACE_DATA_BYTES);
+    putChar(SPI1_TRACE_TICK_US);
+    putChar((char) count);
+    putChar((char) (lost & 0xFF));
+    putChar((char) (lost >> 8));
+    
+    for (uint8_t i = 0; i < count; i++)
+    {
+        //Copy without being interrupted, then write
+        INTCON0bits.GIE = 0;
+        record = ring[index];
+        INTCON0bits.GIE = gie;
+        
+        putChar((char) (record.timestamp & 0xFF));
+        putChar((char) ((record.timestamp >> 8) & 0xFF));
+        putChar((char) ((record.timestamp >> 16) & 0xFF));
+        putChar((char) (record.timestamp >> 24));
+        putChar((char) record.flags);
+        putChar((char) record.device);
+        putChar((char) (record.len & 0xFF));
+        putChar((char) (record.len >> 8));
+        
+        for (uint8_t j = 0; j < SPI1_TRACE_DATA_BYTES; j++)
+        {
+            putChar((char) record.data[j]);
+        }
+        
+        index = (index + 1) % SPI1_TRACE_RECORDS;
+    }
+}
+
+void __interrupt(irq(TMR0), base(INTERRUPT_BASE)) SPI1_traceTimer_ISR(void)
+{
+    //Timer0 overflowed - the high half of the timestamps moves on
+    PIR3bits.TMR0IF = 0;
+    timerWraps++;
+}
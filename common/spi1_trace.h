@@ -0,0 +1,107 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_TRACE_H
+#define	SPI1_TRACE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include "spi_config.h"
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Bus transaction trace
+//Transactions are written to a RAM ring as compact records. The oldest
+//record is overwritten when the ring is full. SPI1_traceDump writes the
+//ring as a binary log, which is decoded by tools/spi_trace_decode.c
+    
+//Number of records in the ring (power of 2)
+#define SPI1_TRACE_RECORDS 16
+    
+//Data bytes stored per record. Exchanges store the first half sent and the
+//first half received
+#define SPI1_TRACE_DATA_BYTES 8
+    
+//Timestamp tick (Timer0, the same timebase as the host timeouts)
+//Timestamps are 32-bit: the Timer0 overflows counted by SPI1_traceTimer_ISR,
+//then the Timer0 count (4.7 hours before they wrap)
+#define SPI1_TRACE_TICK_US SPI_TIMER0_TICK_US
+    
+//Record flags (bits 0 - 3)
+#define SPI1_TRACE_TX 0x01              //Data was sent
+#define SPI1_TRACE_RX 0x02              //Data was received
+#define SPI1_TRACE_CLIENT 0x04          //Recorded by the client driver
+#define SPI1_TRACE_ASYNC 0x08           //Queued (interrupt driven) transfer
+    
+//Record status (bits 4 - 7)
+#define SPI1_TRACE_OK 0
+#define SPI1_TRACE_TIMEOUT 1
+#define SPI1_TRACE_CRC_ERROR 2
+#define SPI1_TRACE_RX_OVERFLOW 3
+#define SPI1_TRACE_TX_UNDERFLOW 4
+#define SPI1_TRACE_STATUS(status) ((uint8_t) ((status) << 4))
+    
+//Device ID when none is set
+#define SPI1_TRACE_DEVICE_NONE 0xFF
+    
+//Binary log - header, then the records from oldest to newest (16-bit values are little endian)
+//Header: 'S' 'P' 'T' 'R', version, SPI1_TRACE_DATA_BYTES, SPI1_TRACE_TICK_US, record count, lost records (16-bit)
+//Record: timestamp (32-bit), flags | status, device, len (16-bit), data
+#define SPI1_TRACE_VERSION 2
+    
+    //Trace record (8 + SPI1_TRACE_DATA_BYTES bytes)
+    typedef struct {
+        uint32_t timestamp;         //Timer0 overflows and count when the transaction ended
+        uint8_t flags;              //SPI1_TRACE_TX / RX / CLIENT / ASYNC and SPI1_TRACE_STATUS
+        uint8_t device;             //Chip select or device ID
+        uint16_t len;               //Bytes on the bus
+        uint8_t data[SPI1_TRACE_DATA_BYTES];
+    } SPI1_traceRecord_t;
+    
+    //Clears the ring, starts Timer0 if it is not running, and enables the
+    //Timer0 overflow interrupt (interrupts must be enabled for timestamps
+    //more than 1 overflow apart)
+    void SPI1_traceClear(void);
+    
+    //Sets the device ID stored with blocking transfers
+    void SPI1_traceSetDevice(uint8_t device);
+    
+    //Returns the device ID stored with blocking transfers
+    uint8_t SPI1_traceGetDevice(void);
+    
+    //Appends a record of a LEN byte transaction. txLen / rxLen are the bytes
+    //available in txData / rxData (0 if not used)
+    //Can be called from the main loop and from an ISR
+    void SPI1_traceAdd(uint8_t flags, uint8_t device, const uint8_t* txData, uint16_t txLen, const uint8_t* rxData, uint16_t rxLen, uint16_t len);
+    
+    //Returns the number of records in the ring
+    uint8_t SPI1_traceGetCount(void);
+    
+    //Writes the binary log through putChar. The ring is not cleared
+    void SPI1_traceDump(void (*putChar)(char));
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_TRACE_H */
+
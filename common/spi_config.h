@@ -0,0 +1,194 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI_CONFIG_H
+#define	SPI_CONFIG_H
+
+//SPI Driver Configuration
+//Register images are computed from these settings at compile time, so
+//SPIn_initHost / SPIn_initClient are a few whole-register stores
+//Invalid settings fail the build
+//Shared by the host, client and bridge projects. Whether a module is a host
+//or a client is set by the driver built for it, which picks the matching
+//SPIn_HOST_CON0_IMAGE or SPIn_CLIENT_CON0_IMAGE
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+//---- Image builders ----
+    
+//Port numbers, as used by the PPS input registers
+#define SPI_PORT_A 0
+#define SPI_PORT_B 1
+#define SPI_PORT_C 2
+    
+//Pins are given as PORT, BIT (e.g. C, 2)
+#define SPI_PIN_TRIS(pin) SPI_PIN_TRIS_(pin)
+#define SPI_PIN_TRIS_(port, bit) TRIS ## port ## bit
+#define SPI_PIN_ANSEL(pin) SPI_PIN_ANSEL_(pin)
+#define SPI_PIN_ANSEL_(port, bit) ANSEL ## port ## bit
+#define SPI_PIN_PPS(pin) SPI_PIN_PPS_(pin)
+#define SPI_PIN_PPS_(port, bit) R ## port ## bit ## PPS
+    
+//Value for a PPS input register (SPInSDIPPS, ...), also used to compare pins
+#define SPI_PIN_INPUT(pin) SPI_PIN_INPUT_(pin)
+#define SPI_PIN_INPUT_(port, bit) ((SPI_PORT_ ## port << 3) | (bit))
+    
+//SPInCON0 - EN, LSBF, MST, BMODE (widths other than 8 use Bit Mode)
+#define SPI_CON0_IMAGE(host, lsbFirst, width) \
+    (0x80 | ((lsbFirst) << 2) | ((host) << 1) | (((width) != 8) ? 0x01 : 0x00))
+    
+//SPInCON1 - SMP, CKE, CKP, SSP (SS is active low when SSP is set)
+#define SPI_CON1_IMAGE(mode, ssActiveHigh, smpEnd) \
+    (((smpEnd) << 7) | ((((mode) & 0x01) == 0) ? 0x40 : 0x00) | \
+    (((mode) >= 2) ? 0x20 : 0x00) | ((ssActiveHigh) ? 0x00 : 0x04))
+    
+//SCK = Source / (2 * (BAUD + 1)), rounded towards a slower SCK
+#define SPI_BAUD_DIVIDER(sourceHz, sckHz) \
+    (((sourceHz) + (2 * (sckHz)) - 1) / (2 * (sckHz)))
+#define SPI_BAUD_IMAGE(sourceHz, sckHz) (SPI_BAUD_DIVIDER(sourceHz, sckHz) - 1)
+    
+//SPInTWIDTH - 0 is 8 bits
+#define SPI_TWIDTH_IMAGE(width) ((width) & 0x07)
+    
+//Checks the settings of SPIn
+#define SPI_CHECK_CONFIG(n) \
+    _Static_assert((SPI ## n ## _CFG_MODE >= 0) && (SPI ## n ## _CFG_MODE <= 3), \
+        "SPI" #n "_CFG_MODE must be 0 to 3"); \
+    _Static_assert((SPI ## n ## _CFG_WIDTH >= 1) && (SPI ## n ## _CFG_WIDTH <= 8), \
+        "SPI" #n "_CFG_WIDTH must be 1 to 8 bits"); \
+    _Static_assert((SPI ## n ## _CFG_LSB_FIRST | \
+        SPI ## n ## _CFG_SS_ACTIVE_HIGH | SPI ## n ## _CFG_SMP_END) <= 1, \
+        "SPI" #n " on / off settings must be 0 or 1"); \
+    _Static_assert(SPI ## n ## _CFG_CLOCK <= 0x1F, \
+        "SPI" #n "_CFG_CLOCK is not a SPInCLK value"); \
+    _Static_assert((SPI ## n ## _CFG_SCK_HZ > 0) && \
+        (SPI ## n ## _CFG_SCK_HZ <= SPI ## n ## _CFG_CLOCK_HZ / 2), \
+        "SPI" #n "_CFG_SCK_HZ is faster than SPI" #n "_CFG_CLOCK_HZ / 2"); \
+    _Static_assert(SPI_BAUD_DIVIDER(SPI ## n ## _CFG_CLOCK_HZ, SPI ## n ## _CFG_SCK_HZ) <= 256, \
+        "SPI" #n "_CFG_SCK_HZ is too slow for SPI" #n "_CFG_CLOCK_HZ"); \
+    _Static_assert((SPI_PIN_INPUT(SPI ## n ## _CFG_SDO_PIN) != SPI_PIN_INPUT(SPI ## n ## _CFG_SDI_PIN)) && \
+        (SPI_PIN_INPUT(SPI ## n ## _CFG_SDO_PIN) != SPI_PIN_INPUT(SPI ## n ## _CFG_SCK_PIN)) && \
+        (SPI_PIN_INPUT(SPI ## n ## _CFG_SDO_PIN) != SPI_PIN_INPUT(SPI ## n ## _CFG_SS_PIN)) && \
+        (SPI_PIN_INPUT(SPI ## n ## _CFG_SDI_PIN) != SPI_PIN_INPUT(SPI ## n ## _CFG_SCK_PIN)) && \
+        (SPI_PIN_INPUT(SPI ## n ## _CFG_SDI_PIN) != SPI_PIN_INPUT(SPI ## n ## _CFG_SS_PIN)) && \
+        (SPI_PIN_INPUT(SPI ## n ## _CFG_SCK_PIN) != SPI_PIN_INPUT(SPI ## n ## _CFG_SS_PIN)), \
+        "SPI" #n " pins must all be different")
+    
+//---- Timer0 (transfer timeouts) ----
+    
+//System clock. Timer0 counts FOSC / 4
+#define SPI_FOSC_HZ 64000000UL
+    
+//Timer0 prescaler is 1:2^SPI_TIMER0_CKPS (T0CON1 CKPS)
+#define SPI_TIMER0_CKPS 6
+    
+//T0CON1 - FOSC / 4 source, synchronized, prescaler
+#define SPI_TIMER0_CON1_IMAGE (0x40 | SPI_TIMER0_CKPS)
+    
+//Length of a Timer0 tick (4 us at 64 MHz)
+#define SPI_TIMER0_TICK_US ((4UL << SPI_TIMER0_CKPS) * 1000000UL / SPI_FOSC_HZ)
+    
+_Static_assert(SPI_TIMER0_CKPS <= 15, "SPI_TIMER0_CKPS must be 0 to 15");
+_Static_assert((SPI_TIMER0_TICK_US != 0) && \
+    (((4UL << SPI_TIMER0_CKPS) * 1000000UL) % SPI_FOSC_HZ == 0), \
+    "Timer0 tick is not a whole number of us - change SPI_TIMER0_CKPS for SPI_FOSC_HZ");
+    
+//---- SPI1 ----
+    
+#define SPI1_CFG_MODE 1                 //SPI Mode (0 to 3)
+#define SPI1_CFG_WIDTH 8                //Bits per transfer (1 to 8)
+#define SPI1_CFG_LSB_FIRST 0
+#define SPI1_CFG_SS_ACTIVE_HIGH 0
+#define SPI1_CFG_SMP_END 0              //Sample SDI at the end of the bit
+    
+//SCK Source (SPInCLK) - HFINTOSC at 64 MHz
+#define SPI1_CFG_CLOCK 0x01
+#define SPI1_CFG_CLOCK_HZ 64000000UL
+    
+//Fastest SCK (1 MHz)
+#define SPI1_CFG_SCK_HZ 1000000UL
+    
+//Pins (PORT, BIT)
+#define SPI1_CFG_SDO_PIN C, 2
+#define SPI1_CFG_SDI_PIN C, 5
+#define SPI1_CFG_SCK_PIN C, 6
+#define SPI1_CFG_SS_PIN A, 5
+    
+//PPS output codes of SPI1
+#define SPI1_PPS_SCK 0x1D
+#define SPI1_PPS_SDO 0x1E
+#define SPI1_PPS_SS 0x1F
+    
+//Register images - EN is set in the CON0 images
+#define SPI1_HOST_CON0_IMAGE SPI_CON0_IMAGE(1, SPI1_CFG_LSB_FIRST, SPI1_CFG_WIDTH)
+#define SPI1_CLIENT_CON0_IMAGE SPI_CON0_IMAGE(0, SPI1_CFG_LSB_FIRST, SPI1_CFG_WIDTH)
+#define SPI1_CON1_IMAGE SPI_CON1_IMAGE(SPI1_CFG_MODE, SPI1_CFG_SS_ACTIVE_HIGH, SPI1_CFG_SMP_END)
+#define SPI1_CON2_IMAGE 0x00
+#define SPI1_CLK_IMAGE SPI1_CFG_CLOCK
+#define SPI1_BAUD_IMAGE SPI_BAUD_IMAGE(SPI1_CFG_CLOCK_HZ, SPI1_CFG_SCK_HZ)
+#define SPI1_TWIDTH_IMAGE SPI_TWIDTH_IMAGE(SPI1_CFG_WIDTH)
+    
+SPI_CHECK_CONFIG(1);
+    
+//---- SPI2 ----
+    
+#define SPI2_CFG_MODE 1                 //SPI Mode (0 to 3)
+#define SPI2_CFG_WIDTH 8                //Bits per transfer (1 to 8)
+#define SPI2_CFG_LSB_FIRST 0
+#define SPI2_CFG_SS_ACTIVE_HIGH 0
+#define SPI2_CFG_SMP_END 0              //Sample SDI at the end of the bit
+    
+//SCK Source (SPInCLK) - HFINTOSC at 64 MHz
+#define SPI2_CFG_CLOCK 0x01
+#define SPI2_CFG_CLOCK_HZ 64000000UL
+    
+//Fastest SCK (1 MHz)
+#define SPI2_CFG_SCK_HZ 1000000UL
+    
+//Pins (PORT, BIT)
+#define SPI2_CFG_SDO_PIN B, 2
+#define SPI2_CFG_SDI_PIN B, 3
+#define SPI2_CFG_SCK_PIN B, 1
+#define SPI2_CFG_SS_PIN B, 4
+    
+//PPS output codes of SPI2
+#define SPI2_PPS_SCK 0x20
+#define SPI2_PPS_SDO 0x21
+#define SPI2_PPS_SS 0x22
+    
+//Register images - EN is set in the CON0 images
+#define SPI2_HOST_CON0_IMAGE SPI_CON0_IMAGE(1, SPI2_CFG_LSB_FIRST, SPI2_CFG_WIDTH)
+#define SPI2_CLIENT_CON0_IMAGE SPI_CON0_IMAGE(0, SPI2_CFG_LSB_FIRST, SPI2_CFG_WIDTH)
+#define SPI2_CON1_IMAGE SPI_CON1_IMAGE(SPI2_CFG_MODE, SPI2_CFG_SS_ACTIVE_HIGH, SPI2_CFG_SMP_END)
+#define SPI2_CON2_IMAGE 0x00
+#define SPI2_CLK_IMAGE SPI2_CFG_CLOCK
+#define SPI2_BAUD_IMAGE SPI_BAUD_IMAGE(SPI2_CFG_CLOCK_HZ, SPI2_CFG_SCK_HZ)
+#define SPI2_TWIDTH_IMAGE SPI_TWIDTH_IMAGE(SPI2_CFG_WIDTH)
+    
+SPI_CHECK_CONFIG(2);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI_CONFIG_H */
+
@@ -0,0 +1,16 @@
+//Loopback byte handlers as callbacks, for test_fastpath.c without
+//SPI1_FAST_PATH. Built as device 1 firmware, so the calls cost CPU time
+
+#include "../spi-client.X/spi1_fastpath.h"
+
+#include <stdint.h>
+
+void Loopback_receive(uint8_t data)
+{
+    SPI1_fastRX(data);
+}
+
+uint8_t Loopback_transmit(void)
+{
+    return SPI1_fastTX();
+}
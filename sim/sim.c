@@ -0,0 +1,1727 @@
+//Register-level model of the PIC18F56Q71 peripherals used by the SPI drivers
+//See sim.h and the Host Tests section of README.md
+
+#define _GNU_SOURCE
+#include "sim.h"
+
+#include <ucontext.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+//SPIxCON0
+#define CON0_EN 0x80
+#define CON0_MST 0x02
+#define CON0_BMODE 0x01
+
+//SPIxCON1
+#define CON1_SSP 0x04
+
+//SPIxCON2
+#define CON2_BUSY 0x80
+#define CON2_SSET 0x04
+#define CON2_RXR 0x02
+#define CON2_TXR 0x01
+
+//SPIxSTATUS
+#define STATUS_TXWE 0x80
+#define STATUS_TXBE 0x20
+#define STATUS_CLRBF 0x04
+#define STATUS_RXBF 0x01
+
+//SPIxINTF / SPIxINTE
+#define INT_SRMT 0x80
+#define INT_TCZ 0x40
+#define INT_SOS 0x20
+#define INT_EOS 0x10
+#define INT_RXO 0x04
+#define INT_TXU 0x02
+
+//DMAnCON0 / DMAnCON1
+#define DMA_EN 0x80
+#define DMA_SIRQEN 0x40
+#define DMA_DGO 0x20
+#define DMA_DSTP 0x20
+#define DMA_SSTP 0x01
+
+//CRCCON0
+#define CRC_GO 0x40
+#define CRC_BUSY 0x20
+#define CRC_ACCM 0x10
+#define CRC_SHIFTM 0x02
+#define CRC_FULL 0x01
+
+//SPIxCLK sources
+#define CLK_MFINTOSC 2
+
+//Registers of SPI module N (0 = SPI1)
+#define SPI_STRIDE (SIM_R_SPI2CON0 - SIM_R_SPI1CON0)
+#define SPIREG(dev, n, reg) ((dev)->regs->r8[SIM_R_SPI1 ## reg + (n) * SPI_STRIDE])
+
+//Registers of port P (0 = PORTA)
+#define PORT_STRIDE (SIM_R_PORTB - SIM_R_PORTA)
+#define PORTREG(dev, p, reg) ((dev)->regs->r8[SIM_R_ ## reg ## A + (p) * PORT_STRIDE])
+#define PPSREG(dev, p, bit) ((dev)->regs->r8[SIM_R_RA0PPS + (p) * PORT_STRIDE + (bit)])
+
+//Memory of a device: DMA heap, then the registers
+#define SIM_BLOCK_SIZE 0x10000
+#define SIM_HEAP_SIZE 0xE000
+
+#define SIM_STACK_SIZE (1024 * 1024)
+#define SIM_MAX_REGIONS 16
+#define SIM_MAX_WATCH 4
+
+//A device may run this far ahead of the others before it yields
+#define SIM_QUANTUM 64
+
+//Longest CPU step while waiting, so interrupts are taken on time
+#define SIM_CPU_STEP 16
+
+#define NO_EVENT UINT64_MAX
+
+typedef struct {
+    uint8_t con0, con1, sirq, airq;
+    uint16_t ssz, scnt, dsa, dsz, dcnt, dptr;
+    uintptr_t ssa, sptr;
+} sim_dmaRegs_t;
+
+typedef struct {
+    uint8_t r8[SIM_R_COUNT];
+    uint16_t r16[SIM_W_COUNT];
+    sim_dmaRegs_t dma[SIM_DMA_CHANNELS];
+} sim_regs_t;
+
+//16-bit DMA addresses are offsets into this block
+typedef struct __attribute__((aligned(SIM_BLOCK_SIZE))) {
+    uint8_t heap[SIM_HEAP_SIZE];
+    sim_regs_t regs;
+} sim_block_t;
+
+_Static_assert(sizeof (sim_block_t) == SIM_BLOCK_SIZE, "Registers do not fit the device block");
+
+typedef struct {
+    uint8_t device;
+    uint8_t index;
+    
+    //FIFOs
+    uint8_t tx[2];
+    uint8_t txCount;
+    uint8_t rx[2];
+    uint8_t rxCount;
+    bool enabled;
+    
+    //Transfer counter, and the TCNTH value it is loaded with
+    uint16_t count;
+    uint8_t countHigh;
+    
+    //Byte on the wire (host)
+    bool busy;
+    uint64_t byteEnd;
+    uint32_t byteCycles;
+    uint8_t mosi;
+    uint8_t miso;
+    uint8_t bits;
+    
+    //Host side
+    sim_peer_t* peer;
+    uint8_t ssPort;
+    uint8_t ssBit;
+    bool ssOut;
+    
+    //Client side
+    sim_peer_t self;
+    bool selected;
+    uint8_t lastTX;
+    
+    //Frame clocked into the client by sim_driveFrame
+    bool driving;
+    uint8_t phase;
+    uint64_t next;
+    sim_frame_t frame;
+    uint16_t frameIndex;
+    uint8_t frameMOSI;
+    uint8_t frameMISO;
+    sim_frameTimes_t times;
+    
+    //Bus statistics (host)
+    sim_busStats_t stats;
+    bool haveLast;
+    
+    //Injected fault (host), active once faultAfter reaches zero
+    sim_fault_t fault;
+    uint32_t faultAfter;
+} sim_spi_t;
+
+typedef struct {
+    bool enabled;
+    bool active;
+    uint64_t nextAllowed;
+} sim_dma_t;
+
+typedef struct {
+    bool on;
+    uint32_t divider;
+    uint64_t base;
+    uint16_t start;
+    uint16_t last;
+    uint64_t wraps;                 //Overflows flagged since base
+} sim_timer_t;
+
+typedef struct {
+    sim_regs_t* regs;
+    uint8_t* heap;
+    size_t heapUsed;
+    
+    uint64_t time;
+    bool inISR;
+    bool started;
+    void (*vectors[SIM_IRQ_COUNT])(void);
+    uint32_t irqCount[SIM_IRQ_COUNT];
+    
+    ucontext_t context;
+    void* stack;
+    void (*main)(void);
+    
+    sim_spi_t spi[SIM_SPI_MODULES];
+    sim_dma_t dma[SIM_DMA_CHANNELS];
+    sim_timer_t tmr0;
+    sim_timer_t tmr1;
+    int8_t wires[SIM_PORTS][8];
+    
+} sim_device_t;
+
+typedef struct {
+    uint8_t device;
+    uint8_t port;
+    uint8_t bit;
+    uint8_t level;
+    uint32_t falls;
+} sim_watch_t;
+
+typedef struct {
+    uint8_t* base;
+    size_t size;
+} sim_region_t;
+
+//PIRx register and mask of each interrupt source
+static const struct {
+    uint8_t reg;
+    uint8_t mask;
+} irqBits[SIM_IRQ_COUNT] = {
+    {3, 0x02}, {3, 0x04}, {3, 0x08},
+    {7, 0x10}, {7, 0x20}, {7, 0x40},
+    {2, 0x02}, {2, 0x04},
+    {6, 0x02}, {6, 0x04},
+    {10, 0x02}, {10, 0x04},
+    {11, 0x02}, {11, 0x04},
+    {3, 0x80}, {3, 0x10}
+};
+
+static const uint8_t ssCodes[SIM_SPI_MODULES] = {SIM_PPS_SPI1_SS, SIM_PPS_SPI2_SS};
+
+sim_costs_t sim_costs = {
+    .access = 8,
+    .call = 16,
+    .isrEntry = 12,
+    .isrExit = 8,
+    .dmaByte = 8
+};
+
+static sim_block_t blocks[SIM_DEVICES];
+static sim_device_t devices[SIM_DEVICES];
+static sim_watch_t watches[SIM_MAX_WATCH];
+static uint8_t watchCount = 0;
+static sim_region_t regions[SIM_MAX_REGIONS];
+static uint8_t regionCount = 0;
+
+//Time the peripherals have been stepped to
+static uint64_t world = 0;
+
+//Device whose code is running
+static uint8_t current = 0;
+
+static bool initialized = false;
+
+static void sim_settle(void);
+static void sim_setFlag(sim_device_t* dev, sim_irq_t irq);
+
+static void sim_fail(const char* message)
+{
+    fprintf(stderr, "sim: %s\n", message);
+    abort();
+}
+
+/* ---------------------------------------------------------------- timers */
+
+static uint32_t sim_timer0Divider(sim_device_t* dev)
+{
+    uint8_t con1 = dev->regs->r8[SIM_R_T0CON1];
+    uint32_t prescale = 1UL << (con1 & 0x0F);
+    
+    //CS = 2 is FOSC / 4, CS = 3 is HFINTOSC (64 MHz)
+    return ((con1 >> 5) == 3) ? prescale : prescale * 4;
+}
+
+static uint32_t sim_timer1Divider(sim_device_t* dev)
+{
+    uint32_t prescale = 1UL << ((dev->regs->r8[SIM_R_T1CON] >> 4) & 0x03);
+    
+    //T1CLK = 2 is FOSC, anything else runs from FOSC / 4
+    return (dev->regs->r8[SIM_R_T1CLK] == 2) ? prescale : prescale * 4;
+}
+
+static uint16_t sim_timerValue(sim_timer_t* timer)
+{
+    if (!timer->on)
+    {
+        return timer->start;
+    }
+    return (uint16_t) (timer->start + (world - timer->base) / timer->divider);
+}
+
+//Follows the enable, the prescaler and writes made by the CPU
+static void sim_timerCommit(sim_timer_t* timer, bool on, uint32_t divider, uint16_t shadow)
+{
+    if (shadow != timer->last)
+    {
+        //Written by software
+        timer->start = shadow;
+        timer->base = world;
+        timer->wraps = 0;
+    }
+    else if ((on != timer->on) || (divider != timer->divider))
+    {
+        timer->start = sim_timerValue(timer);
+        timer->base = world;
+        timer->wraps = 0;
+    }
+    
+    timer->on = on;
+    timer->divider = divider;
+    timer->last = shadow;
+}
+
+static void sim_timersCommit(sim_device_t* dev)
+{
+    uint8_t* r8 = dev->regs->r8;
+    
+    //Timer 0 is only modelled in 16-bit mode
+    uint16_t tmr0 = r8[SIM_R_TMR0L] | ((uint16_t) r8[SIM_R_TMR0H] << 8);
+    sim_timerCommit(&dev->tmr0, (r8[SIM_R_T0CON0] & 0x80) != 0, sim_timer0Divider(dev), tmr0);
+    sim_timerCommit(&dev->tmr1, (r8[SIM_R_T1CON] & 0x01) != 0, sim_timer1Divider(dev), dev->regs->r16[SIM_W_TMR1]);
+}
+
+//Sets the interrupt flag of a timer that overflowed since the last update
+static void sim_timerOverflow(sim_device_t* dev, sim_timer_t* timer, sim_irq_t irq)
+{
+    if (!timer->on)
+    {
+        return;
+    }
+    
+    uint64_t wraps = (timer->start + (world - timer->base) / timer->divider) >> 16;
+    if (wraps != timer->wraps)
+    {
+        timer->wraps = wraps;
+        sim_setFlag(dev, irq);
+    }
+}
+
+static void sim_timersUpdate(sim_device_t* dev)
+{
+    sim_timerOverflow(dev, &dev->tmr0, SIM_IRQ_TMR0);
+    sim_timerOverflow(dev, &dev->tmr1, SIM_IRQ_TMR1);
+    
+    uint16_t tmr0 = sim_timerValue(&dev->tmr0);
+    dev->regs->r8[SIM_R_TMR0L] = tmr0 & 0xFF;
+    dev->regs->r8[SIM_R_TMR0H] = tmr0 >> 8;
+    dev->tmr0.last = tmr0;
+    
+    uint16_t tmr1 = sim_timerValue(&dev->tmr1);
+    dev->regs->r16[SIM_W_TMR1] = tmr1;
+    dev->tmr1.last = tmr1;
+}
+
+/* ---------------------------------------------------------------- CRC */
+
+static uint32_t sim_read32(uint8_t* r8, int low)
+{
+    return r8[low] | ((uint32_t) r8[low + 1] << 8) | ((uint32_t) r8[low + 2] << 16) | ((uint32_t) r8[low + 3] << 24);
+}
+
+//Shifts a data word into the accumulator (MSb first)
+static void sim_crcFeed(sim_device_t* dev, uint16_t data)
+{
+    uint8_t* r8 = dev->regs->r8;
+    
+    if (!(r8[SIM_R_CRCCON0] & 0x80) || !(r8[SIM_R_CRCCON0] & CRC_GO))
+    {
+        return;
+    }
+    
+    uint8_t width = (r8[SIM_R_CRCCON1] & 0x1F) + 1;
+    uint8_t dataBits = (r8[SIM_R_CRCCON2] & 0x1F) + 1;
+    uint32_t top = 1UL << (width - 1);
+    uint32_t mask = (width == 32) ? 0xFFFFFFFFUL : ((top << 1) - 1);
+    uint32_t poly = sim_read32(r8, SIM_R_CRCXORL) | 1;
+    uint32_t acc = sim_read32(r8, SIM_R_CRCACCL);
+    
+    for (int8_t i = dataBits - 1; i >= 0; i--)
+    {
+        uint8_t bit = (r8[SIM_R_CRCCON0] & CRC_SHIFTM) ? (data >> (dataBits - 1 - i)) & 1 : (data >> i) & 1;
+        
+        if (r8[SIM_R_CRCCON0] & CRC_ACCM)
+        {
+            //Augmented: the data is XORed in at the top
+            bool feedback = ((acc & top) != 0) ^ (bit != 0);
+            acc = (acc << 1) & mask;
+            if (feedback)
+            {
+                acc ^= poly;
+            }
+        }
+        else
+        {
+            bool feedback = (acc & top) != 0;
+            acc = ((acc << 1) | bit) & mask;
+            if (feedback)
+            {
+                acc ^= poly & mask;
+            }
+        }
+    }
+    
+    r8[SIM_R_CRCACCL] = acc & 0xFF;
+    r8[SIM_R_CRCACCH] = (acc >> 8) & 0xFF;
+    r8[SIM_R_CRCACCU] = (acc >> 16) & 0xFF;
+    r8[SIM_R_CRCACCT] = (acc >> 24) & 0xFF;
+}
+
+/* ---------------------------------------------------------------- pins */
+
+static bool sim_moduleSS(sim_device_t* dev, uint8_t n)
+{
+    uint8_t con0 = SPIREG(dev, n, CON0);
+    
+    if ((con0 & (CON0_EN | CON0_MST)) != (CON0_EN | CON0_MST))
+    {
+        return false;
+    }
+    
+    return (SPIREG(dev, n, CON2) & CON2_SSET) || (dev->spi[n].count != 0) || dev->spi[n].busy;
+}
+
+static uint8_t sim_pin(sim_device_t* dev, uint8_t port, uint8_t bit, bool followWire)
+{
+    if (PORTREG(dev, port, TRIS) & (1 << bit))
+    {
+        int8_t from = dev->wires[port][bit];
+        if (followWire && (from >= 0))
+        {
+            return sim_pin(dev, port, (uint8_t) from, false);
+        }
+        
+        //Pulled up
+        return 1;
+    }
+    
+    uint8_t pps = PPSREG(dev, port, bit);
+    for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+    {
+        if (pps == ssCodes[n])
+        {
+            bool activeLow = (SPIREG(dev, n, CON1) & CON1_SSP) != 0;
+            return (sim_moduleSS(dev, n) == activeLow) ? 0 : 1;
+        }
+    }
+    
+    return (PORTREG(dev, port, LAT) >> bit) & 1;
+}
+
+static void sim_watchUpdate(void)
+{
+    for (uint8_t i = 0; i < watchCount; i++)
+    {
+        sim_watch_t* watch = &watches[i];
+        uint8_t level = sim_pin(&devices[watch->device], watch->port, watch->bit, true);
+        
+        if ((watch->level == 1) && (level == 0))
+        {
+            watch->falls++;
+        }
+        watch->level = level;
+    }
+}
+
+/* ---------------------------------------------------------------- SPI */
+
+static uint32_t sim_bitCycles(sim_device_t* dev, uint8_t n)
+{
+    uint32_t cycles = 2UL * (SPIREG(dev, n, BAUD) + 1);
+    
+    if ((SPIREG(dev, n, CLK) & 0x0F) == CLK_MFINTOSC)
+    {
+        //500 kHz
+        cycles *= SIM_FOSC_HZ / 500000UL;
+    }
+    
+    return cycles;
+}
+
+static void sim_pushRX(sim_device_t* dev, uint8_t n, uint8_t data)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    
+    if (spi->rxCount < 2)
+    {
+        spi->rx[spi->rxCount++] = data;
+    }
+    else
+    {
+        SPIREG(dev, n, INTF) |= INT_RXO;
+    }
+}
+
+static uint8_t sim_popRX(sim_device_t* dev, uint8_t n)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    
+    if (spi->rxCount == 0)
+    {
+        return spi->rx[0];
+    }
+    
+    uint8_t data = spi->rx[0];
+    spi->rx[0] = spi->rx[1];
+    spi->rxCount--;
+    return data;
+}
+
+static void sim_pushTX(sim_device_t* dev, uint8_t n, uint8_t data)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    
+    if (spi->txCount < 2)
+    {
+        spi->tx[spi->txCount++] = data;
+    }
+    else
+    {
+        SPIREG(dev, n, STATUS) |= STATUS_TXWE;
+    }
+}
+
+static uint8_t sim_popTX(sim_spi_t* spi)
+{
+    uint8_t data = spi->tx[0];
+    spi->tx[0] = spi->tx[1];
+    spi->txCount--;
+    return data;
+}
+
+//Peer of a client module
+static void sim_clientSelect(sim_peer_t* peer, bool active)
+{
+    sim_spi_t* spi = (sim_spi_t*) peer->context;
+    sim_device_t* dev = &devices[spi->device];
+    uint8_t con0 = SPIREG(dev, spi->index, CON0);
+    
+    if ((con0 & CON0_EN) && !(con0 & CON0_MST) && (active != spi->selected))
+    {
+        SPIREG(dev, spi->index, INTF) |= active ? INT_SOS : INT_EOS;
+    }
+    spi->selected = active;
+}
+
+static bool sim_clientActive(sim_spi_t* spi)
+{
+    uint8_t con0 = SPIREG(&devices[spi->device], spi->index, CON0);
+    return (con0 & CON0_EN) && !(con0 & CON0_MST) && spi->selected;
+}
+
+static uint8_t sim_clientBegin(sim_peer_t* peer, uint8_t mosi, uint8_t bits)
+{
+    sim_spi_t* spi = (sim_spi_t*) peer->context;
+    sim_device_t* dev = &devices[spi->device];
+    
+    (void) mosi;
+    (void) bits;
+    
+    if (!sim_clientActive(spi))
+    {
+        return 0xFF;
+    }
+    
+    if (SPIREG(dev, spi->index, CON2) & CON2_TXR)
+    {
+        if (spi->txCount != 0)
+        {
+            spi->lastTX = sim_popTX(spi);
+        }
+        else
+        {
+            //The last byte is sent again
+            SPIREG(dev, spi->index, INTF) |= INT_TXU;
+        }
+    }
+    
+    return spi->lastTX;
+}
+
+static void sim_clientEnd(sim_peer_t* peer, uint8_t mosi, uint8_t bits)
+{
+    sim_spi_t* spi = (sim_spi_t*) peer->context;
+    sim_device_t* dev = &devices[spi->device];
+    
+    (void) bits;
+    
+    if (sim_clientActive(spi) && (SPIREG(dev, spi->index, CON2) & CON2_RXR))
+    {
+        sim_pushRX(dev, spi->index, mosi);
+    }
+}
+
+//Select state seen by the host module's peer
+static bool sim_hostSelected(sim_device_t* dev, uint8_t n)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    
+    if ((spi->peer == 0) || (spi->ssPort == SIM_SS_MODULE))
+    {
+        return sim_moduleSS(dev, n);
+    }
+    return sim_pin(dev, spi->ssPort, spi->ssBit, true) == 0;
+}
+
+//Returns true if FAULT was injected into the module and is due
+static bool sim_faultActive(const sim_spi_t* spi, sim_fault_t fault)
+{
+    return (spi->fault == fault) && (spi->faultAfter == 0);
+}
+
+static bool sim_hostCanStart(sim_device_t* dev, uint8_t n)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    uint8_t con2 = SPIREG(dev, n, CON2);
+    
+    if (spi->busy || !spi->enabled || !(SPIREG(dev, n, CON0) & CON0_MST) || (spi->count == 0))
+    {
+        return false;
+    }
+    if (!(con2 & (CON2_TXR | CON2_RXR)))
+    {
+        return false;
+    }
+    if ((con2 & CON2_TXR) && (spi->txCount == 0))
+    {
+        return false;
+    }
+    if ((con2 & CON2_RXR) && (spi->rxCount == 2))
+    {
+        return false;
+    }
+    return true;
+}
+
+static void sim_hostStart(sim_device_t* dev, uint8_t n)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    uint8_t width = SPIREG(dev, n, TWIDTH) & 0x07;
+    
+    spi->bits = ((SPIREG(dev, n, CON0) & CON0_BMODE) && (width != 0)) ? width : 8;
+    uint8_t mask = (uint8_t) (0xFF >> (8 - spi->bits));
+    
+    spi->mosi = (SPIREG(dev, n, CON2) & CON2_TXR) ? sim_popTX(spi) : 0x00;
+    spi->mosi &= mask;
+    spi->miso = (spi->peer != 0) ? spi->peer->begin(spi->peer, spi->mosi, spi->bits) : spi->mosi;
+    spi->miso &= mask;
+    
+    spi->byteCycles = spi->bits * sim_bitCycles(dev, n);
+    spi->byteEnd = world + spi->byteCycles;
+    spi->busy = true;
+    
+    if (sim_faultActive(spi, SIM_FAULT_STUCK_BUSY))
+    {
+        //SCK stops mid byte
+        spi->byteEnd = NO_EVENT;
+    }
+    
+    if (spi->stats.bytes == 0)
+    {
+        spi->stats.firstStart = world;
+    }
+    if (spi->haveLast && spi->ssOut)
+    {
+        uint64_t gap = world - spi->stats.lastEnd;
+        spi->stats.gapCycles += gap;
+        if (gap > spi->stats.maxGap)
+        {
+            spi->stats.maxGap = gap;
+        }
+    }
+}
+
+static void sim_hostEnd(sim_device_t* dev, uint8_t n)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    
+    spi->busy = false;
+    
+    if (spi->peer != 0)
+    {
+        spi->peer->end(spi->peer, spi->mosi, spi->bits);
+    }
+    
+    if (SPIREG(dev, n, CON2) & CON2_RXR)
+    {
+        sim_pushRX(dev, n, spi->miso);
+    }
+    
+    if (spi->count != 0)
+    {
+        spi->count--;
+        if ((spi->count == 0) && !sim_faultActive(spi, SIM_FAULT_STUCK_TCZIF))
+        {
+            SPIREG(dev, n, INTF) |= INT_TCZ;
+        }
+    }
+    
+    if ((spi->fault != SIM_FAULT_NONE) && (spi->faultAfter != 0))
+    {
+        spi->faultAfter--;
+    }
+    
+    if (spi->txCount == 0)
+    {
+        SPIREG(dev, n, INTF) |= INT_SRMT;
+    }
+    
+    spi->stats.bytes++;
+    spi->stats.busyCycles += spi->byteCycles;
+    spi->stats.lastEnd = world;
+    spi->haveLast = true;
+}
+
+static bool sim_spiSettle(sim_device_t* dev, uint8_t n)
+{
+    sim_spi_t* spi = &dev->spi[n];
+    bool changed = false;
+    
+    bool selected = sim_hostSelected(dev, n);
+    if (selected != spi->ssOut)
+    {
+        spi->ssOut = selected;
+        if (selected)
+        {
+            spi->stats.ssAsserts++;
+        }
+        else
+        {
+            spi->haveLast = false;
+        }
+        
+        if (spi->peer != 0)
+        {
+            spi->peer->select(spi->peer, selected);
+        }
+        changed = true;
+    }
+    
+    if (sim_hostCanStart(dev, n))
+    {
+        sim_hostStart(dev, n);
+        changed = true;
+    }
+    
+    return changed;
+}
+
+/* ---------------------------------------------------------------- frames clocked into a client */
+
+static void sim_driveStart(sim_spi_t* spi)
+{
+    const sim_frame_t* frame = &spi->frame;
+    
+    spi->frameMOSI = (frame->txData != 0) ? frame->txData[spi->frameIndex] : frame->txFill;
+    spi->frameMISO = sim_clientBegin(&spi->self, spi->frameMOSI, 8);
+    spi->next = world + 8UL * frame->bitCycles;
+    spi->phase = 2;
+}
+
+static void sim_driveStep(sim_spi_t* spi)
+{
+    const sim_frame_t* frame = &spi->frame;
+    
+    switch (spi->phase)
+    {
+        case 1:
+        case 3:
+            sim_driveStart(spi);
+            break;
+        case 2:
+            sim_clientEnd(&spi->self, spi->frameMOSI, 8);
+            if (frame->rxData != 0)
+            {
+                frame->rxData[spi->frameIndex] = spi->frameMISO;
+            }
+            if (spi->frameIndex < 16)
+            {
+                spi->times.byteEnd[spi->frameIndex] = world;
+            }
+            spi->frameIndex++;
+        
+            if (spi->frameIndex == frame->len)
+            {
+                spi->phase = 4;
+                spi->next = world + frame->ssLead;
+            }
+            else
+            {
+                spi->phase = 3;
+                spi->next = world + frame->byteGap;
+            }
+            break;
+        default:
+            sim_clientSelect(&spi->self, false);
+            spi->times.ssRelease = world;
+            spi->driving = false;
+            spi->phase = 0;
+            break;
+    }
+}
+
+/* ---------------------------------------------------------------- DMA */
+
+//Resolves a DMA address of a device. 16-bit addresses are offsets into the
+//device block, unless they fall into a registered region
+static uint8_t* sim_dmaResolve(sim_device_t* dev, uintptr_t address)
+{
+    uint8_t* block = (uint8_t*) &blocks[dev - devices];
+    
+    if (address > 0xFFFF)
+    {
+        return (uint8_t*) address;
+    }
+    
+    if (address >= SIM_HEAP_SIZE)
+    {
+        return block + address;
+    }
+    
+    for (uint8_t i = 0; i < regionCount; i++)
+    {
+        uint16_t offset = (uint16_t) (address - (uintptr_t) regions[i].base);
+        if (offset < regions[i].size)
+        {
+            return regions[i].base + offset;
+        }
+    }
+    
+    return block + address;
+}
+
+static uint8_t sim_dmaRead(sim_device_t* dev, uint8_t* source)
+{
+    for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+    {
+        if (source == &SPIREG(dev, n, RXB))
+        {
+            return sim_popRX(dev, n);
+        }
+    }
+    return *source;
+}
+
+static void sim_dmaWrite(sim_device_t* dev, uint8_t* destination, uint8_t data)
+{
+    for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+    {
+        if (destination == (uint8_t*) &dev->regs->r16[SIM_W_SPI1TXB + n])
+        {
+            sim_pushTX(dev, n, data);
+            return;
+        }
+    }
+    
+    if (destination == (uint8_t*) &dev->regs->r16[SIM_W_CRCDATAL])
+    {
+        sim_crcFeed(dev, data);
+        return;
+    }
+    
+    *destination = data;
+}
+
+static bool sim_dmaTrigger(sim_device_t* dev, uint8_t sirq)
+{
+    switch (sirq)
+    {
+        case SIM_SIRQ_SPI1RX:
+            return (dev->spi[0].rxCount != 0) && !sim_faultActive(&dev->spi[0], SIM_FAULT_STUCK_RXR);
+        case SIM_SIRQ_SPI1TX:
+            return dev->spi[0].txCount < 2;
+        case SIM_SIRQ_SPI2RX:
+            return (dev->spi[1].rxCount != 0) && !sim_faultActive(&dev->spi[1], SIM_FAULT_STUCK_RXR);
+        case SIM_SIRQ_SPI2TX:
+            return dev->spi[1].txCount < 2;
+        default:
+            return false;
+    }
+}
+
+static void sim_setFlag(sim_device_t* dev, sim_irq_t irq)
+{
+    dev->regs->r8[SIM_R_PIR0 + irqBits[irq].reg] |= irqBits[irq].mask;
+}
+
+//Moves one byte, and ends the message when a counter reloads
+static void sim_dmaMove(sim_device_t* dev, uint8_t channel)
+{
+    sim_dmaRegs_t* regs = &dev->regs->dma[channel];
+    sim_dma_t* dma = &dev->dma[channel];
+    
+    uint8_t data = sim_dmaRead(dev, sim_dmaResolve(dev, regs->sptr));
+    sim_dmaWrite(dev, sim_dmaResolve(dev, regs->dptr), data);
+    
+    uint8_t smode = (regs->con1 >> 1) & 0x03;
+    uint8_t dmode = (regs->con1 >> 6) & 0x03;
+    regs->sptr += (smode == 1) ? 1 : (smode == 2) ? -1 : 0;
+    regs->dptr += (dmode == 1) ? 1 : (dmode == 2) ? -1 : 0;
+    regs->scnt--;
+    regs->dcnt--;
+    
+    bool done = false;
+    
+    if (regs->scnt == 0)
+    {
+        regs->scnt = regs->ssz;
+        regs->sptr = regs->ssa;
+        sim_setFlag(dev, SIM_IRQ_DMA1SCNT + channel * 2);
+        if (regs->con1 & DMA_SSTP)
+        {
+            regs->con0 &= ~DMA_SIRQEN;
+        }
+        done = true;
+    }
+    
+    if (regs->dcnt == 0)
+    {
+        regs->dcnt = regs->dsz;
+        regs->dptr = regs->dsa;
+        sim_setFlag(dev, SIM_IRQ_DMA1DCNT + channel * 2);
+        if (regs->con1 & DMA_DSTP)
+        {
+            regs->con0 &= ~DMA_SIRQEN;
+        }
+        done = true;
+    }
+    
+    if (done)
+    {
+        dma->active = false;
+        regs->con0 &= ~DMA_DGO;
+    }
+    
+    dma->nextAllowed = world + sim_costs.dmaByte;
+}
+
+//Channels in arbiter order (lower DMAxPR first)
+static void sim_dmaOrder(sim_device_t* dev, uint8_t* order)
+{
+    for (uint8_t i = 0; i < SIM_DMA_CHANNELS; i++)
+    {
+        order[i] = i;
+    }
+    
+    for (uint8_t i = 1; i < SIM_DMA_CHANNELS; i++)
+    {
+        for (uint8_t j = i; (j > 0) && (dev->regs->r8[SIM_R_DMA1PR + order[j]] < dev->regs->r8[SIM_R_DMA1PR + order[j - 1]]); j--)
+        {
+            uint8_t swap = order[j];
+            order[j] = order[j - 1];
+            order[j - 1] = swap;
+        }
+    }
+}
+
+//Returns true if a channel is waiting to move a byte
+static bool sim_dmaReady(sim_device_t* dev, uint8_t channel)
+{
+    sim_dmaRegs_t* regs = &dev->regs->dma[channel];
+    sim_dma_t* dma = &dev->dma[channel];
+    
+    if (!(regs->con0 & DMA_EN) || !(dev->regs->r8[SIM_R_PRLOCK] & 0x01))
+    {
+        return false;
+    }
+    
+    if (!dma->active)
+    {
+        dma->active = (regs->con0 & DMA_DGO) || ((regs->con0 & DMA_SIRQEN) && sim_dmaTrigger(dev, regs->sirq));
+    }
+    return dma->active;
+}
+
+static bool sim_dmaSettle(sim_device_t* dev)
+{
+    uint8_t order[SIM_DMA_CHANNELS];
+    bool changed = false;
+    
+    sim_dmaOrder(dev, order);
+    
+    for (uint8_t i = 0; i < SIM_DMA_CHANNELS; i++)
+    {
+        uint8_t channel = order[i];
+        if (sim_dmaReady(dev, channel) && (dev->dma[channel].nextAllowed <= world))
+        {
+            sim_dmaMove(dev, channel);
+            changed = true;
+        }
+    }
+    
+    return changed;
+}
+
+/* ---------------------------------------------------------------- world */
+
+static void sim_flagsUpdate(sim_device_t* dev)
+{
+    uint8_t* r8 = dev->regs->r8;
+    
+    for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+    {
+        sim_spi_t* spi = &dev->spi[n];
+        uint8_t pir = SIM_R_PIR0 + irqBits[SIM_IRQ_SPI1RX + n * 3].reg;
+        uint8_t flags = r8[pir] & ~(irqBits[SIM_IRQ_SPI1RX + n * 3].mask | irqBits[SIM_IRQ_SPI1TX + n * 3].mask | irqBits[SIM_IRQ_SPI1 + n * 3].mask);
+        
+        if ((spi->rxCount != 0) && !sim_faultActive(spi, SIM_FAULT_STUCK_RXR))
+        {
+            flags |= irqBits[SIM_IRQ_SPI1RX + n * 3].mask;
+        }
+        if (spi->txCount < 2)
+        {
+            flags |= irqBits[SIM_IRQ_SPI1TX + n * 3].mask;
+        }
+        if (SPIREG(dev, n, INTF) & SPIREG(dev, n, INTE))
+        {
+            flags |= irqBits[SIM_IRQ_SPI1 + n * 3].mask;
+        }
+        r8[pir] = flags;
+        
+        uint8_t status = SPIREG(dev, n, STATUS) & ~(STATUS_TXBE | STATUS_RXBF);
+        if (spi->txCount == 0)
+        {
+            status |= STATUS_TXBE;
+        }
+        if (spi->rxCount == 2)
+        {
+            status |= STATUS_RXBF;
+        }
+        SPIREG(dev, n, STATUS) = status;
+        
+        if (spi->busy)
+        {
+            SPIREG(dev, n, CON2) |= CON2_BUSY;
+        }
+        else
+        {
+            SPIREG(dev, n, CON2) &= ~CON2_BUSY;
+        }
+    }
+    
+    //The CRC shifter is modelled as instant
+    r8[SIM_R_CRCCON0] &= ~(CRC_BUSY | CRC_FULL);
+}
+
+//Starts what the current state allows, until nothing changes
+static void sim_settle(void)
+{
+    bool changed;
+    
+    do
+    {
+        changed = false;
+        for (uint8_t d = 0; d < SIM_DEVICES; d++)
+        {
+            sim_device_t* dev = &devices[d];
+            for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+            {
+                changed |= sim_spiSettle(dev, n);
+            }
+            changed |= sim_dmaSettle(dev);
+        }
+    } while (changed);
+    
+    for (uint8_t d = 0; d < SIM_DEVICES; d++)
+    {
+        sim_flagsUpdate(&devices[d]);
+        sim_timersUpdate(&devices[d]);
+    }
+    sim_watchUpdate();
+}
+
+static uint64_t sim_nextEvent(void)
+{
+    uint64_t next = NO_EVENT;
+    
+    for (uint8_t d = 0; d < SIM_DEVICES; d++)
+    {
+        sim_device_t* dev = &devices[d];
+        for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+        {
+            sim_spi_t* spi = &dev->spi[n];
+            if (spi->busy && (spi->byteEnd < next))
+            {
+                next = spi->byteEnd;
+            }
+            if (spi->driving && (spi->next < next))
+            {
+                next = spi->next;
+            }
+        }
+        for (uint8_t c = 0; c < SIM_DMA_CHANNELS; c++)
+        {
+            if (sim_dmaReady(dev, c) && (dev->dma[c].nextAllowed < next))
+            {
+                next = dev->dma[c].nextAllowed;
+            }
+        }
+    }
+    
+    return next;
+}
+
+static void sim_processEvents(void)
+{
+    for (uint8_t d = 0; d < SIM_DEVICES; d++)
+    {
+        for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+        {
+            sim_spi_t* spi = &devices[d].spi[n];
+            if (spi->busy && (spi->byteEnd <= world))
+            {
+                sim_hostEnd(&devices[d], n);
+            }
+            if (spi->driving && (spi->next <= world))
+            {
+                sim_driveStep(spi);
+            }
+        }
+    }
+}
+
+//Steps the peripherals of every device up to TIME
+static void sim_stepTo(uint64_t time)
+{
+    for (;;)
+    {
+        sim_settle();
+        
+        uint64_t next = sim_nextEvent();
+        if ((next > time) || (next == NO_EVENT))
+        {
+            break;
+        }
+        if (next > world)
+        {
+            world = next;
+        }
+        sim_processEvents();
+    }
+    
+    if (time > world)
+    {
+        world = time;
+        sim_settle();
+    }
+}
+
+//Applies the side effects of register writes made since the last access
+static void sim_commit(sim_device_t* dev)
+{
+    sim_regs_t* regs = dev->regs;
+    
+    for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+    {
+        sim_spi_t* spi = &dev->spi[n];
+        bool enabled = (SPIREG(dev, n, CON0) & CON0_EN) != 0;
+        
+        if (SPIREG(dev, n, STATUS) & STATUS_CLRBF)
+        {
+            spi->txCount = 0;
+            spi->rxCount = 0;
+            SPIREG(dev, n, STATUS) &= ~STATUS_CLRBF;
+        }
+        
+        if (regs->r16[SIM_W_SPI1TXB + n] != SIM_NO_WRITE)
+        {
+            sim_pushTX(dev, n, (uint8_t) regs->r16[SIM_W_SPI1TXB + n]);
+            regs->r16[SIM_W_SPI1TXB + n] = SIM_NO_WRITE;
+        }
+        
+        if (regs->r16[SIM_W_SPI1TCNTH + n] != SIM_NO_WRITE)
+        {
+            //Held until TCNTL is written (3 bits)
+            spi->countHigh = regs->r16[SIM_W_SPI1TCNTH + n] & 0x07;
+            regs->r16[SIM_W_SPI1TCNTH + n] = SIM_NO_WRITE;
+        }
+        
+        if (regs->r16[SIM_W_SPI1TCNTL + n] != SIM_NO_WRITE)
+        {
+            spi->count = ((uint16_t) spi->countHigh << 8) | (regs->r16[SIM_W_SPI1TCNTL + n] & 0xFF);
+            regs->r16[SIM_W_SPI1TCNTL + n] = SIM_NO_WRITE;
+        }
+        
+        if (!enabled && spi->enabled)
+        {
+            //Disabling the module aborts the byte and the count, and clears
+            //an injected fault
+            spi->busy = false;
+            spi->count = 0;
+            spi->fault = SIM_FAULT_NONE;
+        }
+        spi->enabled = enabled;
+    }
+    
+    if (regs->r16[SIM_W_CRCDATAL] != SIM_NO_WRITE)
+    {
+        sim_crcFeed(dev, regs->r16[SIM_W_CRCDATAL]);
+        regs->r16[SIM_W_CRCDATAL] = SIM_NO_WRITE;
+    }
+    
+    for (uint8_t c = 0; c < SIM_DMA_CHANNELS; c++)
+    {
+        sim_dmaRegs_t* channel = &regs->dma[c];
+        bool enabled = (channel->con0 & DMA_EN) != 0;
+        
+        if (enabled && !dev->dma[c].enabled)
+        {
+            channel->sptr = channel->ssa;
+            channel->scnt = channel->ssz;
+            channel->dptr = channel->dsa;
+            channel->dcnt = channel->dsz;
+            dev->dma[c].active = false;
+            dev->dma[c].nextAllowed = world;
+        }
+        dev->dma[c].enabled = enabled;
+    }
+    
+    sim_timersCommit(dev);
+}
+
+static void sim_commitAll(void)
+{
+    for (uint8_t d = 0; d < SIM_DEVICES; d++)
+    {
+        sim_commit(&devices[d]);
+    }
+}
+
+/* ---------------------------------------------------------------- CPU */
+
+static void sim_init(void)
+{
+    if (!initialized)
+    {
+        initialized = true;
+        sim_reset();
+    }
+}
+
+static void sim_trampoline(void)
+{
+    sim_device_t* dev = &devices[current];
+    
+    if (dev->main != 0)
+    {
+        dev->main();
+    }
+    
+    for (;;)
+    {
+        sim_cpu(1000);
+    }
+}
+
+//Lets devices that are behind catch up
+static void sim_schedule(void)
+{
+    for (;;)
+    {
+        uint8_t next = current;
+        uint64_t earliest = devices[current].time;
+        
+        for (uint8_t d = 0; d < SIM_DEVICES; d++)
+        {
+            if ((d != current) && devices[d].started && (devices[d].time + SIM_QUANTUM < earliest))
+            {
+                next = d;
+                earliest = devices[d].time;
+            }
+        }
+        
+        if (next == current)
+        {
+            return;
+        }
+        
+        uint8_t from = current;
+        current = next;
+        swapcontext(&devices[from].context, &devices[next].context);
+    }
+}
+
+static void sim_dispatch(sim_device_t* dev)
+{
+    while (!dev->inISR && (dev->regs->r8[SIM_R_INTCON0] & 0x80))
+    {
+        sim_irq_t irq;
+        for (irq = 0; irq < SIM_IRQ_COUNT; irq++)
+        {
+            uint8_t mask = irqBits[irq].mask;
+            if (dev->regs->r8[SIM_R_PIR0 + irqBits[irq].reg] & dev->regs->r8[SIM_R_PIE0 + irqBits[irq].reg] & mask)
+            {
+                break;
+            }
+        }
+        
+        if (irq == SIM_IRQ_COUNT)
+        {
+            return;
+        }
+        
+        if (dev->vectors[irq] == 0)
+        {
+            sim_fail("interrupt enabled without a vector");
+        }
+        
+        dev->inISR = true;
+        dev->time += sim_costs.isrEntry;
+        dev->irqCount[irq]++;
+        dev->vectors[irq]();
+        dev->time += sim_costs.isrExit;
+        sim_commitAll();
+        sim_stepTo(dev->time);
+        dev->inISR = false;
+    }
+}
+
+//Runs CYCLES of CPU time on the current device
+static void sim_advance(uint32_t cycles)
+{
+    sim_device_t* dev = &devices[current];
+    
+    sim_commitAll();
+    dev->time += cycles;
+    sim_schedule();
+    
+    //The device may have changed time while others ran
+    dev = &devices[current];
+    sim_stepTo(dev->time);
+    sim_dispatch(dev);
+}
+
+static void sim_access(void)
+{
+    sim_init();
+    sim_advance(sim_costs.access);
+}
+
+volatile uint8_t* sim_reg8(int id)
+{
+    sim_access();
+    
+    sim_device_t* dev = &devices[current];
+    sim_regs_t* regs = dev->regs;
+    
+    if (id >= SIM_R_DMAnCON0)
+    {
+        sim_dmaRegs_t* channel = &regs->dma[regs->r8[SIM_R_DMASELECT] % SIM_DMA_CHANNELS];
+        switch (id)
+        {
+            case SIM_R_DMAnCON0:
+                return &channel->con0;
+            case SIM_R_DMAnCON1:
+                return &channel->con1;
+            case SIM_R_DMAnSIRQ:
+                return &channel->sirq;
+            default:
+                return &channel->airq;
+        }
+    }
+    
+    for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+    {
+        if (id == SIM_R_SPI1RXB + n * SPI_STRIDE)
+        {
+            //A read pops the FIFO. Writes to SPIxRXB are ignored by the model
+            regs->r8[id] = sim_popRX(dev, n);
+            sim_settle();
+            return &regs->r8[id];
+        }
+    }
+    
+    if ((id >= SIM_R_PORTA) && (id < SIM_R_PORTA + SIM_PORTS * PORT_STRIDE) && ((id - SIM_R_PORTA) % PORT_STRIDE == 0))
+    {
+        uint8_t port = (id - SIM_R_PORTA) / PORT_STRIDE;
+        uint8_t value = 0;
+        for (uint8_t bit = 0; bit < 8; bit++)
+        {
+            value |= sim_pin(dev, port, bit, true) << bit;
+        }
+        regs->r8[id] = value;
+    }
+    
+    return &regs->r8[id];
+}
+
+volatile uint16_t* sim_reg16(int id)
+{
+    sim_access();
+    
+    sim_regs_t* regs = devices[current].regs;
+    
+    if (id >= SIM_W_DMAnSSZ)
+    {
+        sim_dmaRegs_t* channel = &regs->dma[regs->r8[SIM_R_DMASELECT] % SIM_DMA_CHANNELS];
+        switch (id)
+        {
+            case SIM_W_DMAnSSZ:
+                return &channel->ssz;
+            case SIM_W_DMAnSCNT:
+                return &channel->scnt;
+            case SIM_W_DMAnDSA:
+                return &channel->dsa;
+            case SIM_W_DMAnDSZ:
+                return &channel->dsz;
+            case SIM_W_DMAnDCNT:
+                return &channel->dcnt;
+            default:
+                return &channel->dptr;
+        }
+    }
+    
+    return &regs->r16[id];
+}
+
+volatile uintptr_t* sim_regPtr(int id)
+{
+    sim_access();
+    
+    sim_regs_t* regs = devices[current].regs;
+    sim_dmaRegs_t* channel = &regs->dma[regs->r8[SIM_R_DMASELECT] % SIM_DMA_CHANNELS];
+    
+    return (id == SIM_P_DMAnSSA) ? &channel->ssa : &channel->sptr;
+}
+
+//Charges the call cost to functions built with -finstrument-functions
+void __cyg_profile_func_enter(void* function, void* caller) __attribute__((no_instrument_function));
+void __cyg_profile_func_exit(void* function, void* caller) __attribute__((no_instrument_function));
+
+void __cyg_profile_func_enter(void* function, void* caller)
+{
+    (void) function;
+    (void) caller;
+    devices[current].time += sim_costs.call;
+}
+
+void __cyg_profile_func_exit(void* function, void* caller)
+{
+    (void) function;
+    (void) caller;
+}
+
+/* ---------------------------------------------------------------- API */
+
+void sim_reset(void)
+{
+    initialized = true;
+    
+    if (current != 0)
+    {
+        sim_fail("sim_reset called from a started device");
+    }
+    
+    world = 0;
+    watchCount = 0;
+    
+    for (uint8_t d = 0; d < SIM_DEVICES; d++)
+    {
+        sim_device_t* dev = &devices[d];
+        sim_regs_t* regs = &blocks[d].regs;
+        
+        if (dev->stack != 0)
+        {
+            free(dev->stack);
+            dev->stack = 0;
+        }
+        
+        void (*vectors[SIM_IRQ_COUNT])(void);
+        memcpy(vectors, dev->vectors, sizeof (vectors));
+        memset(dev, 0, sizeof (*dev));
+        memcpy(dev->vectors, vectors, sizeof (vectors));
+        memset(regs, 0, sizeof (*regs));
+        
+        dev->regs = regs;
+        dev->heap = blocks[d].heap;
+        dev->started = (d == 0);
+        
+        for (uint8_t p = 0; p < SIM_PORTS; p++)
+        {
+            PORTREG(dev, p, TRIS) = 0xFF;
+            PORTREG(dev, p, ANSEL) = 0xFF;
+            for (uint8_t bit = 0; bit < 8; bit++)
+            {
+                dev->wires[p][bit] = -1;
+            }
+        }
+        
+        for (uint8_t n = 0; n < SIM_SPI_MODULES; n++)
+        {
+            sim_spi_t* spi = &dev->spi[n];
+            spi->device = d;
+            spi->index = n;
+            spi->self.select = sim_clientSelect;
+            spi->self.begin = sim_clientBegin;
+            spi->self.end = sim_clientEnd;
+            spi->self.context = spi;
+            regs->r16[SIM_W_SPI1TXB + n] = SIM_NO_WRITE;
+            regs->r16[SIM_W_SPI1TCNTL + n] = SIM_NO_WRITE;
+            regs->r16[SIM_W_SPI1TCNTH + n] = SIM_NO_WRITE;
+        }
+        
+        regs->r16[SIM_W_CRCDATAL] = SIM_NO_WRITE;
+        regs->r8[SIM_R_T0CON1] = 0x40;
+        dev->tmr0.divider = sim_timer0Divider(dev);
+        dev->tmr1.divider = sim_timer1Divider(dev);
+    }
+    
+    sim_settle();
+}
+
+void sim_cpu(uint32_t cycles)
+{
+    sim_init();
+    
+    while (cycles != 0)
+    {
+        uint32_t step = (cycles < SIM_CPU_STEP) ? cycles : SIM_CPU_STEP;
+        sim_advance(step);
+        cycles -= step;
+    }
+}
+
+bool sim_waitFor(bool (*condition)(void), uint32_t timeout)
+{
+    uint64_t start = sim_now();
+    
+    while (!condition())
+    {
+        if (sim_now() - start >= timeout)
+        {
+            return false;
+        }
+        sim_cpu(SIM_CPU_STEP);
+    }
+    return true;
+}
+
+uint64_t sim_now(void)
+{
+    sim_init();
+    return devices[current].time;
+}
+
+uint64_t sim_busTime(void)
+{
+    sim_init();
+    return world;
+}
+
+uint8_t sim_device(void)
+{
+    return current;
+}
+
+void sim_setVector(uint8_t device, sim_irq_t irq, void (*isr)(void))
+{
+    devices[device].vectors[irq] = isr;
+}
+
+void sim_start(uint8_t device, void (*main)(void))
+{
+    sim_device_t* dev = &devices[device];
+    
+    sim_init();
+    if ((device == 0) || dev->started)
+    {
+        sim_fail("device already running");
+    }
+    
+    dev->stack = malloc(SIM_STACK_SIZE);
+    if (dev->stack == 0)
+    {
+        sim_fail("out of memory");
+    }
+    
+    getcontext(&dev->context);
+    dev->context.uc_stack.ss_sp = dev->stack;
+    dev->context.uc_stack.ss_size = SIM_STACK_SIZE;
+    dev->context.uc_link = 0;
+    makecontext(&dev->context, sim_trampoline, 0);
+    
+    dev->main = main;
+    dev->time = devices[current].time;
+    dev->started = true;
+}
+
+void sim_attachPeer(uint8_t device, uint8_t spi, sim_peer_t* peer, uint8_t port, uint8_t bit)
+{
+    sim_init();
+    devices[device].spi[spi].peer = peer;
+    devices[device].spi[spi].ssPort = port;
+    devices[device].spi[spi].ssBit = bit;
+    devices[device].spi[spi].ssOut = false;
+    sim_settle();
+}
+
+void sim_link(uint8_t hostDevice, uint8_t hostSPI, uint8_t clientDevice, uint8_t clientSPI, uint8_t port, uint8_t bit)
+{
+    sim_init();
+    sim_attachPeer(hostDevice, hostSPI, &devices[clientDevice].spi[clientSPI].self, port, bit);
+}
+
+bool sim_driveFrame(uint8_t device, uint8_t spi, const sim_frame_t* frame)
+{
+    sim_spi_t* module = &devices[device].spi[spi];
+    
+    sim_init();
+    if (module->driving)
+    {
+        return false;
+    }
+    
+    //Catch the bus up with the caller
+    sim_advance(0);
+    
+    module->frame = *frame;
+    module->frameIndex = 0;
+    memset(&module->times, 0, sizeof (module->times));
+    module->times.ssAssert = world;
+    module->driving = true;
+    
+    sim_clientSelect(&module->self, true);
+    
+    if (frame->len == 0)
+    {
+        module->phase = 4;
+        module->next = world + frame->ssLead;
+    }
+    else
+    {
+        module->phase = 1;
+        module->next = world + frame->ssLead;
+    }
+    
+    sim_settle();
+    return true;
+}
+
+bool sim_isDriving(uint8_t device, uint8_t spi)
+{
+    return devices[device].spi[spi].driving;
+}
+
+void sim_getFrameTimes(uint8_t device, uint8_t spi, sim_frameTimes_t* times)
+{
+    *times = devices[device].spi[spi].times;
+}
+
+void sim_getBusStats(uint8_t device, uint8_t spi, sim_busStats_t* stats)
+{
+    *stats = devices[device].spi[spi].stats;
+}
+
+void sim_clearBusStats(uint8_t device, uint8_t spi)
+{
+    memset(&devices[device].spi[spi].stats, 0, sizeof (sim_busStats_t));
+    devices[device].spi[spi].haveLast = false;
+}
+
+void sim_setFault(uint8_t device, uint8_t spi, sim_fault_t fault, uint32_t after)
+{
+    devices[device].spi[spi].fault = fault;
+    devices[device].spi[spi].faultAfter = after;
+}
+
+void sim_wire(uint8_t device, uint8_t port, uint8_t fromBit, uint8_t toBit)
+{
+    sim_init();
+    devices[device].wires[port][toBit] = (int8_t) fromBit;
+}
+
+uint8_t sim_pinLevel(uint8_t device, uint8_t port, uint8_t bit)
+{
+    sim_init();
+    return sim_pin(&devices[device], port, bit, true);
+}
+
+void sim_watchPin(uint8_t device, uint8_t port, uint8_t bit)
+{
+    sim_init();
+    if (watchCount == SIM_MAX_WATCH)
+    {
+        sim_fail("too many watched pins");
+    }
+    
+    sim_watch_t* watch = &watches[watchCount++];
+    watch->device = device;
+    watch->port = port;
+    watch->bit = bit;
+    watch->level = sim_pin(&devices[device], port, bit, true);
+    watch->falls = 0;
+}
+
+uint32_t sim_getPinFalls(uint8_t device, uint8_t port, uint8_t bit)
+{
+    for (uint8_t i = 0; i < watchCount; i++)
+    {
+        if ((watches[i].device == device) && (watches[i].port == port) && (watches[i].bit == bit))
+        {
+            return watches[i].falls;
+        }
+    }
+    return 0;
+}
+
+void* sim_alloc(uint8_t device, size_t size)
+{
+    sim_device_t* dev = &devices[device];
+    
+    sim_init();
+    if (dev->heapUsed + size > SIM_HEAP_SIZE)
+    {
+        sim_fail("device heap is full");
+    }
+    
+    void* memory = &dev->heap[dev->heapUsed];
+    dev->heapUsed += (size + 3) & ~(size_t) 3;
+    memset(memory, 0, size);
+    return memory;
+}
+
+void sim_dmaRegion(void* base, size_t size)
+{
+    if (regionCount == SIM_MAX_REGIONS)
+    {
+        sim_fail("too many DMA regions");
+    }
+    regions[regionCount].base = (uint8_t*) base;
+    regions[regionCount].size = size;
+    regionCount++;
+}
+
+uint32_t sim_getIRQCount(uint8_t device, sim_irq_t irq)
+{
+    return devices[device].irqCount[irq];
+}
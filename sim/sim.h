@@ -0,0 +1,286 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SIM_H
+#define	SIM_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+    
+//Register-level model of the PIC18F56Q71 SPI, DMA, CRC, timer and port
+//peripherals, for building the drivers on a PC (see Host Tests in README.md)
+//
+//Every register access made by driver code goes through sim_reg8 / sim_reg16 /
+//sim_regPtr. Each access costs CPU time, commits the side effects of earlier
+//writes (TXB, CLRBF, EN, ...), steps the peripherals to the new time and runs
+//any pending interrupt. All times are in FOSC cycles (64 MHz)
+    
+//System clock of the model
+#define SIM_FOSC_HZ 64000000UL
+    
+//Devices (boards) in the model. Device 0 runs the test program
+#define SIM_DEVICES 2
+    
+//SPI modules per device
+#define SIM_SPI_MODULES 2
+    
+//DMA channels per device
+#define SIM_DMA_CHANNELS 4
+    
+//Ports per device (A to E)
+#define SIM_PORTS 5
+#define SIM_PORT_A 0
+#define SIM_PORT_B 1
+#define SIM_PORT_C 2
+#define SIM_PORT_D 3
+#define SIM_PORT_E 4
+    
+//8-bit registers
+#define SIM_SPI_REGS(n) \
+    SIM_R_SPI ## n ## CON0, SIM_R_SPI ## n ## CON1, SIM_R_SPI ## n ## CON2, SIM_R_SPI ## n ## STATUS, \
+    SIM_R_SPI ## n ## INTF, SIM_R_SPI ## n ## INTE, SIM_R_SPI ## n ## RXB, SIM_R_SPI ## n ## TWIDTH, \
+    SIM_R_SPI ## n ## CLK, SIM_R_SPI ## n ## BAUD, SIM_R_SPI ## n ## SDIPPS, SIM_R_SPI ## n ## SCKPPS, SIM_R_SPI ## n ## SSPPS
+    
+#define SIM_PORT_REGS(p) \
+    SIM_R_PORT ## p, SIM_R_LAT ## p, SIM_R_TRIS ## p, SIM_R_ANSEL ## p, \
+    SIM_R_R ## p ## 0PPS, SIM_R_R ## p ## 1PPS, SIM_R_R ## p ## 2PPS, SIM_R_R ## p ## 3PPS, \
+    SIM_R_R ## p ## 4PPS, SIM_R_R ## p ## 5PPS, SIM_R_R ## p ## 6PPS, SIM_R_R ## p ## 7PPS
+    
+    typedef enum {
+        SIM_SPI_REGS(1),
+        SIM_SPI_REGS(2),
+        SIM_PORT_REGS(A),
+        SIM_PORT_REGS(B),
+        SIM_PORT_REGS(C),
+        SIM_PORT_REGS(D),
+        SIM_PORT_REGS(E),
+        SIM_R_PIR0, SIM_R_PIR1, SIM_R_PIR2, SIM_R_PIR3, SIM_R_PIR4, SIM_R_PIR5, SIM_R_PIR6, SIM_R_PIR7,
+        SIM_R_PIR8, SIM_R_PIR9, SIM_R_PIR10, SIM_R_PIR11, SIM_R_PIR12, SIM_R_PIR13, SIM_R_PIR14, SIM_R_PIR15,
+        SIM_R_PIE0, SIM_R_PIE1, SIM_R_PIE2, SIM_R_PIE3, SIM_R_PIE4, SIM_R_PIE5, SIM_R_PIE6, SIM_R_PIE7,
+        SIM_R_PIE8, SIM_R_PIE9, SIM_R_PIE10, SIM_R_PIE11, SIM_R_PIE12, SIM_R_PIE13, SIM_R_PIE14, SIM_R_PIE15,
+        SIM_R_INTCON0, SIM_R_INTCON1, SIM_R_IVTLOCK, SIM_R_PRLOCK,
+        SIM_R_ISRPR, SIM_R_MAINPR, SIM_R_DMA1PR, SIM_R_DMA2PR, SIM_R_DMA3PR, SIM_R_DMA4PR, SIM_R_DMASELECT,
+        SIM_R_T0CON0, SIM_R_T0CON1, SIM_R_TMR0L, SIM_R_TMR0H, SIM_R_T1CON, SIM_R_T1CLK, SIM_R_T1GCON,
+        SIM_R_CRCCON0, SIM_R_CRCCON1, SIM_R_CRCCON2,
+        SIM_R_CRCXORL, SIM_R_CRCXORH, SIM_R_CRCXORU, SIM_R_CRCXORT,
+        SIM_R_CRCACCL, SIM_R_CRCACCH, SIM_R_CRCACCU, SIM_R_CRCACCT,
+        SIM_R_COUNT,
+        
+        //Registers of the channel selected by DMASELECT
+        SIM_R_DMAnCON0 = 0x100, SIM_R_DMAnCON1, SIM_R_DMAnSIRQ, SIM_R_DMAnAIRQ
+    } sim_reg8_t;
+    
+    //16-bit registers. Writes to the TXB, TCNTL, TCNTH and CRCDATAL slots are
+    //detected with a value no 8-bit write can produce, so these read back as
+    //SIM_NO_WRITE. The transfer count is loaded when TCNTL is written
+    typedef enum {
+        SIM_W_SPI1TXB, SIM_W_SPI2TXB, SIM_W_SPI1TCNTL, SIM_W_SPI2TCNTL, SIM_W_SPI1TCNTH, SIM_W_SPI2TCNTH,
+        SIM_W_CRCDATAL, SIM_W_TMR1, SIM_W_IVTBASE,
+        SIM_W_COUNT,
+        
+        //Registers of the channel selected by DMASELECT
+        SIM_W_DMAnSSZ = 0x100, SIM_W_DMAnSCNT, SIM_W_DMAnDSA, SIM_W_DMAnDSZ, SIM_W_DMAnDCNT, SIM_W_DMAnDPTR
+    } sim_reg16_t;
+    
+    //Pointer-sized registers (24-bit on the device)
+    typedef enum {
+        SIM_P_DMAnSSA = 0x100, SIM_P_DMAnSPTR
+    } sim_regPtr_t;
+    
+//Value of a write-detect slot when nothing was written
+#define SIM_NO_WRITE 0xFFFF
+    
+    //Interrupt sources, in vector (priority) order
+    typedef enum {
+        SIM_IRQ_SPI1RX = 0, SIM_IRQ_SPI1TX, SIM_IRQ_SPI1,
+        SIM_IRQ_SPI2RX, SIM_IRQ_SPI2TX, SIM_IRQ_SPI2,
+        SIM_IRQ_DMA1SCNT, SIM_IRQ_DMA1DCNT,
+        SIM_IRQ_DMA2SCNT, SIM_IRQ_DMA2DCNT,
+        SIM_IRQ_DMA3SCNT, SIM_IRQ_DMA3DCNT,
+        SIM_IRQ_DMA4SCNT, SIM_IRQ_DMA4DCNT,
+        SIM_IRQ_TMR0, SIM_IRQ_TMR1,
+        SIM_IRQ_COUNT
+    } sim_irq_t;
+    
+//DMA trigger sources (DMAnSIRQ values) - the vector numbers of the flags
+#define SIM_SIRQ_SPI1RX 0x18
+#define SIM_SIRQ_SPI1TX 0x19
+#define SIM_SIRQ_SPI2RX 0x48
+#define SIM_SIRQ_SPI2TX 0x49
+    
+//PPS output codes (RxyPPS values)
+#define SIM_PPS_SPI1_SCK 0x1D
+#define SIM_PPS_SPI1_SDO 0x1E
+#define SIM_PPS_SPI1_SS 0x1F
+#define SIM_PPS_SPI2_SCK 0x20
+#define SIM_PPS_SPI2_SDO 0x21
+#define SIM_PPS_SPI2_SS 0x22
+    
+    //Device on the other end of a host module. Called by the model as the bus moves
+    typedef struct sim_peer {
+        //SS was asserted (true) or released (false)
+        void (*select)(struct sim_peer* peer, bool active);
+        
+        //A byte of BITS bits starts. MOSI is the byte sent by the host
+        //Returns the byte sent back (MISO)
+        uint8_t (*begin)(struct sim_peer* peer, uint8_t mosi, uint8_t bits);
+        
+        //The byte has been clocked
+        void (*end)(struct sim_peer* peer, uint8_t mosi, uint8_t bits);
+        
+        //Free for the peer
+        void* context;
+    } sim_peer_t;
+    
+    //Frame clocked into a client module by the model (a host on the wire)
+    typedef struct {
+        const uint8_t* txData;      //Sent on MOSI (0 sends txFill)
+        uint8_t* rxData;            //MISO bytes are stored here (can be 0)
+        uint16_t len;
+        uint8_t txFill;
+        uint32_t bitCycles;         //One SCK period
+        uint32_t byteGap;           //Idle time between bytes
+        uint32_t ssLead;            //SS assert to the first edge, and last edge to SS release
+    } sim_frame_t;
+    
+    //Costs of the CPU model, in FOSC cycles
+    typedef struct {
+        uint16_t access;            //Each register access
+        uint16_t call;              //Each function call (instrumented sources only)
+        uint16_t isrEntry;          //Vectoring into an ISR
+        uint16_t isrExit;           //RETFIE
+        uint16_t dmaByte;           //Each byte moved by a DMA channel
+    } sim_costs_t;
+    
+    extern sim_costs_t sim_costs;
+    
+    //Register access, used by sim/xc.h
+    volatile uint8_t* sim_reg8(int id);
+    volatile uint16_t* sim_reg16(int id);
+    volatile uintptr_t* sim_regPtr(int id);
+    
+    //Resets every device, the bus and the time. Vectors and costs are kept
+    void sim_reset(void);
+    
+    //Runs the current device's CPU for CYCLES (busy-wait loops in tests)
+    void sim_cpu(uint32_t cycles);
+    
+    //Runs the current device's CPU until condition() is true or TIMEOUT cycles
+    //pass. Returns false on timeout
+    bool sim_waitFor(bool (*condition)(void), uint32_t timeout);
+    
+    //Time of the current device
+    uint64_t sim_now(void);
+    
+    //Time of the bus, which every device's peripherals are stepped to. Peer
+    //callbacks run at this time, which can be ahead of sim_now()
+    uint64_t sim_busTime(void);
+    
+    //Device the calling code runs on
+    uint8_t sim_device(void);
+    
+    //Sets the function run for an interrupt source of a device
+    void sim_setVector(uint8_t device, sim_irq_t irq, void (*isr)(void));
+    
+    //Starts firmware on another device. MAIN runs in its own context, in
+    //lockstep with the other devices. If MAIN returns, the device idles
+    //Pass 0 for a device that only runs interrupts
+    void sim_start(uint8_t device, void (*main)(void));
+    
+    //Connects a host module to a peer. SS is the module's SS output, or the pin
+    //PORT / BIT (active low) if port is not SIM_SS_MODULE
+#define SIM_SS_MODULE 0xFF
+    void sim_attachPeer(uint8_t device, uint8_t spi, sim_peer_t* peer, uint8_t port, uint8_t bit);
+    
+    //Connects a host module to a client module (on the same or another device)
+    void sim_link(uint8_t hostDevice, uint8_t hostSPI, uint8_t clientDevice, uint8_t clientSPI, uint8_t port, uint8_t bit);
+    
+    //Starts clocking a frame into a client module. Returns false if one is running
+    bool sim_driveFrame(uint8_t device, uint8_t spi, const sim_frame_t* frame);
+    
+    //Returns true while a frame is being clocked into the client module
+    bool sim_isDriving(uint8_t device, uint8_t spi);
+    
+    //Times of the last frame clocked by sim_driveFrame: SS asserted, each byte's
+    //last edge (up to 16 bytes), SS released
+    typedef struct {
+        uint64_t ssAssert;
+        uint64_t ssRelease;
+        uint64_t byteEnd[16];
+    } sim_frameTimes_t;
+    
+    void sim_getFrameTimes(uint8_t device, uint8_t spi, sim_frameTimes_t* times);
+    
+    //Counters of a host module's bus activity
+    typedef struct {
+        uint32_t bytes;             //Bytes clocked
+        uint32_t ssAsserts;         //Times SS was asserted
+        uint64_t busyCycles;        //Time spent clocking
+        uint64_t firstStart;        //Start of the first byte
+        uint64_t lastEnd;           //End of the last byte
+        uint64_t maxGap;            //Longest idle time between 2 bytes while SS was asserted
+        uint64_t gapCycles;         //Total idle time between bytes while SS was asserted
+    } sim_busStats_t;
+    
+    void sim_getBusStats(uint8_t device, uint8_t spi, sim_busStats_t* stats);
+    void sim_clearBusStats(uint8_t device, uint8_t spi);
+    
+    //Faults of a host module, for the timeout and recovery paths
+    typedef enum {
+        SIM_FAULT_NONE = 0,
+        SIM_FAULT_STUCK_BUSY,       //The byte on the wire never ends
+        SIM_FAULT_STUCK_TCZIF,      //The counter reaches zero without setting TCZIF
+        SIM_FAULT_STUCK_RXR         //RXIF stays low, the RX FIFO fills and the module stalls
+    } sim_fault_t;
+    
+    //Injects FAULT after AFTER more bytes are clocked by a host module. The
+    //fault holds until the module is disabled (SPIxCON0.EN = 0)
+    void sim_setFault(uint8_t device, uint8_t spi, sim_fault_t fault, uint32_t after);
+    
+    //Wires an input pin to an output pin of the same port (0 to 7)
+    void sim_wire(uint8_t device, uint8_t port, uint8_t fromBit, uint8_t toBit);
+    
+    //Returns the level of a pin: 1 if it is an input (pulled up)
+    uint8_t sim_pinLevel(uint8_t device, uint8_t port, uint8_t bit);
+    
+    //Counts the falling edges of a pin from now on (up to 4 pins)
+    void sim_watchPin(uint8_t device, uint8_t port, uint8_t bit);
+    uint32_t sim_getPinFalls(uint8_t device, uint8_t port, uint8_t bit);
+    
+    //Allocates DMA-visible memory of a device (16-bit DMA addresses are
+    //resolved within the device's 64 KB block)
+    void* sim_alloc(uint8_t device, size_t size);
+    
+    //Makes a static buffer visible to 16-bit DMA addresses
+    void sim_dmaRegion(void* base, size_t size);
+    
+    //Number of interrupts taken by a device, per source
+    uint32_t sim_getIRQCount(uint8_t device, sim_irq_t irq);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SIM_H */
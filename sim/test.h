@@ -0,0 +1,139 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SIM_TEST_H
+#define	SIM_TEST_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "sim.h"
+    
+//Minimal checks for the host tests. Each test is one program, run by make test
+    
+    static int testFailures = 0;
+    
+#define CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            printf("FAIL %s:%d: %s\n", __FILE__, __LINE__, #condition); \
+            testFailures++; \
+        } \
+    } while (0)
+
+#define CHECK_EQUAL(expected, actual) \
+    do { \
+        long long e_ = (long long) (expected), a_ = (long long) (actual); \
+        if (e_ != a_) { \
+            printf("FAIL %s:%d: %s is %lld, expected %lld\n", __FILE__, __LINE__, #actual, a_, e_); \
+            testFailures++; \
+        } \
+    } while (0)
+
+//Prints a measurement (kept in the test log)
+#define REPORT(...) \
+    do { \
+        printf("  "); \
+        printf(__VA_ARGS__); \
+        printf("\n"); \
+    } while (0)
+
+    //Peer that records the bytes it receives and answers with a pattern
+    //Byte i of a frame (counted from SS assert) is answered with testReply(i)
+    typedef struct {
+        sim_peer_t peer;
+        uint8_t* rx;                //Received bytes (can be 0)
+        uint16_t rxSize;
+        uint16_t count;             //Bytes of the current frame
+        uint16_t frames;            //SS assertions
+        bool selected;
+    } testPeer_t;
+    
+    static inline uint8_t testReply(uint16_t index)
+    {
+        return (uint8_t) (index * 7 + 3);
+    }
+    
+    static void testPeer_select(sim_peer_t* peer, bool active)
+    {
+        testPeer_t* test = (testPeer_t*) peer->context;
+        if (active)
+        {
+            test->count = 0;
+            test->frames++;
+        }
+        test->selected = active;
+    }
+    
+    static uint8_t testPeer_begin(sim_peer_t* peer, uint8_t mosi, uint8_t bits)
+    {
+        testPeer_t* test = (testPeer_t*) peer->context;
+        (void) mosi;
+        (void) bits;
+        return test->selected ? testReply(test->count) : 0xFF;
+    }
+    
+    static void testPeer_end(sim_peer_t* peer, uint8_t mosi, uint8_t bits)
+    {
+        testPeer_t* test = (testPeer_t*) peer->context;
+        (void) bits;
+        if (!test->selected)
+        {
+            return;
+        }
+        if ((test->rx != 0) && (test->count < test->rxSize))
+        {
+            test->rx[test->count] = mosi;
+        }
+        test->count++;
+    }
+    
+    //Connects a test peer to a host module of device 0, selected by the module's SS
+    static inline void testPeer_attach(testPeer_t* test, uint8_t spi, uint8_t* rx, uint16_t rxSize)
+    {
+        test->peer.select = testPeer_select;
+        test->peer.begin = testPeer_begin;
+        test->peer.end = testPeer_end;
+        test->peer.context = test;
+        test->rx = rx;
+        test->rxSize = rxSize;
+        test->count = 0;
+        test->frames = 0;
+        test->selected = false;
+        sim_attachPeer(0, spi, &test->peer, SIM_SS_MODULE, 0);
+    }
+    
+    //Prints the result, returns the exit code of the test
+    static inline int testResult(const char* name)
+    {
+        printf("%s: %s\n", name, (testFailures == 0) ? "PASS" : "FAIL");
+        return (testFailures == 0) ? 0 : 1;
+    }
+
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SIM_TEST_H */
@@ -0,0 +1,126 @@
+//Throughput benchmark (spi1_benchmark.c) run against the model, for lengths
+//1 to 4096 bytes. CPU time comes from the model's costs (sim_costs). The CSV
+//rows are written to BENCH_CSV and checked against the bus limits
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_host_dma.h"
+#include "spi1_benchmark.h"
+
+#include <string.h>
+
+//CSV output, kept to check the rows
+static char csv[64000];
+static uint16_t csvLen = 0;
+
+static void putChar(char c)
+{
+    if (csvLen < (sizeof (csv) - 1))
+    {
+        csv[csvLen++] = c;
+    }
+}
+
+//The benchmark buffer is private to spi1_benchmark.c. DMA starts are wrapped
+//(-Wl,--wrap) to make it visible to the 16-bit RX DMA address
+bool __real_SPI1_DMA_startExchange(uint8_t* txData, uint8_t* rxData, uint16_t len);
+
+bool __wrap_SPI1_DMA_startExchange(uint8_t* txData, uint8_t* rxData, uint16_t len)
+{
+    static bool mapped = false;
+    
+    if (!mapped)
+    {
+        sim_dmaRegion(rxData, SPI1_BENCH_MAX_LEN);
+        mapped = true;
+    }
+    return __real_SPI1_DMA_startExchange(txData, rxData, len);
+}
+
+int main(void)
+{
+    static testPeer_t peer;
+    
+    sim_reset();
+    testPeer_attach(&peer, 0, 0, 0);
+    SPI1_initHost();
+    SPI1_DMA_init();
+    
+    SPI1_runBenchmark(putChar);
+    csv[csvLen] = '\0';
+    
+    FILE* file = fopen(BENCH_CSV, "w");
+    CHECK(file != 0);
+    if (file != 0)
+    {
+        fputs(csv, file);
+        fclose(file);
+    }
+    
+    //Header, then 1 row per measurement
+    char* line = strtok(csv, "\r\n");
+    CHECK((line != 0) && (strncmp(line, "api,baud,sck_hz,len,", 20) == 0));
+    
+    uint16_t rows = 0, longRows = 0, dmaRows = 0;
+    unsigned long exchangeSlow = 0, exchangeFast = 0;
+    
+    while ((line = strtok(0, "\r\n")) != 0)
+    {
+        char api[32];
+        unsigned long baud, sck, len, cycles, rate, util, gap;
+        
+        if (sscanf(line, "%31[^,],%lu,%lu,%lu,%lu,%lu,%lu,%lu", api, &baud, &sck, &len, &cycles, &rate, &util, &gap) != 8)
+        {
+            printf("  bad row: %s\n", line);
+            CHECK(false);
+            continue;
+        }
+        rows++;
+        
+        //No function is faster than the bus, or keeps it busy more than all the time
+        CHECK(rate <= (sck / 8) + 1);
+        CHECK(util <= 100);
+        
+        if (strcmp(api, "DMA_exchange") == 0)
+        {
+            dmaRows++;
+            CHECK(len <= SPI1_DMA_MAX_LEN);
+        }
+        
+        if (len == 4096)
+        {
+            longRows++;
+            
+            if (strcmp(api, "exchangeBytes") == 0)
+            {
+                //Up to 4 MHz the loop keeps up: back to back bytes, the counter is topped up
+                if (baud >= 7)
+                {
+                    CHECK(util >= 95);
+                }
+                
+                if (baud == 31)
+                {
+                    exchangeSlow = rate;
+                }
+                else if (baud == 0)
+                {
+                    exchangeFast = rate;
+                }
+            }
+        }
+    }
+    
+    //exchangeBytes, sendBytes and receiveBytes reach 4096 bytes at all 5 SCK rates,
+    //even at 1 MHz where the run is longer than Timer1
+    CHECK_EQUAL(15, longRows);
+    
+    //1 to 2048 bytes at 5 SCK rates
+    CHECK_EQUAL(12 * 5, dmaRows);
+    
+    REPORT("%u CSV rows in %s, model costs: %u cycles per register access, %u per call, %u + %u per interrupt",
+           rows, BENCH_CSV, sim_costs.access, sim_costs.call, sim_costs.isrEntry, sim_costs.isrExit);
+    REPORT("exchangeBytes, 4096 bytes: %lu bytes/s at 1 MHz SCK, %lu bytes/s at 32 MHz SCK (CPU bound)", exchangeSlow, exchangeFast);
+    
+    return testResult("bench");
+}
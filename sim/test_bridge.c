@@ -0,0 +1,129 @@
+//SPI-to-SPI bridge (spi-bridge.X) built from the shared driver sources: frames
+//clocked into the upstream client come out of the downstream host, replies
+//return BRIDGE_REPLY_DELAY bytes later, the latency of each byte, and the end
+//of a frame that lost a byte downstream
+
+#include "test.h"
+#include "bridge.h"
+
+#include <string.h>
+
+#define LEN 16
+
+//Bridge firmware, renamed by the Makefile
+void dev1_Bridge_init(void);
+void dev1_Bridge_run(void);
+
+//Downstream device: the test peer, with the start time of each byte
+static testPeer_t peer;
+static uint8_t peerRX[64];
+static uint64_t byteStart[LEN];
+
+static uint8_t peerBegin(sim_peer_t* base, uint8_t mosi, uint8_t bits)
+{
+    if (peer.selected && (peer.count < LEN))
+    {
+        byteStart[peer.count] = sim_busTime();
+    }
+    return testPeer_begin(base, mosi, bits);
+}
+
+//Runs on device 1
+static void bridgeMain(void)
+{
+    dev1_Bridge_init();
+    dev1_Bridge_run();
+}
+
+//Clocks a frame into the bridge, then waits for it to settle
+static void frame(const uint8_t* tx, uint8_t* rx, uint16_t len, uint32_t bitCycles, uint32_t byteGap)
+{
+    sim_frame_t upstream = {tx, rx, len, 0x00, bitCycles, byteGap, 256};
+    CHECK(sim_driveFrame(1, 0, &upstream));
+    while (sim_isDriving(1, 0))
+    {
+        sim_cpu(100);
+    }
+    sim_cpu(20000);
+}
+
+int main(void)
+{
+    sim_reset();
+    
+    //Downstream device on SPI2 of the bridge
+    peer = (testPeer_t) {{testPeer_select, peerBegin, testPeer_end, &peer}, peerRX, sizeof (peerRX), 0, 0, false};
+    sim_attachPeer(1, 1, &peer.peer, SIM_SS_MODULE, 0);
+    sim_start(1, bridgeMain);
+    sim_cpu(5000);
+    
+    //1 MHz upstream, the client pins' SCK, with a byte time between bytes
+    uint8_t tx[LEN + BRIDGE_REPLY_DELAY], rx[LEN + BRIDGE_REPLY_DELAY];
+    for (uint8_t i = 0; i < sizeof (tx); i++)
+    {
+        tx[i] = (uint8_t) (0x30 + i);
+    }
+    memset(rx, 0xEE, sizeof (rx));
+    frame(tx, rx, sizeof (tx), 64, 512);
+    
+    //Every byte went downstream in one SS assertion
+    CHECK_EQUAL(1, peer.frames);
+    CHECK_EQUAL(sizeof (tx), peer.count);
+    CHECK(!peer.selected);
+    CHECK_EQUAL(0, memcmp(tx, peerRX, sizeof (tx)));
+    
+    //Fill bytes, then the downstream replies
+    for (uint8_t i = 0; i < BRIDGE_REPLY_DELAY; i++)
+    {
+        CHECK_EQUAL(BRIDGE_FILL, rx[i]);
+    }
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        CHECK_EQUAL(testReply(i), rx[BRIDGE_REPLY_DELAY + i]);
+    }
+    
+    //Latency of each byte: end of the upstream byte to the start of the
+    //downstream byte
+    sim_frameTimes_t times;
+    sim_getFrameTimes(1, 0, &times);
+    uint64_t minLatency = UINT64_MAX, maxLatency = 0, totalLatency = 0;
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        CHECK(byteStart[i] > times.byteEnd[i]);
+        uint64_t latency = byteStart[i] - times.byteEnd[i];
+        minLatency = (latency < minLatency) ? latency : minLatency;
+        maxLatency = (latency > maxLatency) ? latency : maxLatency;
+        totalLatency += latency;
+    }
+    
+    //Each byte goes downstream before the next one arrives upstream
+    CHECK(maxLatency < 512);
+    
+    REPORT("Byte latency (upstream byte end to downstream byte start): min %llu, max %llu, average %llu cycles (FOSC)",
+           (unsigned long long) minLatency, (unsigned long long) maxLatency,
+           (unsigned long long) (totalLatency / LEN));
+    
+    //Upstream too fast for the downstream bus (8 MHz, no gaps): bytes are
+    //lost downstream and never reply. The end of the frame times out
+    frame(tx, rx, sizeof (tx), 8, 0);
+    CHECK_EQUAL(2, peer.frames);
+    CHECK(peer.count < sizeof (tx));
+    CHECK(!peer.selected);
+    uint8_t lost = (uint8_t) (sizeof (tx) - peer.count);
+    
+    //The next frame is forwarded as before
+    memset(rx, 0xEE, sizeof (rx));
+    frame(tx, rx, sizeof (tx), 64, 512);
+    CHECK_EQUAL(3, peer.frames);
+    CHECK_EQUAL(sizeof (tx), peer.count);
+    CHECK_EQUAL(0, memcmp(tx, peerRX, sizeof (tx)));
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        CHECK_EQUAL(testReply(i), rx[BRIDGE_REPLY_DELAY + i]);
+    }
+    
+    REPORT("8 MHz upstream: %u of %u bytes lost downstream, frame ended by the drain timeout",
+           lost, (unsigned) sizeof (tx));
+    
+    return testResult("bridge");
+}
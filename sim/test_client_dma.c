@@ -0,0 +1,327 @@
+//DMA frame capture of the client (spi1_client_dma.c) with host firmware on
+//the other end: frames land in the capture buffer, a reply set from the frame
+//callback is sent once from its first byte in the next frame, the trace
+//records the length and bytes of each DMA frame, and back to back frames at
+//4 and 8 MHz SCK are captured and replied to without a byte lost
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_client.h"
+#include "spi1_client_dma.h"
+#include "spi1_trace.h"
+
+#include <string.h>
+
+#define FRAME_SIZE 32
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_initTrace(void);
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+void dev1_SPI1_traceTimer_ISR(void);
+void dev1_SPI1_DMA_initClient(void);
+bool dev1_SPI1_DMA_startCapture(uint8_t* rxBuffer, uint16_t rxSize, void (*frameCallback)(uint16_t));
+void dev1_SPI1_DMA_setReply(uint8_t* data, uint16_t len);
+void dev1_SPI1_traceDump(void (*putChar)(char));
+uint16_t dev1_SPI1_getRXOverflowCount(void);
+uint16_t dev1_SPI1_getTXUnderflowCount(void);
+
+//Buffers of device 1, reached through 16-bit DMA addresses
+static uint8_t* capture;
+static uint8_t* reply;
+
+//Frames seen by the callback
+static volatile uint8_t frames = 0;
+static uint16_t lastLen = 0;
+static uint8_t lastFrame[FRAME_SIZE];
+
+//Length and byte sum of each frame, by frame number
+static uint16_t frameLens[256];
+static uint16_t frameSums[256];
+
+//Trace dump requested by the test, written by the client main loop
+static volatile bool dumpRequest = false;
+static uint8_t dump[512];
+static uint16_t dumpLen = 0;
+
+//Error counters of the client, read by the client main loop
+static volatile bool countRequest = false;
+static uint16_t rxOverflows = 0;
+static uint16_t txUnderflows = 0;
+
+//Set to keep the reply the same from frame to frame
+static volatile bool holdReply = false;
+
+//Runs in the status ISR of device 1: each frame is the reply to the next one
+static void onFrame(uint16_t len)
+{
+    memcpy(lastFrame, capture, len);
+    lastLen = len;
+    
+    uint16_t sum = 0;
+    for (uint16_t i = 0; i < len; i++)
+    {
+        sum += capture[i];
+    }
+    frameLens[frames] = len;
+    frameSums[frames] = sum;
+    
+    if (!holdReply)
+    {
+        memcpy(reply, capture, len);
+        dev1_SPI1_DMA_setReply(reply, len);
+    }
+    frames++;
+}
+
+static void putChar(char c)
+{
+    if (dumpLen < sizeof (dump))
+    {
+        dump[dumpLen++] = (uint8_t) c;
+    }
+}
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_DMA_initClient();
+    dev1_SPI1_DMA_startCapture(capture, FRAME_SIZE, onFrame);
+    dev1_SPI1_initTrace();
+    dev1_Interrupts_enable();
+    
+    while (true)
+    {
+        if (dumpRequest)
+        {
+            dumpLen = 0;
+            dev1_SPI1_traceDump(putChar);
+            dumpRequest = false;
+        }
+        
+        if (countRequest)
+        {
+            rxOverflows = dev1_SPI1_getRXOverflowCount();
+            txUnderflows = dev1_SPI1_getTXUnderflowCount();
+            countRequest = false;
+        }
+        
+        sim_cpu(20);
+    }
+}
+
+static uint8_t expectedFrames = 0;
+
+static bool frameSeen(void)
+{
+    return frames == expectedFrames;
+}
+
+static bool dumpDone(void)
+{
+    return !dumpRequest;
+}
+
+
+//Runs one frame of LEN bytes of PATTERN
+static void frame(uint8_t pattern, uint8_t* rx, uint8_t len)
+{
+    uint8_t tx[FRAME_SIZE];
+    for (uint8_t i = 0; i < len; i++)
+    {
+        tx[i] = (uint8_t) (pattern + i);
+    }
+    
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, len));
+    
+    expectedFrames++;
+    CHECK(sim_waitFor(frameSeen, 100000));
+    CHECK_EQUAL(len, lastLen);
+    CHECK_EQUAL(0, memcmp(tx, lastFrame, len));
+    
+    //Time for the TX channel to preload the reply
+    sim_cpu(2000);
+}
+
+static bool countDone(void)
+{
+    return !countRequest;
+}
+
+//Reads the error counters of the client
+static void readCounts(void)
+{
+    countRequest = true;
+    CHECK(sim_waitFor(countDone, 100000));
+}
+
+//Pattern of back to back frame n
+static uint8_t streamByte(uint8_t n, uint8_t i)
+{
+    return (uint8_t) (n * 37 + i * 5 + 1);
+}
+
+#define STREAM_FRAMES 32
+
+//Runs STREAM_FRAMES full frames back to back at SCKHZ: each one is captured
+//whole, and answered with the same reply. A reply made from the frame before
+//would need a longer gap than the host leaves, for the callback to run
+static void stream(uint32_t sckHz)
+{
+    uint8_t tx[FRAME_SIZE], rx[FRAME_SIZE], sent[FRAME_SIZE];
+    
+    CHECK_EQUAL(sckHz, SPI1_setClockFrequency(sckHz, SIM_FOSC_HZ));
+    
+    //A full frame first: its bytes are the reply to every frame of the stream
+    frame(0xA5, rx, FRAME_SIZE);
+    for (uint8_t i = 0; i < FRAME_SIZE; i++)
+    {
+        sent[i] = (uint8_t) (0xA5 + i);
+    }
+    holdReply = true;
+    
+    readCounts();
+    uint16_t overflows = rxOverflows;
+    uint16_t underflows = txUnderflows;
+    uint8_t first = frames;
+    sim_clearBusStats(0, 0);
+    
+    //No wait between frames: the client re-arms the channels in the time the
+    //host takes to start the next one
+    bool replies = true;
+    for (uint8_t n = 0; n < STREAM_FRAMES; n++)
+    {
+        for (uint8_t i = 0; i < FRAME_SIZE; i++)
+        {
+            tx[i] = streamByte(n, i);
+        }
+        CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, FRAME_SIZE));
+        
+        if (memcmp(rx, sent, FRAME_SIZE) != 0)
+        {
+            printf("  %lu Hz, frame %u: reply differs\n", (unsigned long) sckHz, n);
+            replies = false;
+        }
+    }
+    CHECK(replies);
+    
+    expectedFrames = (uint8_t) (first + STREAM_FRAMES);
+    CHECK(sim_waitFor(frameSeen, 100000));
+    holdReply = false;
+    
+    //Every byte of every frame was captured
+    for (uint8_t n = 0; n < STREAM_FRAMES; n++)
+    {
+        uint16_t sum = 0;
+        for (uint8_t i = 0; i < FRAME_SIZE; i++)
+        {
+            sum += streamByte(n, i);
+        }
+        CHECK_EQUAL(FRAME_SIZE, frameLens[(uint8_t) (first + n)]);
+        CHECK_EQUAL(sum, frameSums[(uint8_t) (first + n)]);
+    }
+    
+    readCounts();
+    CHECK_EQUAL(overflows, rxOverflows);
+    CHECK_EQUAL(underflows, txUnderflows);
+    
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(STREAM_FRAMES * FRAME_SIZE, stats.bytes);
+    CHECK_EQUAL(STREAM_FRAMES, stats.ssAsserts);
+    
+    REPORT("%u back to back %u-byte frames at %lu MHz SCK: %lu bytes/s, no byte lost, no overflow or underflow",
+           STREAM_FRAMES, FRAME_SIZE, (unsigned long) (sckHz / 1000000),
+           (unsigned long) ((uint64_t) stats.bytes * SIM_FOSC_HZ / (stats.lastEnd - stats.firstStart)));
+}
+
+int main(void)
+{
+    sim_reset();
+    capture = sim_alloc(1, FRAME_SIZE);
+    reply = sim_alloc(1, FRAME_SIZE);
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_setVector(1, SIM_IRQ_TMR0, dev1_SPI1_traceTimer_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    sim_cpu(5000);
+    SPI1_initHost();
+    
+    //No reply yet: the fill byte is sent
+    uint8_t rx[FRAME_SIZE];
+    frame(0x10, rx, 6);
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        CHECK_EQUAL(SPI1_DMA_FILL, rx[i]);
+    }
+    
+    //Each reply, set from the callback, starts at its first byte and is not
+    //queued twice
+    const uint8_t lengths[] = {6, 9, 4, 12};
+    uint8_t pattern = 0x10;
+    for (uint8_t n = 1; n < sizeof (lengths); n++)
+    {
+        uint8_t next = (uint8_t) (0x40 + n * 0x20);
+        frame(next, rx, lengths[n]);
+        
+        //Past the end of the reply, the TX FIFO underflows
+        uint8_t count = (lengths[n] < lengths[n - 1]) ? lengths[n] : lengths[n - 1];
+        for (uint8_t i = 0; i < count; i++)
+        {
+            CHECK_EQUAL(pattern + i, rx[i]);
+        }
+        pattern = next;
+    }
+    
+    //The trace has a record per frame, with the DMA frame's length and bytes
+    dumpRequest = true;
+    CHECK(sim_waitFor(dumpDone, 1000000));
+    CHECK(dumpLen >= 10);
+    CHECK_EQUAL(sizeof (lengths), dump[7]);
+    
+    uint16_t recordSize = 8 + SPI1_TRACE_DATA_BYTES;
+    CHECK_EQUAL(10 + sizeof (lengths) * recordSize, dumpLen);
+    
+    pattern = 0x10;
+    for (uint8_t n = 0; n < sizeof (lengths); n++)
+    {
+        const uint8_t* record = &dump[10 + n * recordSize];
+        uint16_t len = record[6] | ((uint16_t) record[7] << 8);
+        CHECK_EQUAL(lengths[n], len);
+        CHECK_EQUAL(SPI1_TRACE_CLIENT | SPI1_TRACE_TX | SPI1_TRACE_RX, record[4] & 0x0F);
+        
+        //Received bytes in the second half of the data
+        uint8_t next = (n == 0) ? 0x10 : (uint8_t) (0x40 + n * 0x20);
+        for (uint8_t i = 0; i < SPI1_TRACE_DATA_BYTES / 2; i++)
+        {
+            CHECK_EQUAL(next + i, record[8 + SPI1_TRACE_DATA_BYTES / 2 + i]);
+        }
+        
+        //Sent bytes: the fill byte, then the last frame
+        for (uint8_t i = 0; i < SPI1_TRACE_DATA_BYTES / 2; i++)
+        {
+            uint8_t sent = (n == 0) ? SPI1_DMA_FILL : (uint8_t) (pattern + i);
+            CHECK_EQUAL(sent, record[8 + i]);
+        }
+        pattern = next;
+    }
+    
+    REPORT("%u DMA frames: replies set from the callback started at their first byte, traced with their length",
+           (unsigned) sizeof (lengths));
+    
+    stream(4000000UL);
+    stream(8000000UL);
+    
+    return testResult("client_dma");
+}
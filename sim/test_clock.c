@@ -0,0 +1,146 @@
+//SCK selection of the host (SPI1_computeClock / SPI1_setClockFrequency):
+//compared with a search of every source and BAUD value, then clocked on the
+//model from FOSC and from MFINTOSC
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <xc.h>
+#include <string.h>
+
+static const uint8_t sources[] = {SPI1_CLOCK_FOSC, SPI1_CLOCK_HFINTOSC, SPI1_CLOCK_MFINTOSC};
+
+static uint32_t sourceFrequency(uint8_t source, uint32_t foscHz)
+{
+    switch (source)
+    {
+        case SPI1_CLOCK_HFINTOSC:
+            return SPI1_HFINTOSC_HZ;
+        case SPI1_CLOCK_MFINTOSC:
+            return SPI1_MFINTOSC_HZ;
+        default:
+            return foscHz;
+    }
+}
+
+//Fastest SCK not above targetHz, by trying every setting
+//The exact SCK is compared with the target, the result is rounded down
+static uint32_t searchClock(uint32_t targetHz, uint32_t foscHz)
+{
+    uint32_t best = 0;
+    for (uint8_t i = 0; i < sizeof (sources); i++)
+    {
+        uint32_t sourceHz = sourceFrequency(sources[i], foscHz);
+        for (uint16_t baud = 0; baud < 256; baud++)
+        {
+            uint64_t divider = 2ULL * (baud + 1);
+            uint32_t sck = (uint32_t) (sourceHz / divider);
+            if ((sourceHz <= divider * targetHz) && (sck > best))
+            {
+                best = sck;
+            }
+        }
+    }
+    return best;
+}
+
+//Checks one target, returns false on a mismatch
+static bool checkTarget(uint32_t targetHz, uint32_t foscHz)
+{
+    SPI1_clock_t clock;
+    memset(&clock, 0xEE, sizeof (clock));
+    uint32_t achieved = SPI1_computeClock(targetHz, foscHz, &clock);
+    uint32_t expected = searchClock(targetHz, foscHz);
+    
+    if (achieved != expected)
+    {
+        printf("  %lu Hz (FOSC %lu): %lu, expected %lu\n", (unsigned long) targetHz,
+               (unsigned long) foscHz, (unsigned long) achieved, (unsigned long) expected);
+        return false;
+    }
+    
+    if (achieved != 0)
+    {
+        //The setting must give the frequency that was returned
+        uint32_t sourceHz = sourceFrequency(clock.clockSource, foscHz);
+        if (sourceHz / (2UL * (clock.baud + 1)) != achieved)
+        {
+            printf("  %lu Hz (FOSC %lu): source %u BAUD %u does not give %lu\n", (unsigned long) targetHz,
+                   (unsigned long) foscHz, clock.clockSource, clock.baud, (unsigned long) achieved);
+            return false;
+        }
+    }
+    return true;
+}
+
+//Time of one byte on the model, in FOSC cycles
+static uint64_t byteCycles(void)
+{
+    uint8_t data = 0x5A;
+    sim_clearBusStats(0, 0);
+    SPI1_exchangeBytes(&data, &data, 1);
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    return stats.busyCycles;
+}
+
+int main(void)
+{
+    const uint32_t foscs[] = {64000000UL, 48000000UL, 32000000UL, 1000000UL, 31000UL, 0};
+    uint32_t checked = 0;
+    
+    for (uint8_t f = 0; f < sizeof (foscs) / sizeof (foscs[0]); f++)
+    {
+        uint32_t foscHz = foscs[f];
+        
+        //Logarithmic sweep up to the largest target
+        for (uint64_t target = 1; target <= UINT32_MAX; target = target * 9 / 8 + 1)
+        {
+            CHECK(checkTarget((uint32_t) target, foscHz));
+            checked++;
+        }
+        CHECK(checkTarget(UINT32_MAX, foscHz));
+        CHECK(checkTarget(0x80000000UL, foscHz));
+        
+        //Either side of every setting
+        for (uint8_t i = 0; i < sizeof (sources); i++)
+        {
+            uint32_t sourceHz = sourceFrequency(sources[i], foscHz);
+            for (uint16_t baud = 0; baud < 256; baud++)
+            {
+                uint32_t sck = sourceHz / (2UL * (baud + 1));
+                for (int8_t delta = -1; delta <= 1; delta++)
+                {
+                    if ((sck + delta) != 0)
+                    {
+                        CHECK(checkTarget(sck + delta, foscHz));
+                        checked++;
+                    }
+                }
+            }
+        }
+    }
+    
+    //Targets of 0 and below the slowest SCK are rejected
+    SPI1_clock_t clock;
+    CHECK_EQUAL(0, SPI1_computeClock(0, 64000000UL, &clock));
+    CHECK_EQUAL(0, SPI1_computeClock(SPI1_MFINTOSC_HZ / 512 - 1, 64000000UL, &clock));
+    
+    //Settings applied to the model: 1 MHz from FOSC, 83.3 kHz from MFINTOSC
+    sim_reset();
+    SPI1_initHost();
+    
+    CHECK_EQUAL(1000000UL, SPI1_setClockFrequency(1000000UL, 64000000UL));
+    CHECK_EQUAL(SPI1_CLOCK_FOSC, SPI1CLK);
+    CHECK_EQUAL(31, SPI1BAUD);
+    CHECK_EQUAL(8 * 64, byteCycles());
+    
+    CHECK_EQUAL(83333UL, SPI1_setClockFrequency(100000UL, 64000000UL));
+    CHECK_EQUAL(SPI1_CLOCK_MFINTOSC, SPI1CLK);
+    CHECK_EQUAL(2, SPI1BAUD);
+    CHECK_EQUAL(8 * 6 * 128, byteCycles());
+    
+    REPORT("%lu targets checked against every source and BAUD value", (unsigned long) checked);
+    
+    return testResult("clock");
+}
@@ -0,0 +1,102 @@
+//Register images of the shared config (common/spi_config.h): the defaults
+//must build the values the drivers were written against, checked when this
+//file compiles, and the init functions of both projects must write them
+//to SPI1 and SPI2
+
+#include "test.h"
+#include "spi_config.h"
+#include "spi1_host.h"
+#include "spi2_host.h"
+
+#include <xc.h>
+
+//Mode 1, MSB first, 8 bits, active low SS, 1 MHz from HFINTOSC at 64 MHz
+_Static_assert(SPI1_HOST_CON0_IMAGE == 0x82, "SPI1 host CON0 image is not 0x82");
+_Static_assert(SPI1_CLIENT_CON0_IMAGE == 0x80, "SPI1 client CON0 image is not 0x80");
+_Static_assert(SPI1_CON1_IMAGE == 0x04, "SPI1 CON1 image is not 0x04");
+_Static_assert(SPI1_CON2_IMAGE == 0x00, "SPI1 CON2 image is not 0x00");
+_Static_assert(SPI1_CLK_IMAGE == 0x01, "SPI1 CLK image is not HFINTOSC");
+_Static_assert(SPI1_BAUD_IMAGE == 31, "SPI1 BAUD image is not 31");
+_Static_assert(SPI1_TWIDTH_IMAGE == 0, "SPI1 TWIDTH image is not 0");
+
+_Static_assert(SPI2_HOST_CON0_IMAGE == 0x82, "SPI2 host CON0 image is not 0x82");
+_Static_assert(SPI2_CLIENT_CON0_IMAGE == 0x80, "SPI2 client CON0 image is not 0x80");
+_Static_assert(SPI2_CON1_IMAGE == 0x04, "SPI2 CON1 image is not 0x04");
+_Static_assert(SPI2_CON2_IMAGE == 0x00, "SPI2 CON2 image is not 0x00");
+_Static_assert(SPI2_CLK_IMAGE == 0x01, "SPI2 CLK image is not HFINTOSC");
+_Static_assert(SPI2_BAUD_IMAGE == 31, "SPI2 BAUD image is not 31");
+_Static_assert(SPI2_TWIDTH_IMAGE == 0, "SPI2 TWIDTH image is not 0");
+
+//Image builders against the register layout
+_Static_assert(SPI_CON0_IMAGE(1, 1, 5) == 0x87, "CON0 image: LSBF, MST and BMODE");
+_Static_assert(SPI_CON1_IMAGE(0, 0, 0) == 0x44, "CON1 image: mode 0 sets CKE");
+_Static_assert(SPI_CON1_IMAGE(2, 0, 0) == 0x64, "CON1 image: mode 2 sets CKE and CKP");
+_Static_assert(SPI_CON1_IMAGE(3, 1, 1) == 0xA0, "CON1 image: mode 3, active high SS, SMP");
+_Static_assert(SPI_BAUD_IMAGE(64000000UL, 3000000UL) == 10, "BAUD image rounds towards a slower SCK");
+_Static_assert(SPI_TWIDTH_IMAGE(8) == 0, "TWIDTH image: 8 bits is 0");
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI2_initClient(void);
+
+//Registers of device 1 after the client init, copied by the client
+typedef struct {
+    uint8_t con0, con1, con2, clk, baud, twidth;
+} images_t;
+
+static images_t client1, client2;
+static volatile bool clientDone = false;
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI2_initClient();
+    
+    client1 = (images_t) {SPI1CON0, SPI1CON1, SPI1CON2, SPI1CLK, SPI1BAUD, SPI1TWIDTH};
+    client2 = (images_t) {SPI2CON0, SPI2CON1, SPI2CON2, SPI2CLK, SPI2BAUD, SPI2TWIDTH};
+    clientDone = true;
+    
+    while (true)
+    {
+        sim_cpu(20);
+    }
+}
+
+static bool clientInitialized(void)
+{
+    return clientDone;
+}
+
+static void checkImages(const images_t* images, uint8_t con0)
+{
+    CHECK_EQUAL(con0, images->con0);
+    CHECK_EQUAL(0x04, images->con1);
+    CHECK_EQUAL(0x00, images->con2);
+    CHECK_EQUAL(0x01, images->clk);
+    CHECK_EQUAL(31, images->baud);
+    CHECK_EQUAL(0, images->twidth);
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_start(1, clientMain);
+    
+    SPI1_initHost();
+    SPI2_initHost();
+    
+    images_t host1 = {SPI1CON0, SPI1CON1, SPI1CON2, SPI1CLK, SPI1BAUD, SPI1TWIDTH};
+    images_t host2 = {SPI2CON0, SPI2CON1, SPI2CON2, SPI2CLK, SPI2BAUD, SPI2TWIDTH};
+    checkImages(&host1, 0x82);
+    checkImages(&host2, 0x82);
+    
+    CHECK(sim_waitFor(clientInitialized, 100000));
+    checkImages(&client1, 0x80);
+    checkImages(&client2, 0x80);
+    
+    REPORT("Host CON0 0x%02X, client CON0 0x%02X, CON1 0x%02X, BAUD %u on SPI1 and SPI2",
+           host1.con0, client1.con0, host1.con1, host1.baud);
+    
+    return testResult("config");
+}
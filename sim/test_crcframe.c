@@ -0,0 +1,150 @@
+//CRC frames between the host (SPI1_exchangeFrame) and the client
+//(spi1_crcframe.c): data and CRC both ways, and lengths the host rejects
+//before anything is sent
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <string.h>
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI1_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI1_setStartHandler(void (*callback)(void));
+void dev1_SPI1_setStopHandler(void (*callback)(void));
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+
+void dev1_SPI1_initCRCFrames(void (*rxHandler)(uint8_t), void (*frameHandler)(bool));
+void dev1_SPI1_crcStartHandler(void);
+void dev1_SPI1_crcStopHandler(void);
+void dev1_SPI1_crcRXHandler(uint8_t data);
+uint8_t dev1_SPI1_crcTXHandler(void);
+void dev1_SPI1_setCRCReply(const uint8_t* data, uint8_t len);
+uint8_t dev1_SPI1_getCRCErrors(void);
+
+#define LEN 12
+
+//Data bytes of the last frame, and the results of the check
+static uint8_t clientRX[32];
+static volatile uint8_t clientRXCount = 0;
+static volatile uint8_t goodFrames = 0;
+static volatile uint8_t badFrames = 0;
+
+static uint8_t reply[LEN];
+static volatile bool replyRequest = false;
+
+static void clientData(uint8_t data)
+{
+    if (clientRXCount < sizeof (clientRX))
+    {
+        clientRX[clientRXCount] = data;
+    }
+    clientRXCount++;
+}
+
+static void clientFrame(bool valid)
+{
+    if (valid)
+    {
+        goodFrames++;
+    }
+    else
+    {
+        badFrames++;
+    }
+}
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_initCRCFrames(clientData, clientFrame);
+    dev1_SPI1_setTXHandler(dev1_SPI1_crcTXHandler);
+    dev1_SPI1_setRXHandler(dev1_SPI1_crcRXHandler);
+    dev1_SPI1_setStartHandler(dev1_SPI1_crcStartHandler);
+    dev1_SPI1_setStopHandler(dev1_SPI1_crcStopHandler);
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_enableInterrupts();
+    dev1_Interrupts_enable();
+    
+    while (true)
+    {
+        if (replyRequest)
+        {
+            dev1_SPI1_setCRCReply(reply, LEN);
+            replyRequest = false;
+        }
+        
+        sim_cpu(20);
+    }
+}
+
+static bool replySet(void)
+{
+    return !replyRequest;
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    sim_cpu(5000);
+    SPI1_initHost();
+    
+    uint8_t tx[LEN], rx[LEN];
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        tx[i] = (uint8_t) (0x30 + i);
+        reply[i] = (uint8_t) (0xB0 + i);
+    }
+    
+    //Both sides check the other's CRC
+    replyRequest = true;
+    CHECK(sim_waitFor(replySet, 100000));
+    sim_cpu(2000);
+    
+    memset(rx, 0, sizeof (rx));
+    clientRXCount = 0;
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeFrame(tx, rx, LEN));
+    sim_cpu(3000);
+    CHECK(memcmp(rx, reply, LEN) == 0);
+    CHECK_EQUAL(1, goodFrames);
+    CHECK_EQUAL(0, badFrames);
+    CHECK_EQUAL(LEN, clientRXCount);
+    CHECK(memcmp(clientRX, tx, LEN) == 0);
+    
+    //No reply: the host gets 0x00 without a CRC
+    CHECK_EQUAL(SPI1_CRC_ERROR, SPI1_exchangeFrame(tx, rx, 4));
+    sim_cpu(3000);
+    CHECK_EQUAL(2, goodFrames);
+    
+    //Lengths with no data byte or no room for the CRC are rejected, and
+    //txData is not read
+    sim_clearBusStats(0, 0);
+    CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_exchangeFrame(0, 0, 0));
+    CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_exchangeFrame(0, 0, UINT16_MAX));
+    sim_cpu(3000);
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(0, stats.bytes);
+    CHECK_EQUAL(0, stats.ssAsserts);
+    CHECK_EQUAL(2, goodFrames + badFrames);
+    CHECK_EQUAL(0, dev1_SPI1_getCRCErrors());
+    
+    REPORT("%u-byte CRC frames checked both ways, empty frames rejected", LEN);
+    
+    return testResult("crcframe");
+}
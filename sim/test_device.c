@@ -0,0 +1,97 @@
+//Device layer of the host (spi1_device.c): a hardware SS device and a GPIO SS
+//device on one bus. SS pins may not glitch when the hardware SS moves, and
+//only the registers that differ are written
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_device.h"
+
+#include <xc.h>
+#include <string.h>
+
+//Port numbers of the model
+#define PORT_A 0
+#define PORT_B 1
+
+static testPeer_t peer;
+static uint8_t peerRX[16];
+
+//Flash on RA5 (hardware SS, active low), ADC on RB0 (GPIO SS, active low)
+//Filled at run time: register addresses are not constants on the model
+static SPI1_device_t devices[3];
+
+static void initDevices(void)
+{
+    devices[0] = (SPI1_device_t) {SPI1_CON1_MODE0 | SPI1_CON1_SSP, {SPI1_CLOCK_FOSC, 31}, 0, SPI1_DEVICE_HW_SS, &RA5PPS, 0x20, &LATA};
+    devices[1] = (SPI1_device_t) {SPI1_CON1_MODE3, {SPI1_CLOCK_FOSC, 15}, 0, 0, &LATB, 0x01, 0};
+    devices[2] = (SPI1_device_t) {SPI1_CON1_MODE3, {SPI1_CLOCK_FOSC, 7}, 0, 0, &LATB, 0x01, 0};
+}
+
+static void transfer(uint8_t cs)
+{
+    uint8_t data[4] = {cs, 1, 2, 3};
+    SPI1_selectDevice(&devices[cs]);
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(data, data, sizeof (data)));
+    SPI1_deselectDevice();
+}
+
+//Cycles taken by SPI1_selectDevice
+static uint64_t selectCycles(uint8_t cs)
+{
+    uint64_t start = sim_now();
+    SPI1_selectDevice(&devices[cs]);
+    return sim_now() - start;
+}
+
+int main(void)
+{
+    sim_reset();
+    
+    //The peer is the flash, selected by RA5
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    sim_attachPeer(0, 0, &peer.peer, PORT_A, 5);
+    
+    SPI1_initHost();
+    initDevices();
+    
+    //SS pins are outputs and start idle
+    LATA |= 0x20;
+    LATB |= 0x01;
+    TRISA &= ~0x20;
+    TRISB &= ~0x01;
+    sim_watchPin(0, PORT_A, 5);
+    sim_watchPin(0, PORT_B, 0);
+    
+    //Alternate between the devices
+    transfer(0);
+    transfer(1);
+    transfer(0);
+    transfer(1);
+    transfer(2);
+    
+    //Only the flash transfers select the flash
+    CHECK_EQUAL(2, sim_getPinFalls(0, PORT_A, 5));
+    CHECK_EQUAL(2, peer.frames);
+    CHECK(peerRX[0] == 0);
+    CHECK_EQUAL(3, sim_getPinFalls(0, PORT_B, 0));
+    
+    //Both pins idle high
+    CHECK_EQUAL(1, sim_pinLevel(0, PORT_A, 5));
+    CHECK_EQUAL(1, sim_pinLevel(0, PORT_B, 0));
+    
+    //Settings of the last device are in place
+    CHECK_EQUAL(SPI1_CON1_MODE3, SPI1CON1);
+    CHECK_EQUAL(7, SPI1BAUD);
+    CHECK_EQUAL(0, RA5PPS);
+    
+    //Selection time with nothing, only BAUD, or everything to change
+    uint64_t same = selectCycles(2);
+    uint64_t baud = selectCycles(1);
+    uint64_t all = selectCycles(0);
+    SPI1_deselectDevice();
+    
+    REPORT("SPI1_selectDevice: %llu cycles (same settings), %llu (BAUD), %llu (mode, BAUD and SS)",
+           (unsigned long long) same, (unsigned long long) baud, (unsigned long long) all);
+    
+    return testResult("device");
+}
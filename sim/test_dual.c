@@ -0,0 +1,191 @@
+//Both SPI modules running at the same time: host firmware drives SPI1 in the
+//background and SPI2 blocking, and client firmware serves both from its own
+//interrupt handlers (spi1_client.c and the generated spi2_client.c ones)
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi2_host.h"
+#include "interrupts.h"
+
+#include <string.h>
+
+//Host vectors of spi1_host.c
+void SPI1_TX_ISR(void);
+void SPI1_RX_ISR(void);
+void SPI1_status_ISR(void);
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI1_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI1_setErrorHandler(void (*callback)(uint8_t));
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+
+void dev1_SPI2_initClient(void);
+void dev1_SPI2_enableTransmit(void);
+void dev1_SPI2_enableReceive(void);
+void dev1_SPI2_enableInterrupts(void);
+void dev1_SPI2_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI2_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI2_setStartHandler(void (*callback)(void));
+void dev1_SPI2_readTX_ISR(void);
+void dev1_SPI2_readRX_ISR(void);
+void dev1_SPI2_status_ISR(void);
+
+void dev1_Interrupts_enable(void);
+
+#define LEN 48
+
+//Client side of each module: bytes received, and a running count sent back
+typedef struct {
+    uint8_t rx[LEN];
+    volatile uint8_t rxCount;
+    uint8_t txNext;
+} clientSide_t;
+
+static clientSide_t client1, client2;
+static volatile uint8_t client2Frames = 0;
+static volatile uint8_t client1Errors = 0;
+
+static void receive1(uint8_t data)
+{
+    if (client1.rxCount < LEN)
+    {
+        client1.rx[client1.rxCount++] = data;
+    }
+}
+
+static uint8_t transmit1(void)
+{
+    return client1.txNext++;
+}
+
+static void error1(uint8_t flags)
+{
+    (void) flags;
+    client1Errors++;
+}
+
+static void receive2(uint8_t data)
+{
+    if (client2.rxCount < LEN)
+    {
+        client2.rx[client2.rxCount++] = data;
+    }
+}
+
+//SPI2 replies have the top bit set, so they can't be mistaken for SPI1 ones
+static uint8_t transmit2(void)
+{
+    return 0x80 | (client2.txNext++ & 0x7F);
+}
+
+static void start2(void)
+{
+    client2Frames++;
+}
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_setRXHandler(receive1);
+    dev1_SPI1_setTXHandler(transmit1);
+    dev1_SPI1_setErrorHandler(error1);
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_enableInterrupts();
+    
+    dev1_SPI2_initClient();
+    dev1_SPI2_setRXHandler(receive2);
+    dev1_SPI2_setTXHandler(transmit2);
+    dev1_SPI2_setStartHandler(start2);
+    dev1_SPI2_enableReceive();
+    dev1_SPI2_enableTransmit();
+    dev1_SPI2_enableInterrupts();
+    
+    dev1_Interrupts_enable();
+}
+
+static bool idle1(void)
+{
+    return !SPI1_isBusy();
+}
+
+//Host RX must be a count running through the frame, with bits MARK set
+static void checkCount(const uint8_t* rx, uint8_t mark, uint8_t mask)
+{
+    for (uint8_t i = 1; i < LEN; i++)
+    {
+        CHECK_EQUAL(mark | ((rx[0] + i) & mask), rx[i]);
+    }
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(0, SIM_IRQ_SPI1TX, SPI1_TX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1RX, SPI1_RX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1, SPI1_status_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_setVector(1, SIM_IRQ_SPI2TX, dev1_SPI2_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI2RX, dev1_SPI2_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI2, dev1_SPI2_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_link(0, 1, 1, 1, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    sim_cpu(5000);
+    SPI1_initHost();
+    SPI2_initHost();
+    Interrupts_enable();
+    
+    uint8_t tx1[LEN], rx1[LEN], tx2[LEN], rx2[LEN];
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        tx1[i] = (uint8_t) (0x10 + i);
+        tx2[i] = (uint8_t) (0xE0 - i);
+    }
+    memset(rx1, 0, sizeof (rx1));
+    memset(rx2, 0, sizeof (rx2));
+    
+    //SPI1 runs from its interrupts while SPI2 runs blocking
+    sim_clearBusStats(0, 0);
+    sim_clearBusStats(0, 1);
+    CHECK(SPI1_exchangeBytesAsync(tx1, rx1, LEN, 0));
+    CHECK_EQUAL(SPI2_OK, SPI2_exchangeBytes(tx2, rx2, LEN));
+    CHECK(sim_waitFor(idle1, 100000));
+    sim_cpu(3000);
+    
+    //The two frames overlapped on the buses
+    sim_busStats_t stats1, stats2;
+    sim_getBusStats(0, 0, &stats1);
+    sim_getBusStats(0, 1, &stats2);
+    CHECK_EQUAL(LEN, stats1.bytes);
+    CHECK_EQUAL(LEN, stats2.bytes);
+    CHECK((stats1.firstStart < stats2.lastEnd) && (stats2.firstStart < stats1.lastEnd));
+    
+    //Each client got its own host's bytes, and each host its own client's
+    CHECK_EQUAL(LEN, client1.rxCount);
+    CHECK(memcmp(client1.rx, tx1, LEN) == 0);
+    CHECK_EQUAL(LEN, client2.rxCount);
+    CHECK(memcmp(client2.rx, tx2, LEN) == 0);
+    CHECK_EQUAL(1, client2Frames);
+    CHECK_EQUAL(0, client1Errors);
+    checkCount(rx1, 0x00, 0xFF);
+    checkCount(rx2, 0x80, 0x7F);
+    CHECK((rx1[LEN - 1] & 0x80) == 0);
+    
+    uint64_t overlap = ((stats1.lastEnd < stats2.lastEnd) ? stats1.lastEnd : stats2.lastEnd)
+            - ((stats1.firstStart > stats2.firstStart) ? stats1.firstStart : stats2.firstStart);
+    REPORT("SPI1 and SPI2 frames of %u bytes overlapped for %llu cycles", LEN, (unsigned long long) overlap);
+    
+    return testResult("dual");
+}
@@ -0,0 +1,154 @@
+//Byte handlers of the client with and without SPI1_FAST_PATH. The Makefile
+//builds this test twice (fastpath and fastpath_calls). Both run the loopback
+//handlers of spi1_fastpath.h, as inline code or as callbacks, and report the
+//ISR cycles per byte and the fastest SCK the client keeps up with
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_client.h"
+
+#include <xc.h>
+#include <string.h>
+
+#ifdef SPI1_FAST_PATH
+#define MODE "fast path"
+#else
+#define MODE "callbacks"
+#endif
+
+#define LEN 32
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI1_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI1_initStats(void);
+void dev1_SPI1_getStats(SPI1_stats_t* stats);
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+void dev1_Loopback_receive(uint8_t data);
+uint8_t dev1_Loopback_transmit(void);
+
+//Requests to the client main loop
+static volatile bool statsRequest = false;
+static volatile bool clearRequest = false;
+static SPI1_stats_t stats;
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+#ifndef SPI1_FAST_PATH
+    dev1_SPI1_setRXHandler(dev1_Loopback_receive);
+    dev1_SPI1_setTXHandler(dev1_Loopback_transmit);
+#endif
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_initStats();
+    dev1_SPI1_enableInterrupts();
+    dev1_Interrupts_enable();
+    
+    while (true)
+    {
+        if (clearRequest)
+        {
+            dev1_SPI1_initStats();
+            clearRequest = false;
+        }
+        
+        if (statsRequest)
+        {
+            dev1_SPI1_getStats(&stats);
+            statsRequest = false;
+        }
+        
+        sim_cpu(20);
+    }
+}
+
+static bool requestsDone(void)
+{
+    return !statsRequest && !clearRequest;
+}
+
+//Runs one frame with cleared statistics. Returns true if no byte was lost
+//and the loopback data is right
+static bool frame(void)
+{
+    uint8_t tx[LEN], rx[LEN];
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        tx[i] = (uint8_t) (i * 5 + 1);
+    }
+    memset(rx, 0, sizeof (rx));
+    
+    clearRequest = true;
+    CHECK(sim_waitFor(requestsDone, 100000));
+    
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, LEN));
+    sim_cpu(3000);
+    
+    statsRequest = true;
+    CHECK(sim_waitFor(requestsDone, 100000));
+    
+    if ((stats.rxOverflows != 0) || (stats.txUnderflows != 0) || (stats.lastFrameBytes != LEN))
+    {
+        return false;
+    }
+    
+    //Each byte is sent back 3 bytes later (2 are queued in the TX FIFO)
+    for (uint8_t i = 3; i < LEN; i++)
+    {
+        if (rx[i] != tx[i - 3])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    sim_cpu(5000);
+    SPI1_initHost();
+    
+    //1 MHz SCK
+    CHECK(frame());
+    
+    //Timer1 counts FOSC / 4. Includes the start and stop ISRs of the frame
+    uint32_t cyclesPerByte = stats.totalISRCycles * 4 / LEN;
+    
+    //Fastest SCK at which no byte is lost
+    uint8_t fastest = 0xFF;
+    for (uint8_t baud = 31; baud != 0xFF; baud--)
+    {
+        SPI1BAUD = baud;
+        if (!frame())
+        {
+            break;
+        }
+        fastest = baud;
+    }
+    CHECK(fastest != 0xFF);
+    
+    REPORT("%s: %lu ISR cycles per byte, fastest SCK %lu Hz (BAUD %u)", MODE, (unsigned long) cyclesPerByte,
+           SIM_FOSC_HZ / (2UL * (fastest + 1)), fastest);
+    
+#ifdef SPI1_FAST_PATH
+    return testResult("fastpath");
+#else
+    return testResult("fastpath_calls");
+#endif
+}
@@ -0,0 +1,377 @@
+//Frame buffers of the client (spi1_frames.c) with host firmware on the other
+//end: a reply spread over several frames stays byte aligned, and a reply
+//queued after the TX FIFO was filled with 0x00 starts at the first byte.
+//Then a full ring and seeded random frames, with the main loop consuming at
+//random points: no frame is lost or corrupted, and every drop is counted
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_frames.h"
+
+#include <string.h>
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI1_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI1_setStartHandler(void (*callback)(void));
+void dev1_SPI1_setStopHandler(void (*callback)(void));
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+
+void dev1_SPI1_initFrames(void);
+void dev1_SPI1_frameStartHandler(void);
+void dev1_SPI1_frameStopHandler(void);
+void dev1_SPI1_frameRXHandler(uint8_t data);
+uint8_t dev1_SPI1_frameTXHandler(void);
+uint8_t* dev1_SPI1_getFrame(uint8_t* len);
+void dev1_SPI1_releaseFrame(void);
+uint8_t dev1_SPI1_queueReply(const uint8_t* data, uint8_t len);
+uint8_t dev1_SPI1_getDroppedFrames(void);
+uint8_t dev1_SPI1_getLongFrames(void);
+
+//Mailbox between the test (device 0) and the client main loop (device 1)
+static uint8_t reply[64];
+static volatile uint8_t replyLen = 0;
+static volatile uint8_t replyQueued = 0;
+
+//Frames collected by the client main loop, back to back
+static uint8_t clientRX[256];
+static volatile uint16_t clientRXCount = 0;
+static volatile uint8_t clientFrames = 0;
+
+//Length and sum of the bytes of each frame collected
+static uint8_t clientLen[256];
+static uint16_t clientSum[256];
+
+//While throttled, the client main loop only collects consumeBudget frames,
+//after waiting consumeDelay cycles
+static volatile bool throttled = false;
+static volatile uint8_t consumeBudget = 0;
+static volatile uint32_t consumeDelay = 0;
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_initFrames();
+    dev1_SPI1_setTXHandler(dev1_SPI1_frameTXHandler);
+    dev1_SPI1_setRXHandler(dev1_SPI1_frameRXHandler);
+    dev1_SPI1_setStartHandler(dev1_SPI1_frameStartHandler);
+    dev1_SPI1_setStopHandler(dev1_SPI1_frameStopHandler);
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_enableInterrupts();
+    dev1_Interrupts_enable();
+    
+    while (true)
+    {
+        if (replyLen != 0)
+        {
+            replyQueued = dev1_SPI1_queueReply(reply, replyLen);
+            replyLen = 0;
+        }
+        
+        if ((throttled) && (consumeBudget != 0) && (consumeDelay != 0))
+        {
+            //Interrupts keep receiving in the meantime
+            sim_cpu(consumeDelay);
+            consumeDelay = 0;
+        }
+        
+        uint8_t len;
+        uint8_t* frame = ((!throttled) || (consumeBudget != 0)) ? dev1_SPI1_getFrame(&len) : 0;
+        if (frame != 0)
+        {
+            uint16_t sum = 0;
+            for (uint8_t i = 0; i < len; i++)
+            {
+                sum += frame[i];
+                if (clientRXCount < sizeof (clientRX))
+                {
+                    clientRX[clientRXCount++] = frame[i];
+                }
+            }
+            clientLen[clientFrames] = len;
+            clientSum[clientFrames] = sum;
+            clientFrames++;
+            if (throttled)
+            {
+                consumeBudget--;
+            }
+            dev1_SPI1_releaseFrame();
+        }
+        
+        sim_cpu(20);
+    }
+}
+
+static bool replyTaken(void)
+{
+    return replyLen == 0;
+}
+
+static bool budgetUsed(void)
+{
+    return consumeBudget == 0;
+}
+
+static uint8_t expectedFrames = 0;
+
+static bool frameCollected(void)
+{
+    return clientFrames == expectedFrames;
+}
+
+//Hands LEN bytes of PATTERN to the client, returns the number queued
+static uint8_t queue(uint8_t pattern, uint8_t len)
+{
+    for (uint8_t i = 0; i < len; i++)
+    {
+        reply[i] = (uint8_t) (pattern + i);
+    }
+    replyLen = len;
+    CHECK(sim_waitFor(replyTaken, 100000));
+    
+    //Time for the client to reload its TX FIFO before the next frame
+    sim_cpu(2000);
+    return replyQueued;
+}
+
+//Runs one frame of LEN bytes. The host sends 0xC0 + the byte count so far
+static uint16_t hostTXCount = 0;
+
+static void frame(uint8_t* rx, uint8_t len)
+{
+    uint8_t tx[64];
+    for (uint8_t i = 0; i < len; i++)
+    {
+        tx[i] = (uint8_t) (0xC0 + hostTXCount++);
+    }
+    
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, len));
+    
+    expectedFrames++;
+    CHECK(sim_waitFor(frameCollected, 100000));
+}
+
+//Seeded, so a failure can be repeated
+#define SEED 0x5EED0007UL
+static uint32_t seed = SEED;
+
+static uint8_t random8(uint8_t range)
+{
+    seed = seed * 1103515245UL + 12345UL;
+    return (uint8_t) ((seed >> 16) % range);
+}
+
+//Sum of the frame sent by sendFrame
+static uint16_t frameSum(uint8_t first, uint8_t len)
+{
+    uint16_t sum = 0;
+    for (uint8_t i = 0; i < len; i++)
+    {
+        sum += (uint8_t) (first + i);
+    }
+    return sum;
+}
+
+//Runs one frame of LEN bytes, counting up from FIRST
+static void sendFrame(uint8_t first, uint8_t len)
+{
+    uint8_t tx[SPI1_FRAME_SIZE * 2], rx[SPI1_FRAME_SIZE * 2];
+    for (uint8_t i = 0; i < len; i++)
+    {
+        tx[i] = (uint8_t) (first + i);
+    }
+    
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, len));
+    
+    //Time for the stop handler
+    sim_cpu(2000);
+}
+
+//Lets the client main loop collect COUNT frames, and waits for them
+static void consume(uint8_t count)
+{
+    consumeBudget = count;
+    CHECK(sim_waitFor(budgetUsed, 100000));
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    //The client fills its TX FIFO with 0x00 before anything is queued
+    sim_cpu(5000);
+    SPI1_initHost();
+    
+    //Reply queued after the filler, read back in frames of different lengths
+    //Each frame must continue where the last one stopped
+    CHECK_EQUAL(40, queue(0x01, 40));
+    
+    const uint8_t lengths[] = {3, 1, 5, 2, 8, 4, 17};
+    uint8_t rx[64];
+    uint8_t next = 0x01;
+    for (uint8_t n = 0; n < sizeof (lengths); n++)
+    {
+        frame(rx, lengths[n]);
+        for (uint8_t i = 0; i < lengths[n]; i++)
+        {
+            CHECK_EQUAL(next, rx[i]);
+            next++;
+        }
+    }
+    CHECK_EQUAL(0x29, next);
+    
+    //Ring is empty: 0x00 is sent
+    frame(rx, 4);
+    for (uint8_t i = 0; i < 4; i++)
+    {
+        CHECK_EQUAL(0x00, rx[i]);
+    }
+    
+    //Reply queued after an empty frame starts at the first byte
+    CHECK_EQUAL(6, queue(0x80, 6));
+    frame(rx, 6);
+    for (uint8_t i = 0; i < 6; i++)
+    {
+        CHECK_EQUAL(0x80 + i, rx[i]);
+    }
+    
+    //A reply longer than the ring is cut, 2 slots are kept free
+    CHECK_EQUAL(SPI1_TX_RING_SIZE - 2, queue(0x40, sizeof (reply)));
+    frame(rx, 2);
+    CHECK_EQUAL(0x40, rx[0]);
+    CHECK_EQUAL(0x41, rx[1]);
+    frame(rx, 60);
+    for (uint8_t i = 0; i < 60; i++)
+    {
+        CHECK_EQUAL(0x42 + i, rx[i]);
+    }
+    
+    //Client received every host byte, in order, with no frames dropped
+    CHECK_EQUAL(0, dev1_SPI1_getDroppedFrames());
+    CHECK_EQUAL(hostTXCount, clientRXCount);
+    for (uint16_t i = 0; i < clientRXCount; i++)
+    {
+        CHECK_EQUAL((uint8_t) (0xC0 + i), clientRX[i]);
+    }
+    
+    REPORT("%u frames, %u bytes: replies stayed byte aligned", expectedFrames, hostTXCount);
+    
+    //Full ring: the main loop stops collecting, and every slot is filled
+    throttled = true;
+    clientFrames = 0;
+    for (uint8_t n = 0; n < SPI1_FRAME_COUNT; n++)
+    {
+        sendFrame(0x10 * n, 8);
+    }
+    
+    //No free slot: dropped, including a frame that is also too long
+    sendFrame(0x70, 8);
+    sendFrame(0x78, 16);
+    sendFrame(0x80, SPI1_FRAME_SIZE + 8);
+    CHECK_EQUAL(3, dev1_SPI1_getDroppedFrames());
+    CHECK_EQUAL(0, dev1_SPI1_getLongFrames());
+    
+    //A free slot: a frame 1 byte too long is dropped, a full size frame is kept
+    consume(1);
+    sendFrame(0x90, SPI1_FRAME_SIZE + 1);
+    sendFrame(0xA0, SPI1_FRAME_SIZE);
+    CHECK_EQUAL(4, dev1_SPI1_getDroppedFrames());
+    CHECK_EQUAL(1, dev1_SPI1_getLongFrames());
+    
+    consume(SPI1_FRAME_COUNT);
+    CHECK_EQUAL(SPI1_FRAME_COUNT + 1, clientFrames);
+    for (uint8_t n = 0; n < SPI1_FRAME_COUNT; n++)
+    {
+        CHECK_EQUAL(8, clientLen[n]);
+        CHECK_EQUAL(frameSum(0x10 * n, 8), clientSum[n]);
+    }
+    CHECK_EQUAL(SPI1_FRAME_SIZE, clientLen[SPI1_FRAME_COUNT]);
+    CHECK_EQUAL(frameSum(0xA0, SPI1_FRAME_SIZE), clientSum[SPI1_FRAME_COUNT]);
+    
+    //Random lengths, 1 in 8 too long. Before each frame, the main loop is
+    //allowed to collect a random number of the stored frames, after a random
+    //delay, so it runs while the ISR receives the frame
+    uint8_t expectedLen[200];
+    uint16_t expectedSum[200];
+    uint8_t stored = 0, pending = 0;
+    uint8_t droppedBefore = dev1_SPI1_getDroppedFrames();
+    uint8_t tooLongBefore = dev1_SPI1_getLongFrames();
+    uint8_t dropped = droppedBefore, tooLong = tooLongBefore;
+    uint8_t full = 0;
+    
+    clientFrames = 0;
+    for (uint8_t n = 0; n < sizeof (expectedLen); n++)
+    {
+        uint8_t len = (random8(8) == 0) ? (uint8_t) (SPI1_FRAME_SIZE + 1 + random8(SPI1_FRAME_SIZE))
+                                        : (uint8_t) (1 + random8(SPI1_FRAME_SIZE));
+        uint8_t first = (uint8_t) (n * 37);
+        uint8_t take = random8(pending + 1);
+        
+        consumeDelay = (uint32_t) random8(128) * 256;
+        consumeBudget = take;
+        
+        if (pending == SPI1_FRAME_COUNT)
+        {
+            full++;
+            
+            if (take != 0)
+            {
+                //A slot must be free before the frame starts
+                CHECK(sim_waitFor(budgetUsed, 100000));
+            }
+        }
+        
+        //Only a full ring with nothing collected has no slot for the frame
+        bool slot = (pending < SPI1_FRAME_COUNT) || (take != 0);
+        pending -= take;
+        
+        if (!slot)
+        {
+            dropped++;
+        }
+        else if (len > SPI1_FRAME_SIZE)
+        {
+            dropped++;
+            tooLong++;
+        }
+        else
+        {
+            expectedLen[stored] = len;
+            expectedSum[stored] = frameSum(first, len);
+            stored++;
+            pending++;
+        }
+        
+        sendFrame(first, len);
+        CHECK(sim_waitFor(budgetUsed, 100000));
+    }
+    consume(pending);
+    
+    CHECK_EQUAL(stored, clientFrames);
+    for (uint8_t n = 0; n < stored; n++)
+    {
+        CHECK_EQUAL(expectedLen[n], clientLen[n]);
+        CHECK_EQUAL(expectedSum[n], clientSum[n]);
+    }
+    CHECK_EQUAL(dropped, dev1_SPI1_getDroppedFrames());
+    CHECK_EQUAL(tooLong, dev1_SPI1_getLongFrames());
+    
+    REPORT("%u random frames (seed %08lX): %u stored, %u dropped (%u too long), ring full %u times",
+           (unsigned) sizeof (expectedLen), SEED, stored, (uint8_t) (dropped - droppedBefore), (uint8_t) (tooLong - tooLongBefore), full);
+    
+    return testResult("frames");
+}
@@ -0,0 +1,113 @@
+//Interrupt driven exchange of the host (SPI1_exchangeBytesAsync): data, the
+//completion callback, the chip select handler and the bus time between bytes
+
+#include "test.h"
+#include "spi1_host.h"
+#include "interrupts.h"
+
+#include <string.h>
+
+#define LEN 64
+
+//Vectors of spi1_host.c
+void SPI1_TX_ISR(void);
+void SPI1_RX_ISR(void);
+void SPI1_status_ISR(void);
+
+static testPeer_t peer;
+static uint8_t peerRX[LEN];
+
+static uint8_t doneCount = 0;
+static uint8_t selects = 0, deselects = 0;
+static uint8_t lastCS = 0;
+
+static void onDone(void)
+{
+    doneCount++;
+}
+
+static void onChipSelect(uint8_t cs, bool select)
+{
+    if (select)
+    {
+        selects++;
+    }
+    else
+    {
+        deselects++;
+    }
+    lastCS = cs;
+}
+
+static bool idle(void)
+{
+    return !SPI1_isBusy();
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(0, SIM_IRQ_SPI1TX, SPI1_TX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1RX, SPI1_RX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1, SPI1_status_ISR);
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    SPI1_setChipSelectHandler(onChipSelect);
+    Interrupts_enable();
+    
+    uint8_t tx[LEN], rx[LEN];
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        tx[i] = i ^ 0xC3;
+    }
+    memset(rx, 0, sizeof (rx));
+    
+    //Runs in the background, the handler is not called for SPI1_CS_NONE
+    sim_clearBusStats(0, 0);
+    uint64_t start = sim_now();
+    CHECK(SPI1_exchangeBytesAsync(tx, rx, LEN, onDone));
+    uint64_t startCycles = sim_now() - start;
+    CHECK(SPI1_isBusy());
+    CHECK(sim_waitFor(idle, 100000));
+    CHECK_EQUAL(1, doneCount);
+    CHECK_EQUAL(0, selects);
+    CHECK_EQUAL(0, deselects);
+    
+    CHECK(memcmp(peerRX, tx, LEN) == 0);
+    CHECK_EQUAL(1, peer.frames);
+    CHECK_EQUAL(LEN, peer.count);
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        CHECK_EQUAL(testReply(i), rx[i]);
+    }
+    
+    sim_busStats_t async;
+    sim_getBusStats(0, 0, &async);
+    CHECK_EQUAL(LEN, async.bytes);
+    
+    //A device selected by a queued transaction is released before an async exchange
+    SPI1_transaction_t transaction = {
+        .txData = tx, .rxData = rx, .len = 4, .cs = 2,
+        .flags = SPI1_XFER_TX | SPI1_XFER_RX, .callback = 0
+    };
+    CHECK(SPI1_queueTransaction(&transaction));
+    CHECK(SPI1_exchangeBytesAsync(tx, rx, 4, onDone));
+    CHECK(sim_waitFor(idle, 100000));
+    CHECK_EQUAL(2, doneCount);
+    CHECK_EQUAL(1, selects);
+    CHECK_EQUAL(1, deselects);
+    CHECK_EQUAL(2, lastCS);
+    
+    //Blocking loop for comparison
+    sim_clearBusStats(0, 0);
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, LEN));
+    sim_busStats_t blocking;
+    sim_getBusStats(0, 0, &blocking);
+    
+    REPORT("%u bytes at 1 MHz: async start %llu cycles, bus idle %llu (max gap %llu), blocking bus idle %llu",
+           LEN, (unsigned long long) startCycles, (unsigned long long) async.gapCycles,
+           (unsigned long long) async.maxGap, (unsigned long long) blocking.gapCycles);
+    
+    return testResult("host_async");
+}
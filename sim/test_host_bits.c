@@ -0,0 +1,77 @@
+//Bit Mode transfers of the host (SPI1_exchangeBits): every width from 1 to 8
+//bits, and widths outside 1..8 rejected without a byte on the bus
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <xc.h>
+#include <string.h>
+
+#define COUNT 6
+
+static testPeer_t peer;
+static uint8_t peerRX[COUNT];
+
+//TX frame i, before masking to the width
+static uint8_t bitsTX(uint8_t i)
+{
+    return (uint8_t) (0xA5 ^ (i * 0x35));
+}
+
+int main(void)
+{
+    sim_reset();
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    uint8_t con0 = SPI1CON0;
+    uint8_t twidth = SPI1TWIDTH;
+    
+    uint8_t tx[COUNT], rx[COUNT];
+    for (uint8_t width = 1; width <= 8; width++)
+    {
+        uint8_t mask = (uint8_t) (0xFF >> (8 - width));
+        for (uint8_t i = 0; i < COUNT; i++)
+        {
+            tx[i] = bitsTX(i) & mask;
+        }
+        memset(rx, 0, sizeof (rx));
+        
+        sim_clearBusStats(0, 0);
+        CHECK_EQUAL(SPI1_OK, SPI1_exchangeBits(tx, rx, COUNT, width));
+        
+        sim_busStats_t stats;
+        sim_getBusStats(0, 0, &stats);
+        CHECK_EQUAL(COUNT, stats.bytes);
+        for (uint8_t i = 0; i < COUNT; i++)
+        {
+            CHECK_EQUAL(tx[i], peerRX[i]);
+            CHECK_EQUAL(testReply(i) & mask, rx[i]);
+        }
+        
+        //Byte Mode and the width are back
+        CHECK_EQUAL(con0, SPI1CON0);
+        CHECK_EQUAL(twidth, SPI1TWIDTH);
+    }
+    
+    //Widths that used to wrap to another width (0 and 8 both send 8 bits,
+    //12 sent 4) are rejected before the module is touched
+    const uint8_t bad[] = {0, 9, 12, 16, 0xFF};
+    for (uint8_t n = 0; n < sizeof (bad); n++)
+    {
+        sim_clearBusStats(0, 0);
+        uint16_t frames = peer.frames;
+        CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_exchangeBits(tx, rx, COUNT, bad[n]));
+        
+        sim_busStats_t stats;
+        sim_getBusStats(0, 0, &stats);
+        CHECK_EQUAL(0, stats.bytes);
+        CHECK_EQUAL(frames, peer.frames);
+        CHECK_EQUAL(con0, SPI1CON0);
+        CHECK_EQUAL(twidth, SPI1TWIDTH);
+    }
+    
+    REPORT("Widths 1 to 8 exchanged, %u bad widths rejected", (unsigned) sizeof (bad));
+    
+    return testResult("host_bits");
+}
@@ -0,0 +1,141 @@
+//Command transactions of the host (SPI1_executeCommand): opcode, address,
+//dummy and data phases in one SS assertion, address lengths the header can't
+//hold rejected without a byte on the bus, and the read throughput of a page
+//against the copy-based read it replaces
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <string.h>
+
+#define PAGE 256
+
+static testPeer_t peer;
+static uint8_t peerRX[32];
+
+//Fast read of a page (0x0B, 3 address bytes, 1 dummy byte) through
+//SPI1_executeCommand. Returns the cycles taken
+static uint64_t readCommand(uint8_t* page)
+{
+    SPI1_command_t read = {0x0B, 3, 0x000100, 1, 0, page, PAGE};
+    
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_executeCommand(&read));
+    return sim_now() - start;
+}
+
+//The same read built in a temporary buffer and exchanged with
+//SPI1_exchangeBytes, the data then copied out. Returns the cycles taken
+static uint64_t readCopy(uint8_t* page)
+{
+    static uint8_t buffer[5 + PAGE];
+    
+    uint64_t start = sim_now();
+    memset(buffer, SPI1_COMMAND_FILL, sizeof (buffer));
+    buffer[0] = 0x0B;
+    buffer[1] = 0x00;
+    buffer[2] = 0x01;
+    buffer[3] = 0x00;
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(buffer, buffer, sizeof (buffer)));
+    memcpy(page, &buffer[5], PAGE);
+    return sim_now() - start;
+}
+
+//Reads a page both ways at SCKHZ. Returns the bytes/s of each
+static void readPage(uint32_t sckHz, uint32_t* command, uint32_t* copy)
+{
+    uint8_t page[PAGE];
+    
+    CHECK_EQUAL(sckHz, SPI1_setClockFrequency(sckHz, SIM_FOSC_HZ));
+    
+    memset(page, 0, sizeof (page));
+    uint16_t frames = peer.frames;
+    uint64_t commandCycles = readCommand(page);
+    CHECK_EQUAL(frames + 1, peer.frames);
+    CHECK_EQUAL(5 + PAGE, peer.count);
+    for (uint16_t i = 0; i < PAGE; i++)
+    {
+        CHECK_EQUAL(testReply(5 + i), page[i]);
+    }
+    
+    memset(page, 0, sizeof (page));
+    uint64_t copyCycles = readCopy(page);
+    CHECK_EQUAL(frames + 2, peer.frames);
+    CHECK_EQUAL(5 + PAGE, peer.count);
+    for (uint16_t i = 0; i < PAGE; i++)
+    {
+        CHECK_EQUAL(testReply(5 + i), page[i]);
+    }
+    
+    *command = (uint32_t) ((uint64_t) PAGE * SIM_FOSC_HZ / commandCycles);
+    *copy = (uint32_t) ((uint64_t) PAGE * SIM_FOSC_HZ / copyCycles);
+}
+
+int main(void)
+{
+    sim_reset();
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    
+    //Fast read: opcode, 3 address bytes, 1 dummy byte, then 8 data bytes
+    uint8_t data[8];
+    memset(data, 0, sizeof (data));
+    SPI1_command_t read = {0x0B, 3, 0x123456, 1, 0, data, sizeof (data)};
+    CHECK_EQUAL(SPI1_OK, SPI1_executeCommand(&read));
+    CHECK_EQUAL(1, peer.frames);
+    CHECK_EQUAL(1 + 3 + 1 + sizeof (data), peer.count);
+    
+    const uint8_t header[] = {0x0B, 0x12, 0x34, 0x56, SPI1_COMMAND_FILL};
+    CHECK_EQUAL(0, memcmp(header, peerRX, sizeof (header)));
+    for (uint8_t i = 0; i < sizeof (data); i++)
+    {
+        CHECK_EQUAL(testReply(sizeof (header) + i), data[i]);
+    }
+    
+    //Page program: opcode, 4 address bytes, data out
+    uint8_t page[4] = {0xDE, 0xAD, 0xBE, 0xEF};
+    SPI1_command_t write = {0x12, 4, 0x89ABCDEF, 0, page, 0, sizeof (page)};
+    CHECK_EQUAL(SPI1_OK, SPI1_executeCommand(&write));
+    CHECK_EQUAL(2, peer.frames);
+    
+    const uint8_t program[] = {0x12, 0x89, 0xAB, 0xCD, 0xEF, 0xDE, 0xAD, 0xBE, 0xEF};
+    CHECK_EQUAL(sizeof (program), peer.count);
+    CHECK_EQUAL(0, memcmp(program, peerRX, sizeof (program)));
+    
+    //Address lengths over SPI1_COMMAND_MAX_ADDRESS used to be cut to 4 bytes,
+    //reaching a different address. They are rejected before SS is asserted
+    sim_clearBusStats(0, 0);
+    const uint8_t bad[] = {SPI1_COMMAND_MAX_ADDRESS + 1, 8, 0xFF};
+    for (uint8_t n = 0; n < sizeof (bad); n++)
+    {
+        SPI1_command_t command = {0x0B, bad[n], 0x123456, 1, 0, data, sizeof (data)};
+        CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_executeCommand(&command));
+    }
+    
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(0, stats.bytes);
+    CHECK_EQUAL(0, stats.ssAsserts);
+    CHECK_EQUAL(2, peer.frames);
+    
+    //256-byte page read at 1 MHz (bus bound) and 32 MHz SCK (CPU bound)
+    static const uint32_t sck[] = {1000000UL, 32000000UL};
+    uint32_t command[2], copy[2];
+    for (uint8_t n = 0; n < 2; n++)
+    {
+        readPage(sck[n], &command[n], &copy[n]);
+    }
+    
+    //Bus bound, the phases cost a few loop setups. CPU bound, there is no
+    //second pass over the data and no header bytes stored
+    CHECK(command[0] * 100ULL >= copy[0] * 99ULL);
+    CHECK(command[1] > copy[1]);
+    
+    REPORT("256-byte page read, data bytes/s (SPI1_executeCommand / copy-based SPI1_exchangeBytes):");
+    REPORT("  1 MHz SCK: %lu / %lu", (unsigned long) command[0], (unsigned long) copy[0]);
+    REPORT("  32 MHz SCK: %lu / %lu (%lu.%02lux)", (unsigned long) command[1], (unsigned long) copy[1],
+           (unsigned long) (command[1] / copy[1]), (unsigned long) ((command[1] * 100ULL / copy[1]) % 100));
+    
+    return testResult("host_command");
+}
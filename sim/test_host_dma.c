@@ -0,0 +1,145 @@
+//DMA transfers of the host (spi1_host_dma.c): data, one SS assertion for
+//transfers longer than the counter, lengths the DMA counters can't hold, a
+//stalled channel timed out by SPI1_DMA_complete, and CPU time compared with
+//the blocking loop
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_host_dma.h"
+
+#include <xc.h>
+#include <string.h>
+
+#define LONG_LEN 3000
+
+static testPeer_t peer;
+static uint8_t peerRX[LONG_LEN];
+
+//Runs a DMA transfer, counting the register accesses made while it runs
+static uint64_t completeTransfer(void)
+{
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_DMA_complete());
+    return sim_now() - start;
+}
+
+static bool checkReplies(const uint8_t* rx, uint16_t len)
+{
+    for (uint16_t i = 0; i < len; i++)
+    {
+        if (rx[i] != testReply(i))
+        {
+            printf("  byte %u is %02X\n", i, rx[i]);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    sim_reset();
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+
+    SPI1_initHost();
+    SPI1_DMA_init();
+
+    //TX may be anywhere, RX is written through a 16-bit DMA address
+    uint8_t* tx = sim_alloc(0, LONG_LEN);
+    uint8_t* rx = sim_alloc(0, LONG_LEN);
+    for (uint16_t i = 0; i < LONG_LEN; i++)
+    {
+        tx[i] = (uint8_t) (i ^ 0x5A);
+    }
+
+    //Short exchange
+    CHECK(SPI1_DMA_startExchange(tx, rx, 16));
+    completeTransfer();
+    CHECK(checkReplies(rx, 16));
+    CHECK(memcmp(peerRX, tx, 16) == 0);
+    CHECK_EQUAL(1, peer.frames);
+    CHECK_EQUAL(16, peer.count);
+
+    //Longer than SPI1_MAX_TCNT: one SS assertion, counter reloaded by isBusy
+    memset(rx, 0, LONG_LEN);
+    sim_clearBusStats(0, 0);
+    CHECK(SPI1_DMA_startExchange(tx, rx, LONG_LEN));
+    uint64_t dmaCycles = completeTransfer();
+    CHECK(checkReplies(rx, LONG_LEN));
+    CHECK(memcmp(peerRX, tx, LONG_LEN) == 0);
+    CHECK_EQUAL(2, peer.frames);
+    CHECK_EQUAL(LONG_LEN, peer.count);
+
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(1, stats.ssAsserts);
+    CHECK_EQUAL(LONG_LEN, stats.bytes);
+
+    //Send only
+    CHECK(SPI1_DMA_startSend(tx, 100));
+    completeTransfer();
+    CHECK_EQUAL(100, peer.count);
+    CHECK(memcmp(peerRX, tx, 100) == 0);
+
+    //Receive only
+    memset(rx, 0, 100);
+    CHECK(SPI1_DMA_startReceive(rx, 100));
+    completeTransfer();
+    CHECK_EQUAL(100, peer.count);
+    CHECK(checkReplies(rx, 100));
+
+    //Lengths over SPI1_DMA_MAX_LEN used to be cut to the 12-bit counters.
+    //They are rejected before SS is asserted
+    sim_clearBusStats(0, 0);
+    CHECK(!SPI1_DMA_startExchange(tx, rx, 0));
+    CHECK(!SPI1_DMA_startExchange(tx, rx, SPI1_DMA_MAX_LEN + 1));
+    CHECK(!SPI1_DMA_startSend(tx, SPI1_DMA_MAX_LEN + 1));
+    CHECK(!SPI1_DMA_startReceive(rx, 0));
+    CHECK(!SPI1_DMA_startReceive(rx, 0xFFFF));
+    sim_cpu(5000);
+
+    sim_busStats_t rejected;
+    sim_getBusStats(0, 0, &rejected);
+    CHECK_EQUAL(0, rejected.bytes);
+    CHECK_EQUAL(0, rejected.ssAsserts);
+
+    //TX channel switched off mid transfer: SCK stops, and SPI1_DMA_complete
+    //gives up after the timeout instead of waiting forever
+    SPI1_setTimeout(500);
+    CHECK(SPI1_DMA_startExchange(tx, rx, 100));
+    sim_cpu(20 * 512);
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+
+    uint64_t stallStart = sim_now();
+    CHECK_EQUAL(SPI1_TIMEOUT, SPI1_DMA_complete());
+    uint64_t stallCycles = sim_now() - stallStart;
+    CHECK(stallCycles >= 500ull * SIM_FOSC_HZ / 1000000 - 4 * 64 * 4);
+    CHECK(stallCycles < 2 * 500ull * SIM_FOSC_HZ / 1000000);
+    CHECK(!SPI1CON2bits.SSET);
+
+    //The module was recovered: the next transfer runs as before
+    memset(rx, 0, 16);
+    CHECK(SPI1_DMA_startExchange(tx, rx, 16));
+    completeTransfer();
+    CHECK(checkReplies(rx, 16));
+    CHECK_EQUAL(16, peer.count);
+    SPI1_setTimeout(0);
+
+    //Blocking loop for comparison
+    sim_clearBusStats(0, 0);
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, LONG_LEN));
+    uint64_t blockingCycles = sim_now() - start;
+    CHECK(checkReplies(rx, LONG_LEN));
+
+    sim_busStats_t blocking;
+    sim_getBusStats(0, 0, &blocking);
+
+    REPORT("Stalled DMA transfer timed out after %llu cycles (500 us timeout)", (unsigned long long) stallCycles);
+    REPORT("%u bytes at 1 MHz: DMA %llu cycles elapsed (bus idle %llu), blocking %llu cycles (bus idle %llu)",
+           LONG_LEN, (unsigned long long) dmaCycles, (unsigned long long) stats.gapCycles,
+           (unsigned long long) blockingCycles, (unsigned long long) blocking.gapCycles);
+
+    return testResult("host_dma");
+}
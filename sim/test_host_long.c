@@ -0,0 +1,153 @@
+//Transfers longer than the transfer counter (SPI1_MAX_TCNT): every length
+//around a top-up, one SS assertion, and no bus time lost to the counter
+
+#include "test.h"
+#include "spi1_host.h"
+#include "interrupts.h"
+
+#include <string.h>
+
+#define MAX_LEN 5000
+
+//Vectors of spi1_host.c
+void SPI1_TX_ISR(void);
+void SPI1_RX_ISR(void);
+void SPI1_status_ISR(void);
+
+static testPeer_t peer;
+static uint8_t peerRX[MAX_LEN];
+static uint8_t tx[MAX_LEN], rx[MAX_LEN];
+
+//1 MHz SCK: 8 bits of 64 cycles
+#define BYTE_CYCLES 512
+
+//Longest gap between bytes of any transfer checked
+static uint64_t longestGap = 0;
+
+static bool idle(void)
+{
+    return !SPI1_isBusy();
+}
+
+static bool checkTransfer(uint16_t len, bool checkTX, bool checkRX)
+{
+    bool ok = true;
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    
+    CHECK_EQUAL(len, stats.bytes);
+    CHECK_EQUAL(1, stats.ssAsserts);
+    CHECK_EQUAL(len, peer.count);
+    
+    if (stats.maxGap > longestGap)
+    {
+        longestGap = stats.maxGap;
+    }
+    
+    //The counter is topped up before it runs out, so the bytes are back to back
+    if (stats.maxGap != 0)
+    {
+        printf("  %u bytes: %llu cycle gap\n", len, (unsigned long long) stats.maxGap);
+        ok = false;
+    }
+    
+    if (checkTX && (memcmp(peerRX, tx, len) != 0))
+    {
+        printf("  %u bytes: TX data differs\n", len);
+        ok = false;
+    }
+    
+    for (uint16_t i = 0; checkRX && (i < len); i++)
+    {
+        if (rx[i] != testReply(i))
+        {
+            printf("  %u bytes: RX byte %u is %02X\n", len, i, rx[i]);
+            ok = false;
+            break;
+        }
+    }
+    return ok;
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(0, SIM_IRQ_SPI1TX, SPI1_TX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1RX, SPI1_RX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1, SPI1_status_ISR);
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    
+    for (uint16_t i = 0; i < MAX_LEN; i++)
+    {
+        tx[i] = (uint8_t) (i * 13 + (i >> 8));
+    }
+    
+    //Lengths around the counter, and around 1 and 2 top-ups
+    const uint16_t lengths[] = {
+        SPI1_MAX_TCNT - 1, SPI1_MAX_TCNT, SPI1_MAX_TCNT + 1, SPI1_MAX_TCNT + 2,
+        SPI1_TOPUP_BYTES * 2 - 1, SPI1_TOPUP_BYTES * 2, SPI1_TOPUP_BYTES * 2 + 1,
+        SPI1_MAX_TCNT + 501, SPI1_MAX_TCNT * 2, SPI1_MAX_TCNT * 2 + 1,
+        SPI1_TOPUP_BYTES * 4 + 3, MAX_LEN
+    };
+    
+    for (uint8_t n = 0; n < sizeof (lengths) / sizeof (lengths[0]); n++)
+    {
+        uint16_t len = lengths[n];
+        
+        memset(rx, 0, len);
+        sim_clearBusStats(0, 0);
+        CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, len));
+        CHECK(checkTransfer(len, true, true));
+        
+        sim_clearBusStats(0, 0);
+        CHECK_EQUAL(SPI1_OK, SPI1_sendBytes(tx, len));
+        CHECK(checkTransfer(len, true, false));
+        
+        memset(rx, 0, len);
+        sim_clearBusStats(0, 0);
+        CHECK_EQUAL(SPI1_OK, SPI1_receiveBytes(rx, len));
+        CHECK(checkTransfer(len, false, true));
+        
+        //The counter is discarded, so the next short transfer ends on its own count
+        sim_clearBusStats(0, 0);
+        CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, 3));
+        CHECK(checkTransfer(3, true, true));
+    }
+    
+    //Interrupt driven, the counter is topped up by the TX ISR
+    Interrupts_enable();
+    
+    const uint8_t flags[] = {SPI1_XFER_TX | SPI1_XFER_RX, SPI1_XFER_TX, SPI1_XFER_RX};
+    
+    for (uint8_t n = 0; n < sizeof (flags); n++)
+    {
+        SPI1_transaction_t transaction = {tx, rx, MAX_LEN, SPI1_CS_NONE, flags[n], 0};
+        
+        memset(rx, 0, MAX_LEN);
+        sim_clearBusStats(0, 0);
+        CHECK(SPI1_queueTransaction(&transaction));
+        CHECK(sim_waitFor(idle, (uint64_t) MAX_LEN * BYTE_CYCLES * 2));
+        CHECK(checkTransfer(MAX_LEN, (flags[n] & SPI1_XFER_TX) != 0, (flags[n] & SPI1_XFER_RX) != 0));
+    }
+    
+    //A short transaction queued behind a long one
+    SPI1_transaction_t shortTransaction = {tx, rx, 3, SPI1_CS_NONE, SPI1_XFER_TX | SPI1_XFER_RX, 0};
+    SPI1_transaction_t longTransaction = {tx, rx, MAX_LEN, SPI1_CS_NONE, SPI1_XFER_TX, 0};
+    sim_clearBusStats(0, 0);
+    CHECK(SPI1_queueTransaction(&longTransaction));
+    CHECK(SPI1_queueTransaction(&shortTransaction));
+    CHECK(sim_waitFor(idle, (uint64_t) (MAX_LEN + 3) * BYTE_CYCLES * 2));
+    
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(MAX_LEN + 3, stats.bytes);
+    CHECK_EQUAL(2, stats.ssAsserts);
+    CHECK_EQUAL(3, peer.count);
+    
+    REPORT("Longest bus gap in transfers of up to %u bytes: %llu cycles, blocking and async (one byte is %u)",
+           MAX_LEN, (unsigned long long) longestGap, BYTE_CYCLES);
+    
+    return testResult("host_long");
+}
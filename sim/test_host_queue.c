@@ -0,0 +1,140 @@
+//Transaction queue of the host (SPI1_queueTransaction): order, back-to-back
+//starts, chip select changes, and a full queue
+
+#include "test.h"
+#include "spi1_host.h"
+#include "interrupts.h"
+
+#include <string.h>
+
+#define LEN 8
+
+//Vectors of spi1_host.c
+void SPI1_TX_ISR(void);
+void SPI1_RX_ISR(void);
+void SPI1_status_ISR(void);
+
+static testPeer_t peer;
+static uint8_t peerRX[LEN];
+
+static uint8_t order[SPI1_QUEUE_SIZE * 2];
+static uint8_t orderCount = 0;
+static uint8_t csLog[16];
+static uint8_t csCount = 0;
+
+static void onDone0(void) { order[orderCount++] = 0; }
+static void onDone1(void) { order[orderCount++] = 1; }
+static void onDone2(void) { order[orderCount++] = 2; }
+static void onDone3(void) { order[orderCount++] = 3; }
+
+static void (* const doneCallbacks[4])(void) = {onDone0, onDone1, onDone2, onDone3};
+
+//Logs select as cs, de-select as cs | 0x80
+static void onChipSelect(uint8_t cs, bool select)
+{
+    if (csCount < sizeof (csLog))
+    {
+        csLog[csCount] = select ? cs : (cs | 0x80);
+    }
+    csCount++;
+}
+
+static bool idle(void)
+{
+    return !SPI1_isBusy();
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(0, SIM_IRQ_SPI1TX, SPI1_TX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1RX, SPI1_RX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1, SPI1_status_ISR);
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    SPI1_setChipSelectHandler(onChipSelect);
+    
+    uint8_t tx[4][LEN], rx[4][LEN];
+    for (uint8_t t = 0; t < 4; t++)
+    {
+        for (uint8_t i = 0; i < LEN; i++)
+        {
+            tx[t][i] = (uint8_t) ((t << 4) | i);
+        }
+    }
+    memset(rx, 0, sizeof (rx));
+    
+    //Empty transactions are rejected
+    SPI1_transaction_t transaction = {
+        .txData = tx[0], .rxData = rx[0], .len = 0, .cs = 1,
+        .flags = SPI1_XFER_TX | SPI1_XFER_RX, .callback = 0
+    };
+    CHECK(!SPI1_queueTransaction(&transaction));
+    
+    //Interrupts are off: the first transaction starts, but stops after 2 bytes
+    sim_clearBusStats(0, 0);
+    for (uint8_t n = 0; n < SPI1_QUEUE_SIZE; n++)
+    {
+        uint8_t t = n % 4;
+        transaction.txData = tx[t];
+        transaction.rxData = rx[t];
+        transaction.len = LEN;
+        transaction.cs = (n < 2) ? 1 : 2;
+        transaction.callback = doneCallbacks[t];
+        CHECK(SPI1_queueTransaction(&transaction));
+    }
+    CHECK_EQUAL(SPI1_QUEUE_SIZE, SPI1_getQueueCount());
+    CHECK_EQUAL(SPI1_STATUS_QUEUED, SPI1_getStatus());
+    CHECK(!SPI1_queueTransaction(&transaction));
+    
+    //Run the queue
+    Interrupts_enable();
+    CHECK(sim_waitFor(idle, 1000000));
+    CHECK_EQUAL(0, SPI1_getQueueCount());
+    CHECK_EQUAL(SPI1_STATUS_IDLE, SPI1_getStatus());
+    
+    //Completed in order, with the right data
+    CHECK_EQUAL(SPI1_QUEUE_SIZE, orderCount);
+    for (uint8_t n = 0; n < orderCount; n++)
+    {
+        CHECK_EQUAL(n % 4, order[n]);
+    }
+    for (uint8_t t = 0; t < 4; t++)
+    {
+        for (uint8_t i = 0; i < LEN; i++)
+        {
+            CHECK_EQUAL(testReply(i), rx[t][i]);
+        }
+    }
+    
+    //Handler only runs when the chip select changes, and once at the end
+    CHECK_EQUAL(4, csCount);
+    CHECK_EQUAL(1, csLog[0]);
+    CHECK_EQUAL(0x81, csLog[1]);
+    CHECK_EQUAL(2, csLog[2]);
+    CHECK_EQUAL(0x82, csLog[3]);
+    
+    //Each transaction is its own SS assertion
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(SPI1_QUEUE_SIZE * LEN, stats.bytes);
+    CHECK_EQUAL(SPI1_QUEUE_SIZE, stats.ssAsserts);
+    CHECK_EQUAL(SPI1_QUEUE_SIZE, peer.frames);
+    
+    //Time from the last byte of a transaction to the first byte of the next
+    sim_clearBusStats(0, 0);
+    for (uint8_t n = 0; n < 4; n++)
+    {
+        transaction.cs = 1;
+        CHECK(SPI1_queueTransaction(&transaction));
+    }
+    CHECK(sim_waitFor(idle, 1000000));
+    sim_getBusStats(0, 0, &stats);
+    uint64_t between = (stats.lastEnd - stats.firstStart - stats.busyCycles - stats.gapCycles) / 3;
+    
+    REPORT("%u-byte transactions at 1 MHz: %llu cycles between transactions, bus idle within a transaction %llu",
+           LEN, (unsigned long long) between, (unsigned long long) stats.gapCycles);
+    
+    return testResult("host_queue");
+}
@@ -0,0 +1,166 @@
+//Scatter-gather transfers of the host (SPI1_exchangeSegments): TX only, RX
+//only, in place and empty segments in one SS assertion, lists too long for
+//the transfer count rejected without a byte on the bus, and the RAM and time
+//saved against a packet copied into a staging buffer
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <string.h>
+
+//Packet of the staging comparison: header struct, payload and trailer
+#define PACKET_HEADER 4
+#define PACKET_PAYLOAD 256
+#define PACKET_TRAILER 2
+#define PACKET_LEN (PACKET_HEADER + PACKET_PAYLOAD + PACKET_TRAILER)
+
+//The model does not cost RAM accesses. A PIC18 copy loop (MOVFF with
+//POSTINC and the loop count) takes about 5 instruction cycles per byte
+#define COPY_CYCLES_PER_BYTE 20
+
+//Size of a segment on the target: 3 16-bit fields
+#define TARGET_SEGMENT_SIZE 6
+
+static testPeer_t peer;
+static uint8_t peerRX[PACKET_LEN];
+
+//Header sent from constant data
+static const uint8_t header[3] = {0x02, 0x10, 0x20};
+
+//Packet parts, in different places in RAM
+static uint8_t packetHeader[PACKET_HEADER] = {0x5A, 0x01, 0x01, 0x00};
+static uint8_t packetPayload[PACKET_PAYLOAD];
+static uint8_t packetTrailer[PACKET_TRAILER] = {0xC3, 0x3C};
+
+//Staging buffer the packet used to be copied into
+static uint8_t staging[PACKET_LEN];
+
+//Checks that the peer received the packet in one frame
+static void checkPacket(uint16_t frames)
+{
+    CHECK_EQUAL(frames + 1, peer.frames);
+    CHECK_EQUAL(PACKET_LEN, peer.count);
+    CHECK_EQUAL(0, memcmp(&peerRX[0], packetHeader, PACKET_HEADER));
+    CHECK_EQUAL(0, memcmp(&peerRX[PACKET_HEADER], packetPayload, PACKET_PAYLOAD));
+    CHECK_EQUAL(0, memcmp(&peerRX[PACKET_HEADER + PACKET_PAYLOAD], packetTrailer, PACKET_TRAILER));
+}
+
+//Sends the packet both ways at SCKHZ. Returns the bytes/s of each
+static void sendPacket(uint32_t sckHz, uint32_t* segments, uint32_t* copy)
+{
+    CHECK_EQUAL(sckHz, SPI1_setClockFrequency(sckHz, SIM_FOSC_HZ));
+    
+    SPI1_segment_t packet[] = {
+        {&packetHeader[0], 0, PACKET_HEADER},
+        {&packetPayload[0], 0, PACKET_PAYLOAD},
+        {&packetTrailer[0], 0, PACKET_TRAILER}
+    };
+    
+    uint16_t frames = peer.frames;
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeSegments(&packet[0], 3));
+    uint64_t segmentCycles = sim_now() - start;
+    checkPacket(frames);
+    
+    //Copied into the staging buffer, then sent
+    frames = peer.frames;
+    start = sim_now();
+    memcpy(&staging[0], packetHeader, PACKET_HEADER);
+    memcpy(&staging[PACKET_HEADER], packetPayload, PACKET_PAYLOAD);
+    memcpy(&staging[PACKET_HEADER + PACKET_PAYLOAD], packetTrailer, PACKET_TRAILER);
+    sim_cpu(PACKET_LEN * COPY_CYCLES_PER_BYTE);
+    SPI1_sendBytes(staging, PACKET_LEN);
+    uint64_t copyCycles = sim_now() - start;
+    checkPacket(frames);
+    
+    *segments = (uint32_t) ((uint64_t) PACKET_LEN * SIM_FOSC_HZ / segmentCycles);
+    *copy = (uint32_t) ((uint64_t) PACKET_LEN * SIM_FOSC_HZ / copyCycles);
+}
+
+int main(void)
+{
+    sim_reset();
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    
+    uint8_t payload[5] = {0xA0, 0xA1, 0xA2, 0xA3, 0xA4};
+    uint8_t inPlace[4] = {0xB0, 0xB1, 0xB2, 0xB3};
+    uint8_t status[3];
+    memset(status, 0, sizeof (status));
+    
+    SPI1_segment_t packet[] = {
+        {&header[0], 0, sizeof (header)},
+        {&payload[0], 0, sizeof (payload)},
+        {0, 0, 0},
+        {&inPlace[0], &inPlace[0], sizeof (inPlace)},
+        {0, &status[0], sizeof (status)}
+    };
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeSegments(&packet[0], 5));
+    
+    //One frame: the header, the payload, the in place bytes, then the fill
+    CHECK_EQUAL(1, peer.frames);
+    const uint8_t sent[] = {0x02, 0x10, 0x20, 0xA0, 0xA1, 0xA2, 0xA3, 0xA4, 0xB0, 0xB1, 0xB2, 0xB3,
+        SPI1_SEGMENT_FILL, SPI1_SEGMENT_FILL, SPI1_SEGMENT_FILL};
+    CHECK_EQUAL(sizeof (sent), peer.count);
+    CHECK_EQUAL(0, memcmp(sent, peerRX, sizeof (sent)));
+    
+    //Replies are only stored in segments with rxData
+    for (uint8_t i = 0; i < sizeof (inPlace); i++)
+    {
+        CHECK_EQUAL(testReply(8 + i), inPlace[i]);
+    }
+    for (uint8_t i = 0; i < sizeof (status); i++)
+    {
+        CHECK_EQUAL(testReply(12 + i), status[i]);
+    }
+    CHECK_EQUAL(0xA0, payload[0]);
+    CHECK_EQUAL(0xA4, payload[4]);
+    
+    //Lists over 65535 bytes used to wrap the 16-bit total and send a short
+    //frame. They are rejected before SS is asserted
+    sim_clearBusStats(0, 0);
+    SPI1_segment_t huge[] = {
+        {0, 0, 0xFFFF},
+        {0, 0, 2}
+    };
+    CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_exchangeSegments(&huge[0], 2));
+    
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(0, stats.bytes);
+    CHECK_EQUAL(0, stats.ssAsserts);
+    
+    //4-byte header, 256-byte payload and 2-byte trailer, at 1 MHz (bus bound)
+    //and 32 MHz SCK (CPU bound)
+    for (uint16_t i = 0; i < PACKET_PAYLOAD; i++)
+    {
+        packetPayload[i] = (uint8_t) (i * 13 + 7);
+    }
+    
+    static const uint32_t sck[] = {1000000UL, 32000000UL};
+    uint32_t segments[2], copy[2];
+    for (uint8_t n = 0; n < 2; n++)
+    {
+        sendPacket(sck[n], &segments[n], &copy[n]);
+        
+        //No copy, and the list runs TX only since nothing is stored
+        CHECK(segments[n] > copy[n]);
+    }
+    
+    //The staging buffer against the 3 segment descriptors
+    uint16_t saved = PACKET_LEN - 3 * TARGET_SEGMENT_SIZE;
+    
+    REPORT("%u-byte packet (%u + %u + %u) in 3 segments against a staging buffer:", PACKET_LEN,
+           PACKET_HEADER, PACKET_PAYLOAD, PACKET_TRAILER);
+    REPORT("  RAM: %u-byte buffer against %u bytes of descriptors, %u bytes saved", PACKET_LEN,
+           3 * TARGET_SEGMENT_SIZE, saved);
+    for (uint8_t n = 0; n < 2; n++)
+    {
+        REPORT("  %lu MHz SCK: %lu / %lu bytes/s (+%lu%%)", (unsigned long) (sck[n] / 1000000),
+               (unsigned long) segments[n], (unsigned long) copy[n],
+               (unsigned long) ((segments[n] - copy[n]) * 100ULL / copy[n]));
+    }
+    
+    return testResult("host_segments");
+}
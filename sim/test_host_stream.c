@@ -0,0 +1,132 @@
+//DMA streaming of the host (SPI1_DMA_startStream): data through many halves,
+//DMASELECT kept for the main code across the interrupt, and the sustained
+//rate with the bus gaps between bytes
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_host_dma.h"
+#include "interrupts.h"
+
+#include <xc.h>
+#include <string.h>
+
+#define HALF 64
+#define HALVES 12
+
+//Vector of spi1_host_dma.c
+void SPI1_DMA_streamISR(void);
+
+static testPeer_t peer;
+static uint8_t peerRX[HALF * (HALVES + 2)];
+
+static uint8_t* tx;
+static uint8_t* rx;
+
+static uint8_t halvesDone = 0;
+static bool halfOrder = true;
+static bool rxCorrect = true;
+
+//TX byte i of the stream
+static uint8_t streamTX(uint16_t i)
+{
+    return (uint8_t) ((i * 3) ^ (i >> 8));
+}
+
+//Checks the half just received, then refills it with the data for 2 halves later
+static void onHalf(uint8_t half)
+{
+    if (half != (halvesDone & 1))
+    {
+        halfOrder = false;
+    }
+    
+    uint16_t base = (uint16_t) halvesDone * HALF;
+    for (uint16_t i = 0; i < HALF; i++)
+    {
+        if (rx[half * HALF + i] != testReply(base + i))
+        {
+            rxCorrect = false;
+        }
+        tx[half * HALF + i] = streamTX(base + 2 * HALF + i);
+    }
+    
+    halvesDone++;
+}
+
+static bool streamDone(void)
+{
+    return halvesDone >= HALVES;
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(0, SIM_IRQ_DMA2DCNT, SPI1_DMA_streamISR);
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    SPI1_DMA_init();
+    Interrupts_enable();
+    
+    //Buffers are reached through 16-bit DMA addresses
+    tx = sim_alloc(0, 2 * HALF);
+    rx = sim_alloc(0, 2 * HALF);
+    for (uint16_t i = 0; i < 2 * HALF; i++)
+    {
+        tx[i] = streamTX(i);
+    }
+    memset(rx, 0, 2 * HALF);
+    
+    CHECK(!SPI1_DMA_startStream(tx, rx, 0, onHalf));
+    CHECK(!SPI1_DMA_startStream(tx, rx, SPI1_STREAM_MAX_HALF + 1, onHalf));
+    
+    sim_clearBusStats(0, 0);
+    uint64_t start = sim_now();
+    CHECK(SPI1_DMA_startStream(tx, rx, HALF, onHalf));
+    
+    //Main code using another channel while the stream runs
+    uint16_t selectErrors = 0;
+    uint64_t timeout = start + (uint64_t) HALF * (HALVES + 2) * 512;
+    while (!streamDone() && (sim_now() < timeout))
+    {
+        DMASELECT = 3;
+        sim_cpu(50);
+        if (DMASELECT != 3)
+        {
+            selectErrors++;
+        }
+    }
+    uint64_t cycles = sim_now() - start;
+    SPI1_DMA_stopStream();
+    
+    //Every half arrived, in order, with the right data
+    CHECK_EQUAL(HALVES, halvesDone);
+    CHECK(halfOrder);
+    CHECK(rxCorrect);
+    CHECK_EQUAL(0, selectErrors);
+    
+    //The peer got the refilled TX data
+    CHECK(peer.count >= HALF * HALVES);
+    for (uint16_t i = 0; i < HALF * HALVES; i++)
+    {
+        if (peerRX[i] != streamTX(i))
+        {
+            CHECK_EQUAL(streamTX(i), peerRX[i]);
+            break;
+        }
+    }
+    
+    //One SS assertion, and the bus never idles for a whole byte
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(1, stats.ssAsserts);
+    CHECK(stats.maxGap < 512);
+    
+    //1 MHz SCK: 125000 bytes/s at 100 % bus use
+    uint32_t rate = (uint32_t) ((uint64_t) stats.bytes * SIM_FOSC_HZ / cycles);
+    REPORT("%u halves of %u bytes: %lu bytes/s (125000 at 100 %%), bus idle %llu cycles (max gap %llu)",
+           HALVES, HALF, (unsigned long) rate, (unsigned long long) stats.gapCycles,
+           (unsigned long long) stats.maxGap);
+    
+    return testResult("host_stream");
+}
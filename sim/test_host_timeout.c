@@ -0,0 +1,131 @@
+//Timeouts of the blocking transfers against a stuck module (sim_setFault):
+//SPI1_TIMEOUT is returned, SPI1_recover restores SPI1CON0/1/2 and empties the
+//FIFOs, the next transfer runs, and the time from the stall to the return
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi_config.h"
+
+#include <xc.h>
+#include <string.h>
+
+#define LEN 16
+#define TIMEOUT_US 200
+
+//1 MHz SCK after SPI1_initHost: 8 bits of 64 cycles
+#define BYTE_CYCLES 512
+
+static testPeer_t peer;
+static uint8_t peerRX[LEN];
+
+//Checks the module after SPI1_recover against the registers before the transfer
+static void checkRecovered(uint8_t con0, uint8_t con1)
+{
+    CHECK_EQUAL(con0, SPI1CON0);
+    CHECK_EQUAL(con1, SPI1CON1);
+    
+    //TXR and RXR kept, SS released
+    CHECK_EQUAL(0x03, SPI1CON2);
+    CHECK(!SPI1CON2bits.SSET);
+    
+    //FIFOs empty, no flag left over
+    CHECK(SPI1STATUSbits.TXBE);
+    CHECK(!SPI1STATUSbits.RXBF);
+    CHECK(!PIR3bits.SPI1RXIF);
+    CHECK_EQUAL(0x00, SPI1INTF);
+}
+
+//Runs a transfer that stalls on FAULT after AFTER bytes
+//Returns the cycles from the stall to the return of SPI1_exchangeBytes
+static uint64_t runFault(sim_fault_t fault, uint32_t after)
+{
+    uint8_t tx[LEN], rx[LEN];
+    
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        tx[i] = (uint8_t) (0xC3 ^ (i * 11));
+    }
+    
+    uint8_t con0 = SPI1CON0;
+    uint8_t con1 = SPI1CON1;
+    
+    sim_clearBusStats(0, 0);
+    sim_setFault(0, 0, fault, after);
+    
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SPI1_TIMEOUT, SPI1_exchangeBytes(tx, rx, LEN));
+    uint64_t end = sim_now();
+    
+    //No byte moves once the fault is due
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK(stats.bytes <= LEN);
+    uint64_t stall = (stats.bytes != 0) ? stats.lastEnd : start;
+    
+    //The timeout restarts on progress and is rounded to a Timer0 tick. The
+    //last progress is the last byte loaded, up to 3 bytes (FIFO and shift
+    //register) before the bus stops
+    uint64_t timeoutCycles = (uint64_t) TIMEOUT_US * SIM_FOSC_HZ / 1000000;
+    uint64_t tickCycles = (uint64_t) SPI_TIMER0_TICK_US * SIM_FOSC_HZ / 1000000;
+    CHECK(end - stall >= timeoutCycles - tickCycles - 3 * BYTE_CYCLES);
+    CHECK(end - stall < 2 * timeoutCycles);
+    
+    checkRecovered(con0, con1);
+    
+    //The next transfer runs as before
+    memset(rx, 0, sizeof (rx));
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, LEN));
+    CHECK_EQUAL(LEN, peer.count);
+    CHECK(memcmp(peerRX, tx, LEN) == 0);
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        CHECK_EQUAL(testReply(i), rx[i]);
+    }
+    
+    return end - stall;
+}
+
+int main(void)
+{
+    sim_reset();
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    SPI1_setTimeout(TIMEOUT_US);
+    
+    static const struct {
+        sim_fault_t fault;
+        const char* name;
+    } faults[] = {
+        {SIM_FAULT_STUCK_BUSY, "stuck BUSY"},
+        {SIM_FAULT_STUCK_TCZIF, "stuck TCZIF"},
+        {SIM_FAULT_STUCK_RXR, "stuck RXR"},
+    };
+    
+    //On the first byte, and part way through the transfer
+    uint64_t cycles[3][2];
+    for (uint8_t f = 0; f < 3; f++)
+    {
+        cycles[f][0] = runFault(faults[f].fault, 0);
+        cycles[f][1] = runFault(faults[f].fault, LEN / 2);
+    }
+    
+    //SPI1_recover on its own
+    uint8_t con0 = SPI1CON0;
+    uint8_t con1 = SPI1CON1;
+    uint64_t start = sim_now();
+    SPI1_recover();
+    uint64_t recoverCycles = sim_now() - start;
+    checkRecovered(con0, con1);
+    
+    REPORT("Stall to SPI1_TIMEOUT with a %u us timeout (first byte / byte %u):", TIMEOUT_US, LEN / 2);
+    for (uint8_t f = 0; f < 3; f++)
+    {
+        REPORT("  %s: %llu / %llu us", faults[f].name,
+               (unsigned long long) (cycles[f][0] * 1000000 / SIM_FOSC_HZ),
+               (unsigned long long) (cycles[f][1] * 1000000 / SIM_FOSC_HZ));
+    }
+    REPORT("SPI1_recover: %llu cycles", (unsigned long long) recoverCycles);
+    
+    return testResult("host_timeout");
+}
@@ -0,0 +1,152 @@
+//Word transfers of the host (SPI1_exchangeWords16/24/32): byte order on the
+//bus and packing into the words in both orders, the pad byte of 24-bit words,
+//in-place exchanges, counts too large for the length, and the CPU time per
+//word against SPI1_exchangeBytes
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <string.h>
+
+#define COUNT 16
+
+static testPeer_t peer;
+static uint8_t peerRX[COUNT * 4];
+
+//Value of word i, before masking to the size
+static uint32_t wordTX(uint16_t i)
+{
+    return 0x8C4A2D17UL ^ (i * 0x01030507UL);
+}
+
+//Word that holds SIZE reply bytes starting at byte INDEX of the frame
+static uint32_t wordRX(uint16_t index, uint8_t size, uint8_t order)
+{
+    uint32_t word = 0;
+    for (uint8_t pos = 0; pos < size; pos++)
+    {
+        uint8_t shift = (order == SPI1_MSB_FIRST) ? (8 * (size - 1 - pos)) : (8 * pos);
+        word |= (uint32_t) testReply(index + pos) << shift;
+    }
+    return word;
+}
+
+//Checks the bytes the peer received for COUNT words of SIZE bytes
+static void checkBus(uint8_t size, uint8_t order)
+{
+    uint32_t mask = (size == 4) ? 0xFFFFFFFFUL : ((1UL << (8 * size)) - 1);
+    
+    for (uint16_t i = 0; i < COUNT; i++)
+    {
+        uint32_t word = wordTX(i) & mask;
+        for (uint8_t pos = 0; pos < size; pos++)
+        {
+            uint8_t shift = (order == SPI1_MSB_FIRST) ? (8 * (size - 1 - pos)) : (8 * pos);
+            CHECK_EQUAL((uint8_t) (word >> shift), peerRX[i * size + pos]);
+        }
+    }
+}
+
+//Runs each size in one order, returns the CPU time of each in FOSC cycles
+static void runOrder(uint8_t order, uint64_t cycles[3])
+{
+    uint16_t tx16[COUNT], rx16[COUNT];
+    uint32_t tx32[COUNT], rx32[COUNT];
+    uint64_t start;
+    
+    for (uint16_t i = 0; i < COUNT; i++)
+    {
+        tx16[i] = (uint16_t) wordTX(i);
+        tx32[i] = wordTX(i);
+    }
+    
+    //16-bit
+    memset(rx16, 0, sizeof (rx16));
+    start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeWords16(tx16, rx16, COUNT, order));
+    cycles[0] = sim_now() - start;
+    checkBus(2, order);
+    for (uint16_t i = 0; i < COUNT; i++)
+    {
+        CHECK_EQUAL(wordRX(i * 2, 2, order), rx16[i]);
+    }
+    
+    //24-bit, the pad byte is cleared
+    memset(rx32, 0xAA, sizeof (rx32));
+    start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeWords24(tx32, rx32, COUNT, order));
+    cycles[1] = sim_now() - start;
+    checkBus(3, order);
+    for (uint16_t i = 0; i < COUNT; i++)
+    {
+        CHECK_EQUAL(wordRX(i * 3, 3, order), rx32[i]);
+    }
+    
+    //24-bit in place: the words are sent before they are replaced
+    memcpy(rx32, tx32, sizeof (rx32));
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeWords24(rx32, rx32, COUNT, order));
+    checkBus(3, order);
+    for (uint16_t i = 0; i < COUNT; i++)
+    {
+        CHECK_EQUAL(wordRX(i * 3, 3, order), rx32[i]);
+    }
+    
+    //32-bit
+    memset(rx32, 0, sizeof (rx32));
+    start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeWords32(tx32, rx32, COUNT, order));
+    cycles[2] = sim_now() - start;
+    checkBus(4, order);
+    for (uint16_t i = 0; i < COUNT; i++)
+    {
+        CHECK_EQUAL(wordRX(i * 4, 4, order), rx32[i]);
+    }
+}
+
+int main(void)
+{
+    sim_reset();
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    
+    //Fastest SCK, so the CPU time per byte shows
+    CHECK(SPI1_setClockFrequency(32000000UL, SIM_FOSC_HZ) != 0);
+    
+    uint64_t msb[3], lsb[3], bytes[3];
+    runOrder(SPI1_MSB_FIRST, msb);
+    runOrder(SPI1_LSB_FIRST, lsb);
+    
+    //The same number of bytes through SPI1_exchangeBytes
+    uint8_t tx[COUNT * 4], rx[COUNT * 4];
+    memset(tx, 0x5A, sizeof (tx));
+    for (uint8_t size = 2; size <= 4; size++)
+    {
+        uint64_t start = sim_now();
+        CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, COUNT * size));
+        bytes[size - 2] = sim_now() - start;
+    }
+    
+    //Counts whose bytes don't fit the 16-bit length (the count used to wrap)
+    uint32_t big[1] = {0};
+    sim_clearBusStats(0, 0);
+    uint16_t frames = peer.frames;
+    CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_exchangeWords16(0, 0, 0x8000, SPI1_MSB_FIRST));
+    CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_exchangeWords24(big, big, 0x5556, SPI1_MSB_FIRST));
+    CHECK_EQUAL(SPI1_BAD_ARGUMENT, SPI1_exchangeWords32(big, big, 0x4000, SPI1_LSB_FIRST));
+    
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(0, stats.bytes);
+    CHECK_EQUAL(frames, peer.frames);
+    
+    REPORT("Cycles per word at 32 MHz SCK (MSB / LSB first, exchangeBytes for the same bytes):");
+    for (uint8_t n = 0; n < 3; n++)
+    {
+        REPORT("  %u-bit: %llu / %llu, exchangeBytes %llu", 16 + 8 * n,
+               (unsigned long long) (msb[n] / COUNT), (unsigned long long) (lsb[n] / COUNT),
+               (unsigned long long) (bytes[n] / COUNT));
+    }
+    
+    return testResult("host_words");
+}
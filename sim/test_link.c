@@ -0,0 +1,120 @@
+//Host firmware (device 0) exchanges frames with client firmware (device 1)
+//over the modelled bus. Both drivers are built unchanged
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <string.h>
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI1_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI1_setStartHandler(void (*callback)(void));
+void dev1_SPI1_setStopHandler(void (*callback)(void));
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+
+static uint8_t clientRX[64];
+static uint8_t clientRXCount = 0;
+static uint8_t clientTXCount = 0;
+static uint8_t clientStarts = 0;
+static uint8_t clientStops = 0;
+
+static void clientReceive(uint8_t data)
+{
+    if (clientRXCount < sizeof (clientRX))
+    {
+        clientRX[clientRXCount] = data;
+    }
+    clientRXCount++;
+}
+
+static uint8_t clientTransmit(void)
+{
+    return 0xA0 + clientTXCount++;
+}
+
+static void clientStart(void)
+{
+    clientStarts++;
+}
+
+static void clientStop(void)
+{
+    clientStops++;
+}
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_setRXHandler(clientReceive);
+    dev1_SPI1_setTXHandler(clientTransmit);
+    dev1_SPI1_setStartHandler(clientStart);
+    dev1_SPI1_setStopHandler(clientStop);
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_enableInterrupts();
+    dev1_Interrupts_enable();
+}
+
+static bool clientStopped(void)
+{
+    return clientStops != 0;
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    //Let the client initialize and prefill its TX FIFO
+    sim_cpu(2000);
+    CHECK_EQUAL(2, clientTXCount);
+    
+    SPI1_initHost();
+    
+    uint8_t tx[8] = {0x10, 0x11, 0x12, 0x13, 0x14, 0x15, 0x16, 0x17};
+    uint8_t rx[8];
+    memset(rx, 0, sizeof (rx));
+    
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, sizeof (tx)));
+    uint64_t cycles = sim_now() - start;
+    
+    CHECK(sim_waitFor(clientStopped, 10000));
+    CHECK_EQUAL(1, clientStarts);
+    CHECK_EQUAL(1, clientStops);
+    
+    //Client received every byte, in order
+    CHECK_EQUAL(8, clientRXCount);
+    CHECK(memcmp(clientRX, tx, sizeof (tx)) == 0);
+    
+    //Host received the client's bytes in order (2 were queued before SS)
+    for (uint8_t i = 0; i < sizeof (rx); i++)
+    {
+        CHECK_EQUAL(0xA0 + i, rx[i]);
+    }
+    
+    sim_busStats_t stats;
+    sim_getBusStats(0, 0, &stats);
+    CHECK_EQUAL(8, stats.bytes);
+    CHECK_EQUAL(1, stats.ssAsserts);
+    
+    //1 MHz SCK: 8 bytes take 512 us of SCK
+    REPORT("8-byte exchange: %llu cycles (%llu clocking, %llu idle between bytes, max gap %llu)",
+           (unsigned long long) cycles, (unsigned long long) stats.busyCycles,
+           (unsigned long long) stats.gapCycles, (unsigned long long) stats.maxGap);
+    
+    return testResult("link");
+}
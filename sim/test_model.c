@@ -0,0 +1,114 @@
+//Checks the register model itself: FIFOs, the transfer counter, TXR / RXR,
+//CLRBF, the interrupt flags and the client start / stop flags
+
+#include "test.h"
+
+#include <xc.h>
+
+static bool hostIdle(void)
+{
+    return !SPI1CON2bits.BUSY;
+}
+
+int main(void)
+{
+    sim_reset();
+    
+    //Host on SPI1 in loopback (no peer), SCK = 64 MHz / 2
+    SPI1CON0 = 0x02;
+    SPI1CON1 = 0x44;
+    SPI1CON2 = 0x03;
+    SPI1CLK = 0x00;
+    SPI1BAUD = 0;
+    SPI1CON0 = 0x82;
+    
+    //Power-on flags
+    CHECK(PIR3bits.SPI1TXIF);
+    CHECK(!PIR3bits.SPI1RXIF);
+    CHECK(SPI1STATUS & 0x20);
+    
+    //Nothing is clocked while the counter is 0
+    SPI1TXB = 0x5A;
+    sim_cpu(200);
+    CHECK(!PIR3bits.SPI1RXIF);
+    
+    //Writing the counter starts the transfer, TCZIF is set after the last byte
+    SPI1INTF = 0x00;
+    SPI1TCNTH = 0;
+    SPI1TCNTL = 2;
+    SPI1TXB = 0xA5;
+    CHECK(sim_waitFor(hostIdle, 1000));
+    CHECK(SPI1INTFbits.TCZIF);
+    
+    //Both bytes looped back, RX FIFO is full
+    CHECK(PIR3bits.SPI1RXIF);
+    CHECK(SPI1STATUS & 0x01);
+    CHECK_EQUAL(0x5A, SPI1RXB);
+    CHECK_EQUAL(0xA5, SPI1RXB);
+    CHECK(!PIR3bits.SPI1RXIF);
+    
+    //TX FIFO holds 2 bytes, a third write sets TXWE
+    SPI1TXB = 1;
+    SPI1TXB = 2;
+    CHECK(!PIR3bits.SPI1TXIF);
+    SPI1TXB = 3;
+    CHECK(SPI1STATUS & 0x80);
+    
+    //CLRBF empties both FIFOs
+    SPI1STATUSbits.CLRBF = 1;
+    CHECK(PIR3bits.SPI1TXIF);
+    CHECK(SPI1STATUS & 0x20);
+    
+    //RXR = 0: received bytes are dropped
+    SPI1CON2 = 0x01;
+    SPI1TCNTL = 1;
+    SPI1TXB = 0x77;
+    CHECK(sim_waitFor(hostIdle, 1000));
+    CHECK(!PIR3bits.SPI1RXIF);
+    
+    //Status interrupt flag follows INTF & INTE
+    SPI1INTF = 0x00;
+    SPI1INTE = 0x40;
+    CHECK(!PIR3bits.SPI1IF);
+    SPI1CON2 = 0x03;
+    SPI1TCNTL = 1;
+    SPI1TXB = 0x00;
+    CHECK(sim_waitFor(hostIdle, 1000));
+    CHECK(PIR3bits.SPI1IF);
+    SPI1INTF = 0x00;
+    CHECK(!PIR3bits.SPI1IF);
+    
+    //Client on SPI2, clocked by the model
+    SPI2CON0 = 0x00;
+    SPI2CON1 = 0x44;
+    SPI2CON2 = 0x03;
+    SPI2INTF = 0x00;
+    SPI2CON0 = 0x80;
+    SPI2TXB = 0xC1;
+    
+    uint8_t mosi[3] = {0x31, 0x32, 0x33};
+    uint8_t miso[3];
+    sim_frame_t frame = {
+        .txData = mosi, .rxData = miso, .len = 3,
+        .bitCycles = 16, .byteGap = 0, .ssLead = 32
+    };
+    CHECK(sim_driveFrame(0, 1, &frame));
+    CHECK(SPI2INTFbits.SOSIF);
+    
+    //Client reads bytes as they come, and falls behind on TX
+    while (sim_isDriving(0, 1))
+    {
+        sim_cpu(8);
+    }
+    CHECK(SPI2INTFbits.EOSIF);
+    CHECK(SPI2INTFbits.TXUIF);
+    CHECK_EQUAL(0xC1, miso[0]);
+    CHECK_EQUAL(0xC1, miso[1]);
+    
+    //Third byte found the RX FIFO full
+    CHECK(SPI2INTFbits.RXOIF);
+    CHECK_EQUAL(0x31, SPI2RXB);
+    CHECK_EQUAL(0x32, SPI2RXB);
+    
+    return testResult("model");
+}
@@ -0,0 +1,182 @@
+//Register map of the client (spi1_regmap.c) with host firmware on the other
+//end: writes with resync on, reads, and the onRead / onWrite hooks, which may
+//only run for bytes the host clocked
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_regmap.h"
+
+#include <xc.h>
+#include <string.h>
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setErrorHandler(void (*callback)(uint8_t));
+void dev1_SPI1_setResync(bool enable);
+uint16_t dev1_SPI1_getTXUnderflowCount(void);
+uint16_t dev1_SPI1_getRXOverflowCount(void);
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+void dev1_SPI1_initRegisterMap(const SPI1_register_t* table, uint8_t count);
+
+#define REG_COUNT 8
+
+static volatile uint8_t regs[REG_COUNT];
+static uint8_t readCount[REG_COUNT];
+static uint8_t writeCount[REG_COUNT];
+static uint8_t errors = 0;
+
+static void onRead(uint8_t address)
+{
+    readCount[address]++;
+}
+
+static void onWrite(uint8_t address, uint8_t value)
+{
+    (void) value;
+    writeCount[address]++;
+}
+
+static void onError(uint8_t error)
+{
+    (void) error;
+    errors++;
+}
+
+//Register 0 is read only, register 7 is write only
+//Filled at run time: the hooks are device 1 code
+static SPI1_register_t table[REG_COUNT];
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_enableInterrupts();
+    dev1_SPI1_setErrorHandler(onError);
+    dev1_SPI1_setResync(true);
+    dev1_SPI1_initRegisterMap(table, REG_COUNT);
+    dev1_Interrupts_enable();
+}
+
+//Writes LEN registers from ADDRESS
+static void writeRegisters(uint8_t address, const uint8_t* data, uint8_t len)
+{
+    uint8_t frame[16];
+    frame[0] = address;
+    memcpy(&frame[1], data, len);
+    CHECK_EQUAL(SPI1_OK, SPI1_sendBytes(frame, len + 1));
+    
+    //Let the client finish the frame
+    sim_cpu(2000);
+}
+
+//Reads LEN registers from ADDRESS
+static void readRegisters(uint8_t address, uint8_t* data, uint8_t len)
+{
+    uint8_t frame[16];
+    memset(frame, 0, sizeof (frame));
+    frame[0] = SPI1_REGMAP_READ | address;
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(frame, frame, len + 1 + SPI1_REGMAP_TURNAROUND));
+    memcpy(data, &frame[1 + SPI1_REGMAP_TURNAROUND], len);
+    
+    sim_cpu(2000);
+}
+
+int main(void)
+{
+    for (uint8_t i = 0; i < REG_COUNT; i++)
+    {
+        table[i] = (SPI1_register_t) {&regs[i], SPI1_REG_READ | SPI1_REG_WRITE, onRead, onWrite};
+    }
+    table[0].flags = SPI1_REG_READ;
+    table[7].flags = SPI1_REG_WRITE;
+    regs[0] = 0x71;
+    
+    sim_reset();
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    sim_cpu(5000);
+    SPI1_initHost();
+    
+    //Write registers 1 to 6, longer than the TX FIFO, with resync on
+    const uint8_t values[] = {0x11, 0x22, 0x33, 0x44, 0x55, 0x66};
+    writeRegisters(1, values, sizeof (values));
+    for (uint8_t i = 0; i < sizeof (values); i++)
+    {
+        CHECK_EQUAL(values[i], regs[1 + i]);
+        CHECK_EQUAL(1, writeCount[1 + i]);
+    }
+    CHECK_EQUAL(0, errors);
+    CHECK_EQUAL(0, dev1_SPI1_getTXUnderflowCount());
+    
+    //Read only register is not written
+    uint8_t data[8];
+    data[0] = 0xEE;
+    writeRegisters(0, data, 1);
+    CHECK_EQUAL(0x71, regs[0]);
+    CHECK_EQUAL(0, writeCount[0]);
+    
+    //Read back, straight after a write
+    memset(data, 0, sizeof (data));
+    readRegisters(0, data, 7);
+    CHECK_EQUAL(0x71, data[0]);
+    for (uint8_t i = 0; i < sizeof (values); i++)
+    {
+        CHECK_EQUAL(values[i], data[1 + i]);
+    }
+    
+    //onRead ran once for each register the host clocked, none past the end
+    for (uint8_t i = 0; i < REG_COUNT; i++)
+    {
+        CHECK_EQUAL((i < 7) ? 1 : 0, readCount[i]);
+    }
+    
+    //Short read, then reads of the write only register and past the table
+    memset(readCount, 0, sizeof (readCount));
+    readRegisters(3, data, 1);
+    CHECK_EQUAL(0x33, data[0]);
+    readRegisters(6, data, 4);
+    CHECK_EQUAL(0x66, data[0]);
+    CHECK_EQUAL(SPI1_REGMAP_FILL, data[1]);
+    CHECK_EQUAL(SPI1_REGMAP_FILL, data[2]);
+    CHECK_EQUAL(SPI1_REGMAP_FILL, data[3]);
+    for (uint8_t i = 0; i < REG_COUNT; i++)
+    {
+        CHECK_EQUAL(((i == 3) || (i == 6)) ? 1 : 0, readCount[i]);
+    }
+    
+    //No FIFO errors in any frame
+    CHECK_EQUAL(0, errors);
+    CHECK_EQUAL(0, dev1_SPI1_getTXUnderflowCount());
+    CHECK_EQUAL(0, dev1_SPI1_getRXOverflowCount());
+    
+    //Fastest SCK at which a read still returns the right data
+    uint8_t fastest = 0xFF;
+    for (uint8_t baud = 31; baud != 0xFF; baud--)
+    {
+        SPI1BAUD = baud;
+        memset(data, 0, sizeof (data));
+        readRegisters(1, data, 6);
+        if (memcmp(data, values, sizeof (values)) != 0)
+        {
+            break;
+        }
+        fastest = baud;
+    }
+    CHECK(fastest != 0xFF);
+    
+    REPORT("Reads are correct down to BAUD %u (%lu Hz SCK)", fastest, 64000000UL / (2UL * (fastest + 1)));
+    
+    return testResult("regmap");
+}
@@ -0,0 +1,147 @@
+//Resync of the client (SPI1_setResync) with host firmware on the other end:
+//a frame damaged by a slow RX handler is dropped, and the next frame starts
+//with the TX bytes loaded before SS was asserted, with no further errors
+
+#include "test.h"
+#include "spi1_host.h"
+
+#include <string.h>
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI1_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI1_setStartHandler(void (*callback)(void));
+void dev1_SPI1_setErrorHandler(void (*callback)(uint8_t));
+void dev1_SPI1_setResync(bool enable);
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+
+#define LEN 16
+
+//Cycles burnt by the RX handler (device 1)
+static volatile uint32_t rxDelay = 0;
+
+//Client side of the current frame
+static uint8_t txNext = 0;
+static uint8_t clientRX[LEN];
+static volatile uint8_t clientRXCount = 0;
+static volatile uint8_t errors = 0;
+
+static void clientReceive(uint8_t data)
+{
+    if (clientRXCount < LEN)
+    {
+        clientRX[clientRXCount] = data;
+    }
+    clientRXCount++;
+    
+    if (rxDelay != 0)
+    {
+        sim_cpu(rxDelay);
+    }
+}
+
+//Sends a running count, so the host can tell where each byte came from
+static uint8_t clientTransmit(void)
+{
+    return txNext++;
+}
+
+static void clientStart(void)
+{
+    clientRXCount = 0;
+}
+
+static void clientError(uint8_t flags)
+{
+    (void) flags;
+    errors++;
+}
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_setRXHandler(clientReceive);
+    dev1_SPI1_setTXHandler(clientTransmit);
+    dev1_SPI1_setStartHandler(clientStart);
+    dev1_SPI1_setErrorHandler(clientError);
+    dev1_SPI1_setResync(true);
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_enableInterrupts();
+    dev1_Interrupts_enable();
+}
+
+static void frame(uint8_t* tx, uint8_t* rx)
+{
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(tx, rx, LEN));
+    
+    //Let the client finish the frame and load the next one
+    sim_cpu(3000);
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    sim_cpu(5000);
+    SPI1_initHost();
+    
+    uint8_t tx[LEN], rx[LEN];
+    for (uint8_t i = 0; i < LEN; i++)
+    {
+        tx[i] = (uint8_t) (0x40 + i);
+    }
+    
+    //A clean frame: the count runs through the frame
+    frame(tx, rx);
+    CHECK_EQUAL(0, errors);
+    CHECK_EQUAL(LEN, clientRXCount);
+    for (uint8_t i = 1; i < LEN; i++)
+    {
+        CHECK_EQUAL((uint8_t) (rx[0] + i), rx[i]);
+    }
+    
+    //An RX handler taking 4 byte times (1 MHz SCK, 512 cycles per byte)
+    //The FIFOs overflow and underflow, and the rest of the frame is dropped
+    rxDelay = 2048;
+    frame(tx, rx);
+    
+    //The client is still working through the bytes it did receive
+    sim_cpu(20000);
+    rxDelay = 0;
+    CHECK(errors != 0);
+    CHECK(clientRXCount < LEN);
+    
+    //The frames after it are clean: no errors, the count runs from the first
+    //byte (loaded before SS was asserted), and every host byte is received
+    uint8_t damaged = errors;
+    for (uint8_t n = 0; n < 3; n++)
+    {
+        memset(rx, 0, sizeof (rx));
+        frame(tx, rx);
+        CHECK_EQUAL(damaged, errors);
+        CHECK_EQUAL(LEN, clientRXCount);
+        CHECK(memcmp(clientRX, tx, LEN) == 0);
+        for (uint8_t i = 1; i < LEN; i++)
+        {
+            CHECK_EQUAL((uint8_t) (rx[0] + i), rx[i]);
+        }
+    }
+    
+    REPORT("Damaged frame: %u error events, recovered at the next frame", damaged);
+    
+    return testResult("resync");
+}
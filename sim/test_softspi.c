@@ -0,0 +1,146 @@
+//Software SPI host (softspi.c) on the model's port D: idle levels, SCK and SS
+//edges, loopback through wired pins, lockstep lanes kept apart, and the bit
+//rate of each transfer function under the model's CPU costs, against the
+//hardware module (SPI1_exchangeBytes) at its fastest SCK
+
+#include "test.h"
+#include "softspi.h"
+#include "spi1_host.h"
+
+#include <string.h>
+
+#define LEN 256
+
+static uint8_t tx[LEN], rx[LEN];
+
+//Runs a transfer and returns its time in FOSC cycles
+static uint64_t timed(SOFTSPI_result_t (*run)(void))
+{
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SOFTSPI_OK, run());
+    return sim_now() - start;
+}
+
+static SOFTSPI_result_t runExchange(void)
+{
+    return SOFTSPI_exchangeBytes(&tx[0], &rx[0], LEN);
+}
+
+static SOFTSPI_result_t runSend(void)
+{
+    return SOFTSPI_sendBytes(&tx[0], LEN);
+}
+
+static SOFTSPI_result_t runReceive(void)
+{
+    return SOFTSPI_receiveBytes(&rx[0], LEN);
+}
+
+static SOFTSPI_result_t runLockstep(void)
+{
+    return SOFTSPI_exchangeLockstep(&tx[0], &rx[0], LEN / SOFTSPI_LANES);
+}
+
+//Achieved bit rate of BYTES in CYCLES
+static unsigned long bitRate(uint64_t cycles, uint32_t bytes)
+{
+    return (unsigned long) ((uint64_t) bytes * 8 * SIM_FOSC_HZ / cycles);
+}
+
+int main(void)
+{
+    sim_reset();
+    
+    SOFTSPI_initPins();
+    SOFTSPI_initHost();
+    
+    //Mode 0 idles with SCK low, SS is active low
+    CHECK_EQUAL(0, sim_pinLevel(0, SIM_PORT_D, SOFTSPI_SCK_BIT));
+    CHECK_EQUAL(1, sim_pinLevel(0, SIM_PORT_D, SOFTSPI_SS_BIT));
+    CHECK_EQUAL(0, sim_pinLevel(0, SIM_PORT_D, SOFTSPI_SDO_BIT));
+    
+    sim_watchPin(0, SIM_PORT_D, SOFTSPI_SCK_BIT);
+    sim_watchPin(0, SIM_PORT_D, SOFTSPI_SS_BIT);
+    
+    for (uint16_t i = 0; i < LEN; i++)
+    {
+        tx[i] = (uint8_t) (i * 37 + 5);
+    }
+    
+    //SDI is not wired yet, so it reads the pull-up
+    memset(rx, 0, sizeof (rx));
+    uint64_t receiveCycles = timed(runReceive);
+    for (uint16_t i = 0; i < LEN; i++)
+    {
+        CHECK_EQUAL(0xFF, rx[i]);
+    }
+    CHECK_EQUAL(0, sim_pinLevel(0, SIM_PORT_D, SOFTSPI_SDO_BIT));
+    
+    //1 falling SCK edge per bit, 1 SS assertion per call
+    CHECK_EQUAL(LEN * 8, sim_getPinFalls(0, SIM_PORT_D, SOFTSPI_SCK_BIT));
+    CHECK_EQUAL(1, sim_getPinFalls(0, SIM_PORT_D, SOFTSPI_SS_BIT));
+    
+    //Loopback: SDO to SDI
+    sim_wire(0, SIM_PORT_D, SOFTSPI_SDO_BIT, SOFTSPI_SDI_BIT);
+    memset(rx, 0, sizeof (rx));
+    uint64_t exchangeCycles = timed(runExchange);
+    CHECK_EQUAL(0, memcmp(tx, rx, LEN));
+    CHECK_EQUAL(LEN * 8 * 2, sim_getPinFalls(0, SIM_PORT_D, SOFTSPI_SCK_BIT));
+    CHECK_EQUAL(2, sim_getPinFalls(0, SIM_PORT_D, SOFTSPI_SS_BIT));
+    CHECK_EQUAL(0, sim_pinLevel(0, SIM_PORT_D, SOFTSPI_SCK_BIT));
+    CHECK_EQUAL(1, sim_pinLevel(0, SIM_PORT_D, SOFTSPI_SS_BIT));
+    
+    CHECK_EQUAL(0xA5, SOFTSPI_exchangeByte(0xA5));
+    CHECK_EQUAL(0x01, SOFTSPI_exchangeByte(0x01));
+    
+    uint64_t sendCycles = timed(runSend);
+    
+    //Lockstep lanes, wired across: lane 0 receives what lane 1 sends and the
+    //other way round, so bytes can't come back from their own lane
+    sim_wire(0, SIM_PORT_D, SOFTSPI_LANE1_SDO_BIT, SOFTSPI_SDI_BIT);
+    sim_wire(0, SIM_PORT_D, SOFTSPI_SDO_BIT, SOFTSPI_LANE1_SDI_BIT);
+    memset(rx, 0, sizeof (rx));
+    uint32_t falls = sim_getPinFalls(0, SIM_PORT_D, SOFTSPI_SCK_BIT);
+    uint64_t lockstepCycles = timed(runLockstep);
+    for (uint16_t i = 0; i < LEN; i += 2)
+    {
+        CHECK_EQUAL(tx[i + 1], rx[i]);
+        CHECK_EQUAL(tx[i], rx[i + 1]);
+    }
+    CHECK_EQUAL((LEN / SOFTSPI_LANES) * 8, sim_getPinFalls(0, SIM_PORT_D, SOFTSPI_SCK_BIT) - falls);
+    
+    //Send and receive only skip half of each bit, and the same bytes split
+    //across the lanes take less time than on 1 bus
+    CHECK(sendCycles < exchangeCycles);
+    CHECK(receiveCycles < exchangeCycles);
+    CHECK(lockstepCycles < exchangeCycles);
+    
+    //The same bytes through the SPI1 module at its fastest SCK (FOSC / 2)
+    static testPeer_t peer;
+    static uint8_t peerRX[LEN];
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    SPI1_initHost();
+    CHECK_EQUAL(SIM_FOSC_HZ / 2, SPI1_setClockFrequency(SIM_FOSC_HZ / 2, SIM_FOSC_HZ));
+    
+    memset(rx, 0, sizeof (rx));
+    uint64_t start = sim_now();
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(&tx[0], &rx[0], LEN));
+    uint64_t hardwareCycles = sim_now() - start;
+    CHECK_EQUAL(0, memcmp(tx, peerRX, LEN));
+    for (uint16_t i = 0; i < LEN; i++)
+    {
+        CHECK_EQUAL(testReply(i), rx[i]);
+    }
+    CHECK(hardwareCycles < exchangeCycles);
+    
+    REPORT("%u bytes, model costs (%u cycles per register access):", LEN, sim_costs.access);
+    REPORT("  exchangeBytes: %lu bit/s", bitRate(exchangeCycles, LEN));
+    REPORT("  sendBytes: %lu bit/s", bitRate(sendCycles, LEN));
+    REPORT("  receiveBytes: %lu bit/s", bitRate(receiveCycles, LEN));
+    REPORT("  exchangeLockstep: %lu bit/s (%u lanes)", bitRate(lockstepCycles, LEN), SOFTSPI_LANES);
+    REPORT("  SPI1_exchangeBytes at %lu MHz SCK: %lu bit/s, %lu.%lux SOFTSPI_exchangeBytes",
+           (unsigned long) (SIM_FOSC_HZ / 2000000), bitRate(hardwareCycles, LEN),
+           (unsigned long) (exchangeCycles / hardwareCycles), (unsigned long) ((exchangeCycles * 10 / hardwareCycles) % 10));
+    
+    return testResult("softspi");
+}
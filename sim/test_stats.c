@@ -0,0 +1,146 @@
+//ISR statistics of the client (SPI1_ISR_STATS) with host firmware on the
+//other end: frame sizes, ISR times against the model's clock, and overflow /
+//underflow counts when the RX handler is too slow
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_client.h"
+
+#include <string.h>
+
+//Client firmware, renamed by the Makefile
+void dev1_SPI1_initClient(void);
+void dev1_SPI1_enableTransmit(void);
+void dev1_SPI1_enableReceive(void);
+void dev1_SPI1_enableInterrupts(void);
+void dev1_SPI1_setTXHandler(uint8_t (*callback)(void));
+void dev1_SPI1_setRXHandler(void (*callback)(uint8_t));
+void dev1_SPI1_initStats(void);
+void dev1_SPI1_getStats(SPI1_stats_t* stats);
+uint16_t dev1_SPI1_getAverageISRCycles(void);
+void dev1_Interrupts_enable(void);
+void dev1_SPI_readTX_ISR(void);
+void dev1_SPI_readRX_ISR(void);
+void dev1_SPI_status_ISR(void);
+
+//Cycles burnt by the RX handler (device 1)
+static volatile uint32_t rxDelay = 0;
+
+//Stats requested by the test, copied by the client main loop
+static volatile bool statsRequest = false;
+static SPI1_stats_t stats;
+static uint16_t average;
+
+static void clientReceive(uint8_t data)
+{
+    (void) data;
+    
+    if (rxDelay != 0)
+    {
+        sim_cpu(rxDelay);
+    }
+}
+
+static uint8_t clientTransmit(void)
+{
+    return 0x5A;
+}
+
+//Runs on device 1
+static void clientMain(void)
+{
+    dev1_SPI1_initClient();
+    dev1_SPI1_setRXHandler(clientReceive);
+    dev1_SPI1_setTXHandler(clientTransmit);
+    dev1_SPI1_enableReceive();
+    dev1_SPI1_enableTransmit();
+    dev1_SPI1_initStats();
+    dev1_SPI1_enableInterrupts();
+    dev1_Interrupts_enable();
+    
+    while (true)
+    {
+        if (statsRequest)
+        {
+            dev1_SPI1_getStats(&stats);
+            average = dev1_SPI1_getAverageISRCycles();
+            statsRequest = false;
+        }
+        
+        sim_cpu(20);
+    }
+}
+
+static bool statsCopied(void)
+{
+    return !statsRequest;
+}
+
+static void readStats(void)
+{
+    statsRequest = true;
+    CHECK(sim_waitFor(statsCopied, 100000));
+}
+
+static void frame(uint8_t len)
+{
+    uint8_t data[32];
+    memset(data, 0xA5, sizeof (data));
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(data, data, len));
+    
+    //Let the client finish the frame
+    sim_cpu(3000);
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(1, SIM_IRQ_SPI1TX, dev1_SPI_readTX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1RX, dev1_SPI_readRX_ISR);
+    sim_setVector(1, SIM_IRQ_SPI1, dev1_SPI_status_ISR);
+    sim_link(0, 0, 1, 0, SIM_SS_MODULE, 0);
+    sim_start(1, clientMain);
+    
+    sim_cpu(5000);
+    SPI1_initHost();
+    
+    //Frame sizes
+    frame(8);
+    frame(20);
+    frame(5);
+    readStats();
+    CHECK_EQUAL(5, stats.lastFrameBytes);
+    CHECK_EQUAL(20, stats.maxFrameBytes);
+    CHECK_EQUAL(0, stats.rxOverflows);
+    CHECK_EQUAL(0, stats.txUnderflows);
+    
+    //1 RX and 1 TX ISR per byte (2 TX ISRs load the FIFO before the first
+    //frame), and a start and a stop ISR per frame, without start or stop
+    //handlers
+    CHECK_EQUAL(33 + 35 + 6, stats.isrCount);
+    CHECK(stats.maxISRCycles != 0);
+    CHECK(average <= stats.maxISRCycles);
+    CHECK_EQUAL(stats.totalISRCycles / stats.isrCount, average);
+    uint16_t fastMax = stats.maxISRCycles;
+    uint16_t fastAverage = average;
+    
+    //An RX handler taking 4 byte times (1 MHz SCK, 512 cycles per byte)
+    rxDelay = 2048;
+    frame(8);
+    rxDelay = 0;
+    readStats();
+    //Bytes received while the ISR was running were lost
+    CHECK(stats.lastFrameBytes < 8);
+    CHECK(stats.rxOverflows != 0);
+    CHECK(stats.txUnderflows != 0);
+    
+    //The longest ISR covers the delay (Timer1 counts FOSC / 4)
+    CHECK(stats.maxISRCycles >= 2048 / 4);
+    CHECK(stats.maxISRCycles < (2048 / 4) + fastMax);
+    
+    REPORT("Byte ISRs: longest %u cycles, average %u cycles (FOSC)", fastMax * 4, fastAverage * 4);
+    REPORT("Slow RX handler: %u bytes received of 8, %u overflows, %u underflows",
+           stats.lastFrameBytes, stats.rxOverflows, stats.txUnderflows);
+    
+    return testResult("stats");
+}
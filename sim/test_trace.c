@@ -0,0 +1,196 @@
+//Bus trace of the host (SPI1_TRACE): in place exchanges recorded with the
+//bytes sent, segment lists recorded as 1 transfer, queued transactions, and
+//timestamps that keep counting across Timer0 overflows. The dump is written
+//to TRACE_LOG and decoded by tools/spi_trace_decode.c (TRACE_DECODE)
+
+//popen
+#define _POSIX_C_SOURCE 200809L
+
+#include "test.h"
+#include "spi1_host.h"
+#include "spi1_trace.h"
+#include "interrupts.h"
+
+#include <stdio.h>
+#include <string.h>
+
+//Vectors of spi1_host.c and spi1_trace.c
+void SPI1_TX_ISR(void);
+void SPI1_RX_ISR(void);
+void SPI1_status_ISR(void);
+void SPI1_traceTimer_ISR(void);
+
+#define HEADER_SIZE 10
+#define RECORD_SIZE (8 + SPI1_TRACE_DATA_BYTES)
+#define HALF (SPI1_TRACE_DATA_BYTES / 2)
+
+static testPeer_t peer;
+static uint8_t peerRX[32];
+
+static uint8_t dump[HEADER_SIZE + SPI1_TRACE_RECORDS * RECORD_SIZE];
+static uint16_t dumpLen = 0;
+
+static void putChar(char c)
+{
+    if (dumpLen < sizeof (dump))
+    {
+        dump[dumpLen++] = (uint8_t) c;
+    }
+}
+
+static const uint8_t* record(uint8_t n)
+{
+    return &dump[HEADER_SIZE + n * RECORD_SIZE];
+}
+
+static uint32_t recordTime(uint8_t n)
+{
+    const uint8_t* r = record(n);
+    return r[0] | ((uint32_t) r[1] << 8) | ((uint32_t) r[2] << 16) | ((uint32_t) r[3] << 24);
+}
+
+static uint16_t recordLen(uint8_t n)
+{
+    return record(n)[6] | ((uint16_t) record(n)[7] << 8);
+}
+
+static bool idle(void)
+{
+    return !SPI1_isBusy();
+}
+
+int main(void)
+{
+    sim_reset();
+    sim_setVector(0, SIM_IRQ_SPI1TX, SPI1_TX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1RX, SPI1_RX_ISR);
+    sim_setVector(0, SIM_IRQ_SPI1, SPI1_status_ISR);
+    sim_setVector(0, SIM_IRQ_TMR0, SPI1_traceTimer_ISR);
+    testPeer_attach(&peer, 0, peerRX, sizeof (peerRX));
+    
+    SPI1_initHost();
+    SPI1_initTrace();
+    Interrupts_enable();
+    
+    //0: in place exchange
+    uint8_t buffer[6] = {0x11, 0x12, 0x13, 0x14, 0x15, 0x16};
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(buffer, buffer, sizeof (buffer)));
+    
+    //1: the same, 500 ms later (Timer0 overflows every 262 ms)
+    uint64_t start = sim_now();
+    sim_cpu(SIM_FOSC_HZ / 2);
+    uint8_t again[6] = {0x21, 0x22, 0x23, 0x24, 0x25, 0x26};
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeBytes(again, again, sizeof (again)));
+    uint64_t gap = sim_now() - start;
+    
+    //2: segment list - constant header, fill bytes, in place bytes
+    static const uint8_t header[2] = {0x02, 0x10};
+    uint8_t status[3];
+    uint8_t inPlace[2] = {0xB0, 0xB1};
+    SPI1_segment_t packet[] = {
+        {&header[0], 0, sizeof (header)},
+        {0, &status[0], sizeof (status)},
+        {&inPlace[0], &inPlace[0], sizeof (inPlace)}
+    };
+    CHECK_EQUAL(SPI1_OK, SPI1_exchangeSegments(&packet[0], 3));
+    CHECK_EQUAL(7, peer.count);
+    
+    //3: queued in place transaction
+    uint8_t queued[5] = {0x31, 0x32, 0x33, 0x34, 0x35};
+    SPI1_transaction_t transaction = {
+        .txData = queued, .rxData = queued, .len = sizeof (queued), .cs = 2,
+        .flags = SPI1_XFER_TX | SPI1_XFER_RX, .callback = 0
+    };
+    CHECK(SPI1_queueTransaction(&transaction));
+    CHECK(sim_waitFor(idle, 100000));
+    
+    SPI1_traceDump(putChar);
+    CHECK_EQUAL(2, dump[4]);
+    CHECK_EQUAL(4, dump[7]);
+    CHECK_EQUAL(HEADER_SIZE + 4 * RECORD_SIZE, dumpLen);
+    
+    //Exchanges in place record the bytes sent, not the ones received over them
+    const uint8_t sent0[HALF] = {0x11, 0x12, 0x13, 0x14};
+    CHECK_EQUAL(SPI1_TRACE_TX | SPI1_TRACE_RX, record(0)[4] & 0x0F);
+    CHECK_EQUAL(0, memcmp(sent0, &record(0)[8], HALF));
+    for (uint8_t i = 0; i < HALF; i++)
+    {
+        CHECK_EQUAL(testReply(i), record(0)[8 + HALF + i]);
+    }
+    
+    const uint8_t sent1[HALF] = {0x21, 0x22, 0x23, 0x24};
+    CHECK_EQUAL(0, memcmp(sent1, &record(1)[8], HALF));
+    
+    //Time between the records, within a transfer of the gap
+    uint32_t ticks = recordTime(1) - recordTime(0);
+    uint32_t expected = (uint32_t) (gap * 1000000 / SIM_FOSC_HZ / SPI1_TRACE_TICK_US);
+    CHECK(ticks > 0xFFFF);
+    CHECK((ticks <= expected) && (ticks + 20 >= expected));
+    
+    //The whole segment list, with the fill bytes it sent and every byte received
+    CHECK_EQUAL(7, recordLen(2));
+    CHECK_EQUAL(SPI1_TRACE_TX | SPI1_TRACE_RX, record(2)[4] & 0x0F);
+    const uint8_t sent2[HALF] = {0x02, 0x10, SPI1_SEGMENT_FILL, SPI1_SEGMENT_FILL};
+    CHECK_EQUAL(0, memcmp(sent2, &record(2)[8], HALF));
+    for (uint8_t i = 0; i < HALF; i++)
+    {
+        CHECK_EQUAL(testReply(i), record(2)[8 + HALF + i]);
+    }
+    
+    //Queued transactions also record the bytes sent
+    CHECK_EQUAL(SPI1_TRACE_TX | SPI1_TRACE_RX | SPI1_TRACE_ASYNC, record(3)[4] & 0x0F);
+    CHECK_EQUAL(2, record(3)[5]);
+    const uint8_t sent3[HALF] = {0x31, 0x32, 0x33, 0x34};
+    CHECK_EQUAL(0, memcmp(sent3, &record(3)[8], HALF));
+    CHECK(queued[0] != 0x31);
+    
+    //The decoder reads the dump back: header, then 1 line per record
+    FILE* file = fopen(TRACE_LOG, "wb");
+    CHECK(file != 0);
+    if (file != 0)
+    {
+        fwrite(dump, 1, dumpLen, file);
+        fclose(file);
+    }
+    
+    FILE* decoded = popen(TRACE_DECODE " " TRACE_LOG, "r");
+    CHECK(decoded != 0);
+    char lines[5][160];
+    uint8_t lineCount = 0;
+    if (decoded != 0)
+    {
+        char line[160];
+        while (fgets(line, sizeof (line), decoded) != 0)
+        {
+            if (lineCount < 5)
+            {
+                strcpy(lines[lineCount], line);
+            }
+            lineCount++;
+        }
+        CHECK_EQUAL(0, pclose(decoded));
+    }
+    CHECK_EQUAL(5, lineCount);
+    
+    if (lineCount == 5)
+    {
+        char expectedLine[160];
+        snprintf(expectedLine, sizeof (expectedLine), "trace v2: 4 records, %u data bytes, %u us/tick\n",
+                 SPI1_TRACE_DATA_BYTES, (unsigned) SPI1_TRACE_TICK_US);
+        CHECK(strcmp(lines[0], expectedLine) == 0);
+        
+        //Time since the previous record across the Timer0 overflows
+        snprintf(expectedLine, sizeof (expectedLine), "(+%lu)", (unsigned long) (ticks * SPI1_TRACE_TICK_US));
+        CHECK(strstr(lines[2], expectedLine) != 0);
+        CHECK(strstr(lines[1], "host   XCHG") != 0);
+        CHECK(strstr(lines[1], "tx 11 12 13 14  rx") != 0);
+        CHECK(strstr(lines[3], "len     7 OK") != 0);
+        CHECK(strstr(lines[4], "async") != 0);
+        CHECK(strstr(lines[4], "dev  2") != 0);
+    }
+    
+    REPORT("Records %lu ticks apart after a %llu ms gap (%u Timer0 overflows)",
+           (unsigned long) ticks, (unsigned long long) (gap * 1000 / SIM_FOSC_HZ), (unsigned) (ticks >> 16));
+    
+    return testResult("trace");
+}
@@ -0,0 +1,649 @@
+//Stand-in for the XC8 device header, used to build the drivers on a PC
+//Every register is an access through the model in sim.c (see sim.h)
+//Register and bit names follow the PIC18F56Q71 header
+
+#ifndef SIM_XC_H
+#define	SIM_XC_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "sim.h"
+
+//24-bit DMA source addresses hold a full pointer
+typedef uintptr_t uint24_t;
+
+//Compiler extensions
+#define __interrupt(...)
+#define asm(x)
+#define __at(x)
+
+#define SIM_REG8(name) (*sim_reg8(SIM_R_ ## name))
+#define SIM_REG16(name) (*sim_reg16(SIM_W_ ## name))
+#define SIM_REGPTR(name) (*sim_regPtr(SIM_P_ ## name))
+#define SIM_BITS(name, type) (*(volatile type*) sim_reg8(SIM_R_ ## name))
+#define SIM_BIT(name, bit) (((volatile sim_bits_t*) sim_reg8(SIM_R_ ## name))->b ## bit)
+
+//Single bits of any register. Bits that are also members of a bits struct
+//(GIE, SPI1RXIF, ...) have no single-bit symbol, since the macro would
+//rename the member
+typedef struct {
+    uint8_t b0 : 1;
+    uint8_t b1 : 1;
+    uint8_t b2 : 1;
+    uint8_t b3 : 1;
+    uint8_t b4 : 1;
+    uint8_t b5 : 1;
+    uint8_t b6 : 1;
+    uint8_t b7 : 1;
+} sim_bits_t;
+
+//Bit layouts
+typedef struct {
+    uint8_t BMODE : 1;
+    uint8_t MST : 1;
+    uint8_t LSBF : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t EN : 1;
+} SPIxCON0bits_t;
+
+typedef struct {
+    uint8_t SDOP : 1;
+    uint8_t SDIP : 1;
+    uint8_t SSP : 1;
+    uint8_t : 1;
+    uint8_t FST : 1;
+    uint8_t CKP : 1;
+    uint8_t CKE : 1;
+    uint8_t SMP : 1;
+} SPIxCON1bits_t;
+
+typedef struct {
+    uint8_t TXR : 1;
+    uint8_t RXR : 1;
+    uint8_t SSET : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t SSFLT : 1;
+    uint8_t BUSY : 1;
+} SPIxCON2bits_t;
+
+typedef struct {
+    uint8_t RXBF : 1;
+    uint8_t : 1;
+    uint8_t CLRBF : 1;
+    uint8_t RXRE : 1;
+    uint8_t : 1;
+    uint8_t TXBE : 1;
+    uint8_t : 1;
+    uint8_t TXWE : 1;
+} SPIxSTATUSbits_t;
+
+typedef struct {
+    uint8_t : 1;
+    uint8_t TXUIF : 1;
+    uint8_t RXOIF : 1;
+    uint8_t : 1;
+    uint8_t EOSIF : 1;
+    uint8_t SOSIF : 1;
+    uint8_t TCZIF : 1;
+    uint8_t SRMTIF : 1;
+} SPIxINTFbits_t;
+
+//SPI1INTF also has the SPI1 prefixed start and end of SS names of the device
+//header
+typedef union {
+    struct {
+        uint8_t : 1;
+        uint8_t TXUIF : 1;
+        uint8_t RXOIF : 1;
+        uint8_t : 1;
+        uint8_t EOSIF : 1;
+        uint8_t SOSIF : 1;
+        uint8_t TCZIF : 1;
+        uint8_t SRMTIF : 1;
+    };
+    struct {
+        uint8_t : 1;
+        uint8_t : 1;
+        uint8_t : 1;
+        uint8_t : 1;
+        uint8_t SPI1EOSIF : 1;
+        uint8_t SPI1SOSIF : 1;
+        uint8_t : 1;
+        uint8_t : 1;
+    };
+} SPI1INTFbits_t;
+
+typedef struct {
+    uint8_t : 1;
+    uint8_t TXUIE : 1;
+    uint8_t RXOIE : 1;
+    uint8_t : 1;
+    uint8_t EOSIE : 1;
+    uint8_t SOSIE : 1;
+    uint8_t TCZIE : 1;
+    uint8_t SRMTIE : 1;
+} SPIxINTEbits_t;
+
+typedef struct {
+    uint8_t : 1;
+    uint8_t SPI1RXIF : 1;
+    uint8_t SPI1TXIF : 1;
+    uint8_t SPI1IF : 1;
+    uint8_t TMR1IF : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t TMR0IF : 1;
+} PIR3bits_t;
+
+typedef struct {
+    uint8_t : 1;
+    uint8_t SPI1RXIE : 1;
+    uint8_t SPI1TXIE : 1;
+    uint8_t SPI1IE : 1;
+    uint8_t TMR1IE : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t TMR0IE : 1;
+} PIE3bits_t;
+
+typedef struct {
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t SPI2RXIF : 1;
+    uint8_t SPI2TXIF : 1;
+    uint8_t SPI2IF : 1;
+    uint8_t : 1;
+} PIR7bits_t;
+
+typedef struct {
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t SPI2RXIE : 1;
+    uint8_t SPI2TXIE : 1;
+    uint8_t SPI2IE : 1;
+    uint8_t : 1;
+} PIE7bits_t;
+
+typedef struct {
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t IPEN : 1;
+    uint8_t : 1;
+    uint8_t GIE : 1;
+} INTCON0bits_t;
+
+typedef struct {
+    uint8_t IVTLOCKED : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+} IVTLOCKbits_t;
+
+typedef struct {
+    uint8_t PRLOCKED : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+} PRLOCKbits_t;
+
+typedef struct {
+    uint8_t XIP : 1;
+    uint8_t : 1;
+    uint8_t AIRQEN : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t DGO : 1;
+    uint8_t SIRQEN : 1;
+    uint8_t EN : 1;
+} DMAnCON0bits_t;
+
+typedef struct {
+    uint8_t FULL : 1;
+    uint8_t SHIFTM : 1;
+    uint8_t : 1;
+    uint8_t : 1;
+    uint8_t ACCM : 1;
+    uint8_t BUSY : 1;
+    uint8_t GO : 1;
+    uint8_t EN : 1;
+} CRCCON0bits_t;
+
+typedef struct {
+    uint8_t SSTP : 1;
+    uint8_t SMODE : 2;
+    uint8_t SMR : 2;
+    uint8_t DSTP : 1;
+    uint8_t DMODE : 2;
+} DMAnCON1bits_t;
+
+typedef struct {
+    uint8_t OUTPS : 4;
+    uint8_t MD16 : 1;
+    uint8_t OUT : 1;
+    uint8_t : 1;
+    uint8_t EN : 1;
+} T0CON0bits_t;
+
+typedef struct {
+    uint8_t CKPS : 4;
+    uint8_t ASYNC : 1;
+    uint8_t CS : 3;
+} T0CON1bits_t;
+
+typedef struct {
+    uint8_t ON : 1;
+    uint8_t RD16 : 1;
+    uint8_t nSYNC : 1;
+    uint8_t : 1;
+    uint8_t CKPS : 2;
+    uint8_t : 2;
+} T1CONbits_t;
+
+//SPI1
+#define SPI1CON0 SIM_REG8(SPI1CON0)
+#define SPI1CON1 SIM_REG8(SPI1CON1)
+#define SPI1CON2 SIM_REG8(SPI1CON2)
+#define SPI1STATUS SIM_REG8(SPI1STATUS)
+#define SPI1INTF SIM_REG8(SPI1INTF)
+#define SPI1INTE SIM_REG8(SPI1INTE)
+#define SPI1RXB SIM_REG8(SPI1RXB)
+#define SPI1TWIDTH SIM_REG8(SPI1TWIDTH)
+#define SPI1CLK SIM_REG8(SPI1CLK)
+#define SPI1BAUD SIM_REG8(SPI1BAUD)
+#define SPI1SDIPPS SIM_REG8(SPI1SDIPPS)
+#define SPI1SCKPPS SIM_REG8(SPI1SCKPPS)
+#define SPI1SSPPS SIM_REG8(SPI1SSPPS)
+#define SPI1TXB SIM_REG16(SPI1TXB)
+#define SPI1TCNTL SIM_REG16(SPI1TCNTL)
+#define SPI1TCNTH SIM_REG16(SPI1TCNTH)
+#define SPI1CON0bits SIM_BITS(SPI1CON0, SPIxCON0bits_t)
+#define SPI1CON1bits SIM_BITS(SPI1CON1, SPIxCON1bits_t)
+#define SPI1CON2bits SIM_BITS(SPI1CON2, SPIxCON2bits_t)
+#define SPI1STATUSbits SIM_BITS(SPI1STATUS, SPIxSTATUSbits_t)
+#define SPI1INTFbits SIM_BITS(SPI1INTF, SPI1INTFbits_t)
+#define SPI1INTEbits SIM_BITS(SPI1INTE, SPIxINTEbits_t)
+
+//SPI2
+#define SPI2CON0 SIM_REG8(SPI2CON0)
+#define SPI2CON1 SIM_REG8(SPI2CON1)
+#define SPI2CON2 SIM_REG8(SPI2CON2)
+#define SPI2STATUS SIM_REG8(SPI2STATUS)
+#define SPI2INTF SIM_REG8(SPI2INTF)
+#define SPI2INTE SIM_REG8(SPI2INTE)
+#define SPI2RXB SIM_REG8(SPI2RXB)
+#define SPI2TWIDTH SIM_REG8(SPI2TWIDTH)
+#define SPI2CLK SIM_REG8(SPI2CLK)
+#define SPI2BAUD SIM_REG8(SPI2BAUD)
+#define SPI2SDIPPS SIM_REG8(SPI2SDIPPS)
+#define SPI2SCKPPS SIM_REG8(SPI2SCKPPS)
+#define SPI2SSPPS SIM_REG8(SPI2SSPPS)
+#define SPI2TXB SIM_REG16(SPI2TXB)
+#define SPI2TCNTL SIM_REG16(SPI2TCNTL)
+#define SPI2TCNTH SIM_REG16(SPI2TCNTH)
+#define SPI2CON0bits SIM_BITS(SPI2CON0, SPIxCON0bits_t)
+#define SPI2CON1bits SIM_BITS(SPI2CON1, SPIxCON1bits_t)
+#define SPI2CON2bits SIM_BITS(SPI2CON2, SPIxCON2bits_t)
+#define SPI2STATUSbits SIM_BITS(SPI2STATUS, SPIxSTATUSbits_t)
+#define SPI2INTFbits SIM_BITS(SPI2INTF, SPIxINTFbits_t)
+#define SPI2INTEbits SIM_BITS(SPI2INTE, SPIxINTEbits_t)
+
+//Interrupts
+#define PIR0 SIM_REG8(PIR0)
+#define PIR1 SIM_REG8(PIR1)
+#define PIR2 SIM_REG8(PIR2)
+#define PIR3 SIM_REG8(PIR3)
+#define PIR4 SIM_REG8(PIR4)
+#define PIR5 SIM_REG8(PIR5)
+#define PIR6 SIM_REG8(PIR6)
+#define PIR7 SIM_REG8(PIR7)
+#define PIR8 SIM_REG8(PIR8)
+#define PIR9 SIM_REG8(PIR9)
+#define PIR10 SIM_REG8(PIR10)
+#define PIR11 SIM_REG8(PIR11)
+#define PIR12 SIM_REG8(PIR12)
+#define PIR13 SIM_REG8(PIR13)
+#define PIR14 SIM_REG8(PIR14)
+#define PIR15 SIM_REG8(PIR15)
+#define PIE0 SIM_REG8(PIE0)
+#define PIE1 SIM_REG8(PIE1)
+#define PIE2 SIM_REG8(PIE2)
+#define PIE3 SIM_REG8(PIE3)
+#define PIE4 SIM_REG8(PIE4)
+#define PIE5 SIM_REG8(PIE5)
+#define PIE6 SIM_REG8(PIE6)
+#define PIE7 SIM_REG8(PIE7)
+#define PIE8 SIM_REG8(PIE8)
+#define PIE9 SIM_REG8(PIE9)
+#define PIE10 SIM_REG8(PIE10)
+#define PIE11 SIM_REG8(PIE11)
+#define PIE12 SIM_REG8(PIE12)
+#define PIE13 SIM_REG8(PIE13)
+#define PIE14 SIM_REG8(PIE14)
+#define PIE15 SIM_REG8(PIE15)
+#define PIR3bits SIM_BITS(PIR3, PIR3bits_t)
+#define PIE3bits SIM_BITS(PIE3, PIE3bits_t)
+#define PIR7bits SIM_BITS(PIR7, PIR7bits_t)
+#define PIE7bits SIM_BITS(PIE7, PIE7bits_t)
+#define DMA1SCNTIF SIM_BIT(PIR2, 1)
+#define DMA1SCNTIE SIM_BIT(PIE2, 1)
+#define DMA1DCNTIF SIM_BIT(PIR2, 2)
+#define DMA1DCNTIE SIM_BIT(PIE2, 2)
+#define DMA2SCNTIF SIM_BIT(PIR6, 1)
+#define DMA2SCNTIE SIM_BIT(PIE6, 1)
+#define DMA2DCNTIF SIM_BIT(PIR6, 2)
+#define DMA2DCNTIE SIM_BIT(PIE6, 2)
+#define DMA3SCNTIF SIM_BIT(PIR10, 1)
+#define DMA3SCNTIE SIM_BIT(PIE10, 1)
+#define DMA3DCNTIF SIM_BIT(PIR10, 2)
+#define DMA3DCNTIE SIM_BIT(PIE10, 2)
+#define DMA4SCNTIF SIM_BIT(PIR11, 1)
+#define DMA4SCNTIE SIM_BIT(PIE11, 1)
+#define DMA4DCNTIF SIM_BIT(PIR11, 2)
+#define DMA4DCNTIE SIM_BIT(PIE11, 2)
+#define INTCON0 SIM_REG8(INTCON0)
+#define INTCON1 SIM_REG8(INTCON1)
+#define INTCON0bits SIM_BITS(INTCON0, INTCON0bits_t)
+#define IVTBASE SIM_REG16(IVTBASE)
+#define IVTLOCK SIM_REG8(IVTLOCK)
+#define IVTLOCKbits SIM_BITS(IVTLOCK, IVTLOCKbits_t)
+
+//System arbiter and DMA
+#define PRLOCK SIM_REG8(PRLOCK)
+#define ISRPR SIM_REG8(ISRPR)
+#define MAINPR SIM_REG8(MAINPR)
+#define DMA1PR SIM_REG8(DMA1PR)
+#define DMA2PR SIM_REG8(DMA2PR)
+#define DMA3PR SIM_REG8(DMA3PR)
+#define DMA4PR SIM_REG8(DMA4PR)
+#define DMASELECT SIM_REG8(DMASELECT)
+#define PRLOCKbits SIM_BITS(PRLOCK, PRLOCKbits_t)
+#define DMAnCON0 SIM_REG8(DMAnCON0)
+#define DMAnCON1 SIM_REG8(DMAnCON1)
+#define DMAnSIRQ SIM_REG8(DMAnSIRQ)
+#define DMAnAIRQ SIM_REG8(DMAnAIRQ)
+#define DMAnCON0bits SIM_BITS(DMAnCON0, DMAnCON0bits_t)
+#define DMAnCON1bits SIM_BITS(DMAnCON1, DMAnCON1bits_t)
+#define DMAnSSZ SIM_REG16(DMAnSSZ)
+#define DMAnSCNT SIM_REG16(DMAnSCNT)
+#define DMAnDSA SIM_REG16(DMAnDSA)
+#define DMAnDSZ SIM_REG16(DMAnDSZ)
+#define DMAnDCNT SIM_REG16(DMAnDCNT)
+#define DMAnDPTR SIM_REG16(DMAnDPTR)
+#define DMAnSSA SIM_REGPTR(DMAnSSA)
+#define DMAnSPTR SIM_REGPTR(DMAnSPTR)
+
+//Timers
+#define T0CON0 SIM_REG8(T0CON0)
+#define T0CON1 SIM_REG8(T0CON1)
+#define TMR0L SIM_REG8(TMR0L)
+#define TMR0H SIM_REG8(TMR0H)
+#define T1CON SIM_REG8(T1CON)
+#define T1CLK SIM_REG8(T1CLK)
+#define T1GCON SIM_REG8(T1GCON)
+#define TMR1 SIM_REG16(TMR1)
+#define T0CON0bits SIM_BITS(T0CON0, T0CON0bits_t)
+#define T0CON1bits SIM_BITS(T0CON1, T0CON1bits_t)
+#define T1CONbits SIM_BITS(T1CON, T1CONbits_t)
+
+//CRC
+#define CRCCON0 SIM_REG8(CRCCON0)
+#define CRCCON1 SIM_REG8(CRCCON1)
+#define CRCCON2 SIM_REG8(CRCCON2)
+#define CRCXORL SIM_REG8(CRCXORL)
+#define CRCXORH SIM_REG8(CRCXORH)
+#define CRCXORU SIM_REG8(CRCXORU)
+#define CRCXORT SIM_REG8(CRCXORT)
+#define CRCACCL SIM_REG8(CRCACCL)
+#define CRCACCH SIM_REG8(CRCACCH)
+#define CRCACCU SIM_REG8(CRCACCU)
+#define CRCACCT SIM_REG8(CRCACCT)
+#define CRCDATAL SIM_REG16(CRCDATAL)
+#define CRCCON0bits SIM_BITS(CRCCON0, CRCCON0bits_t)
+
+//Ports
+#define PORTA SIM_REG8(PORTA)
+#define LATA SIM_REG8(LATA)
+#define TRISA SIM_REG8(TRISA)
+#define ANSELA SIM_REG8(ANSELA)
+#define RA0 SIM_BIT(PORTA, 0)
+#define LATA0 SIM_BIT(LATA, 0)
+#define TRISA0 SIM_BIT(TRISA, 0)
+#define ANSELA0 SIM_BIT(ANSELA, 0)
+#define RA0PPS SIM_REG8(RA0PPS)
+#define RA1 SIM_BIT(PORTA, 1)
+#define LATA1 SIM_BIT(LATA, 1)
+#define TRISA1 SIM_BIT(TRISA, 1)
+#define ANSELA1 SIM_BIT(ANSELA, 1)
+#define RA1PPS SIM_REG8(RA1PPS)
+#define RA2 SIM_BIT(PORTA, 2)
+#define LATA2 SIM_BIT(LATA, 2)
+#define TRISA2 SIM_BIT(TRISA, 2)
+#define ANSELA2 SIM_BIT(ANSELA, 2)
+#define RA2PPS SIM_REG8(RA2PPS)
+#define RA3 SIM_BIT(PORTA, 3)
+#define LATA3 SIM_BIT(LATA, 3)
+#define TRISA3 SIM_BIT(TRISA, 3)
+#define ANSELA3 SIM_BIT(ANSELA, 3)
+#define RA3PPS SIM_REG8(RA3PPS)
+#define RA4 SIM_BIT(PORTA, 4)
+#define LATA4 SIM_BIT(LATA, 4)
+#define TRISA4 SIM_BIT(TRISA, 4)
+#define ANSELA4 SIM_BIT(ANSELA, 4)
+#define RA4PPS SIM_REG8(RA4PPS)
+#define RA5 SIM_BIT(PORTA, 5)
+#define LATA5 SIM_BIT(LATA, 5)
+#define TRISA5 SIM_BIT(TRISA, 5)
+#define ANSELA5 SIM_BIT(ANSELA, 5)
+#define RA5PPS SIM_REG8(RA5PPS)
+#define RA6 SIM_BIT(PORTA, 6)
+#define LATA6 SIM_BIT(LATA, 6)
+#define TRISA6 SIM_BIT(TRISA, 6)
+#define ANSELA6 SIM_BIT(ANSELA, 6)
+#define RA6PPS SIM_REG8(RA6PPS)
+#define RA7 SIM_BIT(PORTA, 7)
+#define LATA7 SIM_BIT(LATA, 7)
+#define TRISA7 SIM_BIT(TRISA, 7)
+#define ANSELA7 SIM_BIT(ANSELA, 7)
+#define RA7PPS SIM_REG8(RA7PPS)
+
+#define PORTB SIM_REG8(PORTB)
+#define LATB SIM_REG8(LATB)
+#define TRISB SIM_REG8(TRISB)
+#define ANSELB SIM_REG8(ANSELB)
+#define RB0 SIM_BIT(PORTB, 0)
+#define LATB0 SIM_BIT(LATB, 0)
+#define TRISB0 SIM_BIT(TRISB, 0)
+#define ANSELB0 SIM_BIT(ANSELB, 0)
+#define RB0PPS SIM_REG8(RB0PPS)
+#define RB1 SIM_BIT(PORTB, 1)
+#define LATB1 SIM_BIT(LATB, 1)
+#define TRISB1 SIM_BIT(TRISB, 1)
+#define ANSELB1 SIM_BIT(ANSELB, 1)
+#define RB1PPS SIM_REG8(RB1PPS)
+#define RB2 SIM_BIT(PORTB, 2)
+#define LATB2 SIM_BIT(LATB, 2)
+#define TRISB2 SIM_BIT(TRISB, 2)
+#define ANSELB2 SIM_BIT(ANSELB, 2)
+#define RB2PPS SIM_REG8(RB2PPS)
+#define RB3 SIM_BIT(PORTB, 3)
+#define LATB3 SIM_BIT(LATB, 3)
+#define TRISB3 SIM_BIT(TRISB, 3)
+#define ANSELB3 SIM_BIT(ANSELB, 3)
+#define RB3PPS SIM_REG8(RB3PPS)
+#define RB4 SIM_BIT(PORTB, 4)
+#define LATB4 SIM_BIT(LATB, 4)
+#define TRISB4 SIM_BIT(TRISB, 4)
+#define ANSELB4 SIM_BIT(ANSELB, 4)
+#define RB4PPS SIM_REG8(RB4PPS)
+#define RB5 SIM_BIT(PORTB, 5)
+#define LATB5 SIM_BIT(LATB, 5)
+#define TRISB5 SIM_BIT(TRISB, 5)
+#define ANSELB5 SIM_BIT(ANSELB, 5)
+#define RB5PPS SIM_REG8(RB5PPS)
+#define RB6 SIM_BIT(PORTB, 6)
+#define LATB6 SIM_BIT(LATB, 6)
+#define TRISB6 SIM_BIT(TRISB, 6)
+#define ANSELB6 SIM_BIT(ANSELB, 6)
+#define RB6PPS SIM_REG8(RB6PPS)
+#define RB7 SIM_BIT(PORTB, 7)
+#define LATB7 SIM_BIT(LATB, 7)
+#define TRISB7 SIM_BIT(TRISB, 7)
+#define ANSELB7 SIM_BIT(ANSELB, 7)
+#define RB7PPS SIM_REG8(RB7PPS)
+
+#define PORTC SIM_REG8(PORTC)
+#define LATC SIM_REG8(LATC)
+#define TRISC SIM_REG8(TRISC)
+#define ANSELC SIM_REG8(ANSELC)
+#define RC0 SIM_BIT(PORTC, 0)
+#define LATC0 SIM_BIT(LATC, 0)
+#define TRISC0 SIM_BIT(TRISC, 0)
+#define ANSELC0 SIM_BIT(ANSELC, 0)
+#define RC0PPS SIM_REG8(RC0PPS)
+#define RC1 SIM_BIT(PORTC, 1)
+#define LATC1 SIM_BIT(LATC, 1)
+#define TRISC1 SIM_BIT(TRISC, 1)
+#define ANSELC1 SIM_BIT(ANSELC, 1)
+#define RC1PPS SIM_REG8(RC1PPS)
+#define RC2 SIM_BIT(PORTC, 2)
+#define LATC2 SIM_BIT(LATC, 2)
+#define TRISC2 SIM_BIT(TRISC, 2)
+#define ANSELC2 SIM_BIT(ANSELC, 2)
+#define RC2PPS SIM_REG8(RC2PPS)
+#define RC3 SIM_BIT(PORTC, 3)
+#define LATC3 SIM_BIT(LATC, 3)
+#define TRISC3 SIM_BIT(TRISC, 3)
+#define ANSELC3 SIM_BIT(ANSELC, 3)
+#define RC3PPS SIM_REG8(RC3PPS)
+#define RC4 SIM_BIT(PORTC, 4)
+#define LATC4 SIM_BIT(LATC, 4)
+#define TRISC4 SIM_BIT(TRISC, 4)
+#define ANSELC4 SIM_BIT(ANSELC, 4)
+#define RC4PPS SIM_REG8(RC4PPS)
+#define RC5 SIM_BIT(PORTC, 5)
+#define LATC5 SIM_BIT(LATC, 5)
+#define TRISC5 SIM_BIT(TRISC, 5)
+#define ANSELC5 SIM_BIT(ANSELC, 5)
+#define RC5PPS SIM_REG8(RC5PPS)
+#define RC6 SIM_BIT(PORTC, 6)
+#define LATC6 SIM_BIT(LATC, 6)
+#define TRISC6 SIM_BIT(TRISC, 6)
+#define ANSELC6 SIM_BIT(ANSELC, 6)
+#define RC6PPS SIM_REG8(RC6PPS)
+#define RC7 SIM_BIT(PORTC, 7)
+#define LATC7 SIM_BIT(LATC, 7)
+#define TRISC7 SIM_BIT(TRISC, 7)
+#define ANSELC7 SIM_BIT(ANSELC, 7)
+#define RC7PPS SIM_REG8(RC7PPS)
+
+#define PORTD SIM_REG8(PORTD)
+#define LATD SIM_REG8(LATD)
+#define TRISD SIM_REG8(TRISD)
+#define ANSELD SIM_REG8(ANSELD)
+#define RD0 SIM_BIT(PORTD, 0)
+#define LATD0 SIM_BIT(LATD, 0)
+#define TRISD0 SIM_BIT(TRISD, 0)
+#define ANSELD0 SIM_BIT(ANSELD, 0)
+#define RD0PPS SIM_REG8(RD0PPS)
+#define RD1 SIM_BIT(PORTD, 1)
+#define LATD1 SIM_BIT(LATD, 1)
+#define TRISD1 SIM_BIT(TRISD, 1)
+#define ANSELD1 SIM_BIT(ANSELD, 1)
+#define RD1PPS SIM_REG8(RD1PPS)
+#define RD2 SIM_BIT(PORTD, 2)
+#define LATD2 SIM_BIT(LATD, 2)
+#define TRISD2 SIM_BIT(TRISD, 2)
+#define ANSELD2 SIM_BIT(ANSELD, 2)
+#define RD2PPS SIM_REG8(RD2PPS)
+#define RD3 SIM_BIT(PORTD, 3)
+#define LATD3 SIM_BIT(LATD, 3)
+#define TRISD3 SIM_BIT(TRISD, 3)
+#define ANSELD3 SIM_BIT(ANSELD, 3)
+#define RD3PPS SIM_REG8(RD3PPS)
+#define RD4 SIM_BIT(PORTD, 4)
+#define LATD4 SIM_BIT(LATD, 4)
+#define TRISD4 SIM_BIT(TRISD, 4)
+#define ANSELD4 SIM_BIT(ANSELD, 4)
+#define RD4PPS SIM_REG8(RD4PPS)
+#define RD5 SIM_BIT(PORTD, 5)
+#define LATD5 SIM_BIT(LATD, 5)
+#define TRISD5 SIM_BIT(TRISD, 5)
+#define ANSELD5 SIM_BIT(ANSELD, 5)
+#define RD5PPS SIM_REG8(RD5PPS)
+#define RD6 SIM_BIT(PORTD, 6)
+#define LATD6 SIM_BIT(LATD, 6)
+#define TRISD6 SIM_BIT(TRISD, 6)
+#define ANSELD6 SIM_BIT(ANSELD, 6)
+#define RD6PPS SIM_REG8(RD6PPS)
+#define RD7 SIM_BIT(PORTD, 7)
+#define LATD7 SIM_BIT(LATD, 7)
+#define TRISD7 SIM_BIT(TRISD, 7)
+#define ANSELD7 SIM_BIT(ANSELD, 7)
+#define RD7PPS SIM_REG8(RD7PPS)
+
+#define PORTE SIM_REG8(PORTE)
+#define LATE SIM_REG8(LATE)
+#define TRISE SIM_REG8(TRISE)
+#define ANSELE SIM_REG8(ANSELE)
+#define RE0 SIM_BIT(PORTE, 0)
+#define LATE0 SIM_BIT(LATE, 0)
+#define TRISE0 SIM_BIT(TRISE, 0)
+#define ANSELE0 SIM_BIT(ANSELE, 0)
+#define RE0PPS SIM_REG8(RE0PPS)
+#define RE1 SIM_BIT(PORTE, 1)
+#define LATE1 SIM_BIT(LATE, 1)
+#define TRISE1 SIM_BIT(TRISE, 1)
+#define ANSELE1 SIM_BIT(ANSELE, 1)
+#define RE1PPS SIM_REG8(RE1PPS)
+#define RE2 SIM_BIT(PORTE, 2)
+#define LATE2 SIM_BIT(LATE, 2)
+#define TRISE2 SIM_BIT(TRISE, 2)
+#define ANSELE2 SIM_BIT(ANSELE, 2)
+#define RE2PPS SIM_REG8(RE2PPS)
+#define RE3 SIM_BIT(PORTE, 3)
+#define LATE3 SIM_BIT(LATE, 3)
+#define TRISE3 SIM_BIT(TRISE, 3)
+#define ANSELE3 SIM_BIT(ANSELE, 3)
+#define RE3PPS SIM_REG8(RE3PPS)
+#define RE4 SIM_BIT(PORTE, 4)
+#define LATE4 SIM_BIT(LATE, 4)
+#define TRISE4 SIM_BIT(TRISE, 4)
+#define ANSELE4 SIM_BIT(ANSELE, 4)
+#define RE4PPS SIM_REG8(RE4PPS)
+#define RE5 SIM_BIT(PORTE, 5)
+#define LATE5 SIM_BIT(LATE, 5)
+#define TRISE5 SIM_BIT(TRISE, 5)
+#define ANSELE5 SIM_BIT(ANSELE, 5)
+#define RE5PPS SIM_REG8(RE5PPS)
+#define RE6 SIM_BIT(PORTE, 6)
+#define LATE6 SIM_BIT(LATE, 6)
+#define TRISE6 SIM_BIT(TRISE, 6)
+#define ANSELE6 SIM_BIT(ANSELE, 6)
+#define RE6PPS SIM_REG8(RE6PPS)
+#define RE7 SIM_BIT(PORTE, 7)
+#define LATE7 SIM_BIT(LATE, 7)
+#define TRISE7 SIM_BIT(TRISE, 7)
+#define ANSELE7 SIM_BIT(ANSELE, 7)
+#define RE7PPS SIM_REG8(RE7PPS)
+
+#endif	/* SIM_XC_H */
@@ -0,0 +1,144 @@
+#include "bridge.h"
+#include "spi1_client.h"
+#include "spi2_host.h"
+#include "spi_config.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//SPI2BAUD for BRIDGE_DOWNSTREAM_SCK_HZ
+#define BRIDGE_SPI2_BAUD_IMAGE SPI_BAUD_IMAGE(SPI2_CFG_CLOCK_HZ, BRIDGE_DOWNSTREAM_SCK_HZ)
+
+//BRIDGE_DRAIN_TIMEOUT_US in Timer0 ticks, rounded up
+#define BRIDGE_DRAIN_TIMEOUT_TICKS \
+    ((BRIDGE_DRAIN_TIMEOUT_US + SPI_TIMER0_TICK_US - 1) / SPI_TIMER0_TICK_US)
+
+_Static_assert((BRIDGE_DOWNSTREAM_SCK_HZ > SPI1_CFG_SCK_HZ) && \
+    (BRIDGE_DOWNSTREAM_SCK_HZ <= SPI2_CFG_CLOCK_HZ / 2), \
+    "BRIDGE_DOWNSTREAM_SCK_HZ must be faster than SPI1_CFG_SCK_HZ, up to SPI2_CFG_CLOCK_HZ / 2");
+_Static_assert(SPI_BAUD_DIVIDER(SPI2_CFG_CLOCK_HZ, BRIDGE_DOWNSTREAM_SCK_HZ) <= 256, \
+    "BRIDGE_DOWNSTREAM_SCK_HZ is too slow for SPI2_CFG_CLOCK_HZ");
+_Static_assert((BRIDGE_DRAIN_TIMEOUT_US * BRIDGE_DOWNSTREAM_SCK_HZ >= 16UL * 1000000UL) && \
+    (BRIDGE_DRAIN_TIMEOUT_TICKS <= 0xFFFF), \
+    "BRIDGE_DRAIN_TIMEOUT_US must cover 2 downstream bytes and fit Timer0");
+
+//Returns the free-running Timer0 count (started by SPI2_initHost)
+static uint16_t Bridge_readTimer(void)
+{
+    //Reading TMR0L latches TMR0H
+    uint8_t low = TMR0L;
+    return ((uint16_t) TMR0H << 8) | low;
+}
+
+//Clears the upstream FIFOs and queues the fill bytes for the next frame
+static void Bridge_prepareFrame(void)
+{
+    SPI1_flushBuffer();
+    
+    for (uint8_t i = 0; i < BRIDGE_REPLY_DELAY; i++)
+    {
+        SPI1TXB = BRIDGE_FILL;
+    }
+}
+
+//Initializes SPI1 as the upstream client and SPI2 as the downstream host
+void Bridge_init(void)
+{
+    //Upstream - client on SPI1
+    SPI1_initPins();
+    SPI1_initClient();
+    SPI1_enableTransmit();
+    SPI1_enableReceive();
+    
+    //Downstream - host on SPI2
+    SPI2_initPins();
+    SPI2_initHost();
+    
+    //Bridge SCK, set with the module disabled
+    SPI2CON0bits.EN = 0;
+    SPI2BAUD = BRIDGE_SPI2_BAUD_IMAGE;
+    SPI2CON0bits.EN = 1;
+    
+    //Full duplex - each write to SPI2TXB clocks a byte (kept by SPI2_recover)
+    SPI2CON2bits.TXR = 1;
+    SPI2CON2bits.RXR = 1;
+    
+    Bridge_prepareFrame();
+}
+
+//Forwards frames between the buses. Does not return
+void Bridge_run(void)
+{
+    //Bytes sent downstream without a reply yet
+    uint8_t inFlight = 0;
+    
+    //Registers are used directly - each pass of this loop is the added latency
+    while (1)
+    {
+        if (SPI1INTFbits.SOSIF)
+        {
+            //Upstream SS asserted - assert downstream SS
+            SPI1INTFbits.SOSIF = 0;
+            
+            SPI2STATUSbits.CLRBF = 1;
+            SPI2INTFbits.TCZIF = 0;
+            SPI2CON2bits.SSET = 1;
+            SPI2_loadCount(SPI2_MAX_TCNT);
+            inFlight = 0;
+        }
+        
+        if (PIR3bits.SPI1RXIF)
+        {
+            //Upstream byte - send downstream
+            SPI2TXB = SPI1RXB;
+            inFlight++;
+        }
+        
+        if ((PIR7bits.SPI2RXIF) && (PIR3bits.SPI1TXIF))
+        {
+            //Downstream reply - send upstream
+            SPI1TXB = SPI2RXB;
+            inFlight--;
+        }
+        
+        if (SPI2INTFbits.TCZIF)
+        {
+            //Long frame - keep the downstream counter running
+            SPI2INTFbits.TCZIF = 0;
+            SPI2_loadCount(SPI2_MAX_TCNT);
+        }
+        
+        if (SPI1INTFbits.EOSIF)
+        {
+            //Upstream SS released
+            if (PIR3bits.SPI1RXIF)
+            {
+                //Last byte arrived with the stop event
+                SPI2TXB = SPI1RXB;
+                inFlight++;
+            }
+            
+            //Finish the bytes in flight - replies have nowhere to go
+            //A byte lost downstream (upstream too fast) never replies, so
+            //stop waiting when no reply came for BRIDGE_DRAIN_TIMEOUT_US
+            uint16_t lastReply = Bridge_readTimer();
+            while ((inFlight != 0) &&
+                   ((uint16_t) (Bridge_readTimer() - lastReply) < BRIDGE_DRAIN_TIMEOUT_TICKS))
+            {
+                if (PIR7bits.SPI2RXIF)
+                {
+                    (void) SPI2RXB;
+                    inFlight--;
+                    lastReply = Bridge_readTimer();
+                }
+            }
+            
+            //Release downstream SS and the unused count (drops what is left)
+            SPI2_recover();
+            
+            Bridge_prepareFrame();
+            SPI1INTFbits.EOSIF = 0;
+        }
+    }
+}
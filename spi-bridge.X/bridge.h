@@ -0,0 +1,58 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef BRIDGE_H
+#define	BRIDGE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Bytes sent upstream before the first reply (the client TX FIFO holds 2 bytes)
+#define BRIDGE_REPLY_DELAY 2
+    
+//Byte sent upstream until the first reply is ready
+#define BRIDGE_FILL 0x00
+    
+//Downstream SCK (must be faster than the upstream SCK). Replaces
+//SPI2_CFG_SCK_HZ of spi_config.h, which is shared with the host project
+#define BRIDGE_DOWNSTREAM_SCK_HZ 2000000UL
+    
+//Longest wait for a downstream reply when the upstream frame ends, in us
+//A byte lost downstream never replies - the frame is then dropped
+#define BRIDGE_DRAIN_TIMEOUT_US 100
+    
+    //Initializes SPI1 as the upstream client and SPI2 as the downstream host
+    //Configures the I/O of both
+    void Bridge_init(void);
+    
+    //Forwards frames between the buses. Does not return
+    //Interrupts must be disabled
+    void Bridge_run(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* BRIDGE_H */
+
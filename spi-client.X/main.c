@@ -85,6 +85,9 @@
 #include <xc.h>
 #include "spi1_client.h"
 #include "interrupts.h"
+#include "spi1_frames.h"
+#include "spi1_regmap.h"
+#include "spi1_client_dma.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -137,14 +140,14 @@ void SPI_TEST_Polling(void)
         else if (active)
         {
             //Data can be read
-            while (SPI1_canReadData() && (readIndex <= BUFFER_SIZE))
+            while (SPI1_canReadData() && (readIndex < BUFFER_SIZE))
             {
                 buffer[readIndex] = SPI1_readData();
                 readIndex++;
             }
 
             //Data can be written
-            while (SPI1_canWriteData() && (writeIndex <= BUFFER_SIZE))
+            while (SPI1_canWriteData() && (writeIndex < BUFFER_SIZE))
             {
                 SPI1_writeData(buffer[writeIndex]);
                 writeIndex++;
@@ -154,37 +157,83 @@ void SPI_TEST_Polling(void)
     }
 }
 
-void SPI_TEST_myRXFunction(uint8_t data)
+/*
+ * Expected Behavior
+ * Each frame received from the host is queued as the reply to the next frame.
+ * LED0 toggles for every frame processed.
+ */
+void SPI_TEST_Frames(void)
 {
-    buffer[readIndex] = data;
-    readIndex++;
+    uint8_t len;
+    uint8_t* frame;
+    
+    while (1)
+    {
+        frame = SPI1_getFrame(&len);
+        
+        if (frame != 0)
+        {
+            //Frame is used in place, then released
+            SPI1_queueReply(frame, len);
+            SPI1_releaseFrame();
+            
+            LATC7 = !LATC7;
+        }
+    }
 }
 
-uint8_t SPI_TEST_myTXFunction(void)
-{
-    //Caution: Due to FIFO, n + 2 bytes are loaded
-    uint8_t data = buffer[writeIndex];
-    writeIndex++;
-    return data;
-}
+static volatile uint8_t regID = 0x71;
+static volatile uint8_t regLED = 0x00;
+static volatile uint8_t regScratch[4];
 
-void SPI_TEST_myStartFunction(void)
+void SPI_TEST_myLEDWrite(uint8_t address, uint8_t value)
 {
-    LATC7 = !LATC7;
+    //LED0 is active low
+    LATC7 = (value & 0x01) ? 0 : 1;
 }
 
-void SPI_TEST_myStopFunction(void)
-{
-    //Flush the buffer
-    SPI1_flushBuffer();
-    readIndex = 0;
-    writeIndex = 0;
+/*
+ * Expected Behavior
+ * 0x00 - ID (read only, 0x71)
+ * 0x01 - LED (bit 0 turns LED0 on)
+ * 0x02 to 0x05 - Scratch registers
+ * Write: 0x01, 0x01 turns on LED0. Read: 0x80, 0x00, 0x00, ... returns ID, LED, scratch...
+ */
+static const SPI1_register_t testRegisters[] = {
+    {&regID, SPI1_REG_READ, 0, 0},
+    {&regLED, SPI1_REG_READ | SPI1_REG_WRITE, 0, &SPI_TEST_myLEDWrite},
+    {&regScratch[0], SPI1_REG_READ | SPI1_REG_WRITE, 0, 0},
+    {&regScratch[1], SPI1_REG_READ | SPI1_REG_WRITE, 0, 0},
+    {&regScratch[2], SPI1_REG_READ | SPI1_REG_WRITE, 0, 0},
+    {&regScratch[3], SPI1_REG_READ | SPI1_REG_WRITE, 0, 0},
+};
 
+static uint8_t dmaFrame[BUFFER_SIZE];
+static uint8_t dmaReply[BUFFER_SIZE];
+
+/*
+ * Expected Behavior
+ * Frames are captured by the DMA. Each frame is sent back as the reply to
+ * the next frame. LED0 toggles for every frame.
+ */
+void SPI_TEST_myDMAFrame(uint16_t len)
+{
+    //Runs in the status ISR - copy the frame before the buffer is re-armed
+    for (uint16_t i = 0; i < len; i++)
+    {
+        dmaReply[i] = dmaFrame[i];
+    }
+    
+    SPI1_DMA_setReply(&dmaReply[0], len);
+    
+    LATC7 = !LATC7;
 }
 
 //Select test to run (only 1 will be run)
 //#define TEST_SPI_POLLING
 #define TEST_SPI_INT
+//#define TEST_SPI_REGMAP
+//#define TEST_SPI_DMA
 
 void main(void) {    
     //Init SPI I/O
@@ -214,15 +263,40 @@ void main(void) {
 #elif defined TEST_SPI_INT
     
     //Attach interrupt handlers
-    SPI1_setTXHandler(&SPI_TEST_myTXFunction);
-    SPI1_setRXHandler(&SPI_TEST_myRXFunction);
-    SPI1_setStartHandler(&SPI_TEST_myStartFunction);
-    SPI1_setStopHandler(&SPI_TEST_myStopFunction);
+    //With SPI1_FAST_PATH, bytes go to the handlers in spi1_fastpath.h instead
+    SPI1_initFrames();
+#ifndef SPI1_FAST_PATH
+    SPI1_setTXHandler(&SPI1_frameTXHandler);
+    SPI1_setRXHandler(&SPI1_frameRXHandler);
+#endif
+    SPI1_setStartHandler(&SPI1_frameStartHandler);
+    SPI1_setStopHandler(&SPI1_frameStopHandler);
     
     //Enable Interrupts
     SPI1_enableInterrupts();    
     Interrupts_enable();
     
+    //Note: Infinite Loop - does not execute code below
+    SPI_TEST_Frames();
+    
+#elif defined TEST_SPI_REGMAP
+    
+#ifdef SPI1_FAST_PATH
+#error "The register map needs the TX and RX callbacks - undefine SPI1_FAST_PATH"
+#endif
+    
+    //Enable Interrupts, then attach the register map
+    SPI1_enableInterrupts();
+    SPI1_initRegisterMap(&testRegisters[0], sizeof(testRegisters) / sizeof(testRegisters[0]));
+    Interrupts_enable();
+    
+#elif defined TEST_SPI_DMA
+    
+    //Bytes are moved by the DMA, only SS interrupts the CPU
+    SPI1_DMA_initClient();
+    SPI1_DMA_startCapture(&dmaFrame[0], sizeof(dmaFrame), &SPI_TEST_myDMAFrame);
+    Interrupts_enable();
+    
 #endif
     
     while (1)
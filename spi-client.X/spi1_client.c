@@ -1,233 +1,416 @@
 #include "spi1_client.h"
+#include "spi_config.h"
 #include "interrupts.h"
 
+#ifdef SPI1_FAST_PATH
+#include "spi1_fastpath.h"
+#endif
+
+#ifdef SPI1_TRACE
+#include "spi1_trace.h"
+#endif
+
 #include <xc.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-static void (*rxCallback)(uint8_t) = 0;
-static uint8_t (*txCallback)(void) = 0;
-static void (*startCallback)(void) = 0;
-static void (*stopCallback)(void) = 0;
+#ifdef SPI1_TRACE
+//Client timestamps are read against the host's, so both count the Timer0 ticks of spi_config.h
+_Static_assert(SPI1_TRACE_TICK_US == SPI_TIMER0_TICK_US, "SPI1_TRACE_TICK_US must match the Timer0 tick of spi_config.h");
+#endif
+
+static void (*errorCallback)(uint8_t) = 0;
+
+//FIFO error counters
+static volatile uint16_t rxOverflows = 0;
+static volatile uint16_t txUnderflows = 0;
 
-//Initializes a SPI Client
-//I/O must be initialized separately
-//TX and RX are enabled separately
-void SPI1_initClient(void)
+//If set, the rest of a frame is discarded after an error
+static volatile bool resyncEnabled = false;
+static volatile bool resyncPending = false;
+
+#ifdef SPI1_ISR_STATS
+
+static volatile SPI1_stats_t stats;
+
+//Records the time spent in an ISR
+static void SPI1_recordISR(uint16_t start)
 {
-    SPI1CON0 = 0x00;
-    
-    //Active Low CS
-    SPI1CON1 = 0x00;
-    SPI1CON1bits.SSP = 1;
+    uint16_t cycles = TMR1 - start;
     
-    SPI1CON2 = 0x00;
-    
-    //Select HFINOTSC
-    SPI1CLK = 0b00001;
+    if (cycles > stats.maxISRCycles)
+    {
+        stats.maxISRCycles = cycles;
+    }
     
-    //At HFINOTSC = 64 MHz, this generates a 1 MHz signal
-    SPI1BAUD = 31;
+    stats.totalISRCycles += cycles;
+    stats.isrCount++;
+}
+
+#define SPI1_STATS_ENTER() uint16_t isrStart = TMR1
+#define SPI1_STATS_EXIT() SPI1_recordISR(isrStart)
+#define SPI1_STATS_COUNT(counter) stats.counter++
+
+#else
+
+#define SPI1_STATS_ENTER()
+#define SPI1_STATS_EXIT()
+#define SPI1_STATS_COUNT(counter)
+
+#endif
+
+#ifdef SPI1_TRACE
+
+//First bytes of the current frame, and its length and status
+static uint8_t traceTX[SPI1_TRACE_DATA_BYTES / 2];
+static uint8_t traceRX[SPI1_TRACE_DATA_BYTES / 2];
+static uint8_t traceTXCount = 0;
+static uint16_t traceRXCount = 0;
+static uint8_t traceStatus = SPI1_TRACE_OK;
+
+//Records the frame when SS is de-asserted
+static void SPI1_traceFrame(void)
+{
+    uint8_t rxLen = (traceRXCount < sizeof(traceRX)) ? (uint8_t) traceRXCount : sizeof(traceRX);
     
-    //Clear Flags
-    SPI1INTF = 0x00;
+    SPI1_traceAdd(SPI1_TRACE_CLIENT | SPI1_TRACE_TX | SPI1_TRACE_RX | SPI1_TRACE_STATUS(traceStatus),
+        SPI1_traceGetDevice(), &traceTX[0], traceTXCount, &traceRX[0], rxLen, traceRXCount);
     
-    //Clear set interrupts
-    SPI1INTE = 0x00;
+    //The TX FIFO is loaded before SS is asserted, so TX bytes are counted from here
+    traceTXCount = 0;
+}
+
+//Sets the bytes of the current frame when the byte ISRs did not see them
+//(DMA capture). Called from the stop handler, before the record is added
+void SPI1_traceSetFrame(const uint8_t* txData, uint16_t txLen, const uint8_t* rxData, uint16_t rxLen)
+{
+    traceTXCount = (txLen < sizeof(traceTX)) ? (uint8_t) txLen : sizeof(traceTX);
+    for (uint8_t i = 0; i < traceTXCount; i++)
+    {
+        traceTX[i] = txData[i];
+    }
     
-    //Enable Module
-    SPI1CON0bits.EN = 1;
+    traceRXCount = rxLen;
+    for (uint8_t i = 0; (i < rxLen) && (i < sizeof(traceRX)); i++)
+    {
+        traceRX[i] = rxData[i];
+    }
 }
 
+#define SPI1_TRACE_START() do { traceRXCount = 0; traceStatus = SPI1_TRACE_OK; } while (0)
+#define SPI1_TRACE_STOP() SPI1_traceFrame()
+#define SPI1_TRACE_TX_BYTE(data) do { if (traceTXCount < sizeof(traceTX)) { traceTX[traceTXCount++] = (data); } } while (0)
+#define SPI1_TRACE_RX_BYTE(data) do { if (traceRXCount < sizeof(traceRX)) { traceRX[traceRXCount] = (data); } traceRXCount++; } while (0)
+#define SPI1_TRACE_ERROR(status) do { traceStatus = (status); } while (0)
+
+#else
+
+#define SPI1_TRACE_START() do { } while (0)
+#define SPI1_TRACE_STOP() do { } while (0)
+#define SPI1_TRACE_TX_BYTE(data) do { } while (0)
+#define SPI1_TRACE_RX_BYTE(data) do { } while (0)
+#define SPI1_TRACE_ERROR(status) do { } while (0)
+
+#endif
+
+//Core functions are generated from the client template
+#define SPI_INSTANCE 1
+#define SPIx_TXIF PIR3bits.SPI1TXIF
+#define SPIx_RXIF PIR3bits.SPI1RXIF
+#define SPIx_TXIE PIE3bits.SPI1TXIE
+#define SPIx_RXIE PIE3bits.SPI1RXIE
+#define SPIx_IE PIE3bits.SPI1IE
+#ifdef SPI1_FAST_PATH
+#define SPIx_FAST_PATH
+#endif
+#include "spi_client_template.h"
+
 //Initializes the I/O for the SPI Client
 void SPI1_initPins(void)
 {
+    //Pins are set in spi_config.h
     //RC2 - SDO
     //RC5 - SDI
     //RC6 - SCK
     //RA5 - CS1
     
     //SDO Config
-    TRISC2 = 1;     //Set as input for tri-stating
-    ANSELC2 = 0;
-    RC2PPS = 0x1E;
+    SPI_PIN_TRIS(SPI1_CFG_SDO_PIN) = 1;     //Set as input for tri-stating
+    SPI_PIN_ANSEL(SPI1_CFG_SDO_PIN) = 0;
+    SPI_PIN_PPS(SPI1_CFG_SDO_PIN) = SPI1_PPS_SDO;
     
     //SDI Config
-    TRISC5 = 1;
-    ANSELC5 = 0;
-    SPI1SDIPPS = 0b010101;
+    SPI_PIN_TRIS(SPI1_CFG_SDI_PIN) = 1;
+    SPI_PIN_ANSEL(SPI1_CFG_SDI_PIN) = 0;
+    SPI1SDIPPS = SPI_PIN_INPUT(SPI1_CFG_SDI_PIN);
     
     //SCK Config
-    TRISC6 = 1;
-    ANSELC6 = 0;
-    SPI1SCKPPS = 0b010110;
+    SPI_PIN_TRIS(SPI1_CFG_SCK_PIN) = 1;
+    SPI_PIN_ANSEL(SPI1_CFG_SCK_PIN) = 0;
+    SPI1SCKPPS = SPI_PIN_INPUT(SPI1_CFG_SCK_PIN);
     
     //CS Config
-    TRISA5 = 1;
-    ANSELA5 = 0;
-    SPI1SSPPS = 0b000101;
-}
-
-//Flushes the SPI Buffer
-void SPI1_flushBuffer(void)
-{
-    SPI1STATUSbits.CLRBF = 1;
-}
-
-//Returns true if the RX FIFO can be read from
-bool SPI1_canReadData(void)
-{
-    return PIR3bits.SPI1RXIF;
-}
-
-//Returns true if the TX FIFO can accept data
-bool SPI1_canWriteData(void)
-{
-    return PIR3bits.SPI1TXIF;
-}
-
-//Returns true when SS transitions from de-asserted to asserted
-bool SPI1_isStarted(void)
-{
-    return SPI1INTFbits.SPI1SOSIF;
-}
-
-//Returns true when SS transitions from asserted to de-asserted
-bool SPI1_isStopped(void)
-{
-    return SPI1INTFbits.SPI1EOSIF;
+    SPI_PIN_TRIS(SPI1_CFG_SS_PIN) = 1;
+    SPI_PIN_ANSEL(SPI1_CFG_SS_PIN) = 0;
+    SPI1SSPPS = SPI_PIN_INPUT(SPI1_CFG_SS_PIN);
 }
 
-//Clears the start flag
-void SPI1_clearStartFlag(void)
+//Sets a callback function when the RX FIFO overflows or the TX FIFO underflows
+void SPI1_setErrorHandler(void (*callback)(uint8_t))
 {
-    SPI1INTFbits.SPI1SOSIF = 0;
+    //Enable Overflow and Underflow Interrupts
+    SPI1INTFbits.RXOIF = 0;
+    SPI1INTFbits.TXUIF = 0;
+    SPI1INTEbits.RXOIE = 1;
+    SPI1INTEbits.TXUIE = 1;
+    
+    errorCallback = callback;
 }
 
-//Clears the stop flag
-void SPI1_clearStopFlag(void)
+//If enabled, the rest of the frame is discarded after an error
+void SPI1_setResync(bool enable)
 {
-    SPI1INTFbits.SPI1EOSIF = 0;
+    resyncEnabled = enable;
 }
 
-//Reads a byte of data from the RX FIFO
-uint8_t SPI1_readData(void)
+//Returns true if the current frame is being discarded after an error
+bool SPI1_isResyncing(void)
 {
-    return SPI1RXB;
+    return resyncPending;
 }
 
-//Writes a byte of data to the TX FIFO
-void SPI1_writeData(uint8_t data)
+//Returns the number of RX FIFO overflows
+uint16_t SPI1_getRXOverflowCount(void)
 {
-    SPI1TXB = data;
+    uint16_t count;
+    
+    //16-bit value is also written by the ISR
+    bool ie = PIE3bits.SPI1IE;
+    PIE3bits.SPI1IE = 0;
+    count = rxOverflows;
+    PIE3bits.SPI1IE = ie;
+    
+    return count;
 }
 
-//Enable TX
-void SPI1_enableTransmit(void)
+//Returns the number of TX FIFO underflows
+uint16_t SPI1_getTXUnderflowCount(void)
 {
-    SPI1CON2bits.TXR = 1;
+    uint16_t count;
+    
+    //16-bit value is also written by the ISR
+    bool ie = PIE3bits.SPI1IE;
+    PIE3bits.SPI1IE = 0;
+    count = txUnderflows;
+    PIE3bits.SPI1IE = ie;
+    
+    return count;
 }
 
-//Disable TX
-void SPI1_disableTransmit(void)
+//Clears the error counters
+void SPI1_clearErrorCounts(void)
 {
-    SPI1CON2bits.TXR = 0;
+    bool ie = PIE3bits.SPI1IE;
+    PIE3bits.SPI1IE = 0;
+    rxOverflows = 0;
+    txUnderflows = 0;
+    PIE3bits.SPI1IE = ie;
 }
 
-//Enable RX
-void SPI1_enableReceive(void)
-{
-    SPI1CON2bits.RXR = 1;
-}
+#ifdef SPI1_ISR_STATS
 
-//Disable RX
-void SPI1_disableReceive(void)
+//Starts Timer1 as a free-running timer and clears the statistics
+void SPI1_initStats(void)
 {
-    SPI1CON2bits.RXR = 0;
+    //FOSC / 4, 16-bit reads, 1:1
+    T1CLK = 0b00001;
+    T1CON = 0x00;
+    TMR1 = 0;
+    T1CONbits.RD16 = 1;
+    T1CONbits.ON = 1;
+    
+    stats.maxISRCycles = 0;
+    stats.totalISRCycles = 0;
+    stats.isrCount = 0;
+    stats.frameBytes = 0;
+    stats.lastFrameBytes = 0;
+    stats.maxFrameBytes = 0;
+    stats.rxOverflows = 0;
+    stats.txUnderflows = 0;
+    
+    //Report FIFO errors and frame edges through the status interrupt
+    SPI1INTFbits.SOSIF = 0;
+    SPI1INTFbits.EOSIF = 0;
+    SPI1INTFbits.RXOIF = 0;
+    SPI1INTFbits.TXUIF = 0;
+    SPI1INTEbits.SOSIE = 1;
+    SPI1INTEbits.EOSIE = 1;
+    SPI1INTEbits.RXOIE = 1;
+    SPI1INTEbits.TXUIE = 1;
 }
 
-//Enable SPI Interrupts
-void SPI1_enableInterrupts(void)
+//Copies the statistics
+void SPI1_getStats(SPI1_stats_t* output)
 {
-    PIE3bits.SPI1TXIE = 1;
-    PIE3bits.SPI1RXIE = 1;
-    PIE3bits.SPI1IE = 1;
+    //Copy without being interrupted
+    bool gie = INTCON0bits.GIE;
+    INTCON0bits.GIE = 0;
+    
+    *output = stats;
+    
+    INTCON0bits.GIE = gie;
 }
 
-//Disable SPI Interrupts
-void SPI1_disableInterrupts(void)
+//Returns the average time spent in a SPI ISR
+uint16_t SPI1_getAverageISRCycles(void)
 {
-    PIE3bits.SPI1TXIE = 0;
-    PIE3bits.SPI1RXIE = 0;
-    PIE3bits.SPI1IE = 0;
+    SPI1_stats_t copy;
+    SPI1_getStats(&copy);
+    
+    if (copy.isrCount == 0)
+    {
+        return 0;
+    }
+    
+    return (uint16_t) (copy.totalISRCycles / copy.isrCount);
 }
 
+#endif
 
-//Sets a TX callback function when new data can be sent
-void SPI1_setTXHandler(uint8_t (*callback)(void))
-{
-    txCallback = callback;
-}
-
-//Sets an RX callback function when new data can be read
-void SPI1_setRXHandler(void (*callback)(uint8_t))
-{
-    rxCallback = callback;
-}
+#ifdef SPI1_TRACE
 
-//Sets a callback function when SS is asserted
-//Interrupts must be enabled for the callback to be run
-void SPI1_setStartHandler(void (*callback)(void))
+//Clears the trace and enables the interrupts used to record frames
+//Frames are recorded when SS is de-asserted
+void SPI1_initTrace(void)
 {
-    //Enable Start Interrupt
-    SPI1INTEbits.SOSIE = 1;
-
-    startCallback = callback;
-}
+    SPI1_traceClear();
     
-//Sets a callback function when SS is de-asserted
-//Interrupts must be enabled for the callback to be run
-void SPI1_setStopHandler(void (*callback)(void))
-{
-    //Enable Stop Interrupt
+    SPI1INTFbits.SOSIF = 0;
+    SPI1INTFbits.EOSIF = 0;
+    SPI1INTFbits.RXOIF = 0;
+    SPI1INTFbits.TXUIF = 0;
+    SPI1INTEbits.SOSIE = 1;
     SPI1INTEbits.EOSIE = 1;
-    
-    stopCallback = callback;
+    SPI1INTEbits.RXOIE = 1;
+    SPI1INTEbits.TXUIE = 1;
 }
 
+#endif
 
 void __interrupt(irq(SPI1TX), base(INTERRUPT_BASE)) SPI_readTX_ISR(void)
 {
-    if (txCallback != 0)
+    SPI1_STATS_ENTER();
+    
+    uint8_t tx;
+    
+    if (resyncPending)
+    {
+        //Frame is being discarded
+        tx = 0x00;
+    }
+#ifdef SPI1_FAST_PATH
+    else
+    {
+        tx = SPI1_fastTX();
+    }
+#else
+    else if (txCallback != 0)
     {
         asm("NOP");
-        SPI1TXB = txCallback();
+        tx = txCallback();
     }
     else
     {
-        SPI1TXB = 0x00;
+        tx = 0x00;
     }
+#endif
+    
+    SPI1TXB = tx;
+    SPI1_TRACE_TX_BYTE(tx);
     
     //Interrupt flag is cleared automatically by writing
+    
+    SPI1_STATS_EXIT();
 }
 
 void __interrupt(irq(SPI1RX), base(INTERRUPT_BASE)) SPI_readRX_ISR(void)
 {
+    SPI1_STATS_ENTER();
+    
     volatile uint8_t rx = SPI1RXB;
     
-    if (rxCallback != 0)
+    if (resyncPending)
+    {
+        //Frame is being discarded
+    }
+#ifdef SPI1_FAST_PATH
+    else
+    {
+        SPI1_fastRX(rx);
+    }
+#else
+    else if (rxCallback != 0)
     {
         rxCallback(rx);
     }
+#endif
+    
+    SPI1_STATS_COUNT(frameBytes);
+    SPI1_TRACE_RX_BYTE(rx);
     
     //Interrupt flag is cleared automatically by reading
+    
+    SPI1_STATS_EXIT();
 }
 
 void __interrupt(irq(SPI1), base(INTERRUPT_BASE)) SPI_status_ISR(void)
 {
+    SPI1_STATS_ENTER();
+    
+    if ((SPI1INTFbits.RXOIF) || (SPI1INTFbits.TXUIF))
+    {
+        uint8_t errors = 0;
+        
+        if (SPI1INTFbits.RXOIF)
+        {
+            //RX FIFO was full when a byte was received
+            errors |= SPI1_ERROR_RX_OVERFLOW;
+            rxOverflows++;
+            SPI1_STATS_COUNT(rxOverflows);
+            SPI1_TRACE_ERROR(SPI1_TRACE_RX_OVERFLOW);
+            SPI1INTFbits.RXOIF = 0;
+        }
+        
+        if (SPI1INTFbits.TXUIF)
+        {
+            //TX FIFO was empty when a byte was sent
+            errors |= SPI1_ERROR_TX_UNDERFLOW;
+            txUnderflows++;
+            SPI1_STATS_COUNT(txUnderflows);
+            SPI1_TRACE_ERROR(SPI1_TRACE_TX_UNDERFLOW);
+            SPI1INTFbits.TXUIF = 0;
+        }
+        
+        if ((resyncEnabled) && (SPI1INTFbits.SOSIF == 0))
+        {
+            //Data is no longer aligned, drop the rest of the frame
+            resyncPending = true;
+        }
+        
+        if (errorCallback != 0)
+        {
+            errorCallback(errors);
+        }
+    }
+    
     if (SPI1INTFbits.SOSIF)
     {
         //SS was Asserted
+#ifdef SPI1_ISR_STATS
+        stats.frameBytes = 0;
+#endif
+        SPI1_TRACE_START();
+        
         if (startCallback != 0)
         {
             startCallback();
@@ -239,12 +422,33 @@ void __interrupt(irq(SPI1), base(INTERRUPT_BASE)) SPI_status_ISR(void)
     else if (SPI1INTFbits.EOSIF)
     {
         //SS was De-asserted
+#ifdef SPI1_ISR_STATS
+        stats.lastFrameBytes = stats.frameBytes;
+        
+        if (stats.frameBytes > stats.maxFrameBytes)
+        {
+            stats.maxFrameBytes = stats.frameBytes;
+        }
+#endif
+        
+        if (resyncPending)
+        {
+            //Drop what is left of the frame now, so the TX FIFO can be
+            //loaded for the next frame before SS is asserted again
+            SPI1STATUSbits.CLRBF = 1;
+            resyncPending = false;
+        }
+        
         if (stopCallback != 0)
         {
             stopCallback();
         }
-
+        
+        //After the stop handler, which can supply the bytes of a DMA frame
+        SPI1_TRACE_STOP();
         
         SPI1INTFbits.EOSIF = 0;
     }
+    
+    SPI1_STATS_EXIT();
 }
@@ -28,6 +28,38 @@ extern "C" {
 #include <stdint.h>
 #include <stdbool.h>
     
+//If defined, the byte handlers in spi1_fastpath.h are compiled into the TX and RX ISRs
+//SPI1_setTXHandler and SPI1_setRXHandler are removed (the register map cannot be used)
+//#define SPI1_FAST_PATH
+    
+//If defined, ISR timing, frame sizes and FIFO errors are recorded (uses Timer1)
+//#define SPI1_ISR_STATS
+    
+//If defined, each frame is recorded in a RAM ring (see spi1_trace.h, uses Timer0)
+//#define SPI1_TRACE
+    
+//Error flags passed to the error handler
+#define SPI1_ERROR_RX_OVERFLOW 0x01
+#define SPI1_ERROR_TX_UNDERFLOW 0x02
+    
+#ifdef SPI1_ISR_STATS
+    
+    //Statistics of the client interrupts
+    //Times are in Timer1 counts (FOSC / 4), from ISR entry to exit. The delay
+    //from the interrupt flag to the ISR entry is not included
+    typedef struct {
+        uint16_t maxISRCycles;      //Longest time spent in a SPI ISR
+        uint32_t totalISRCycles;    //Total time spent in the SPI ISRs
+        uint32_t isrCount;          //Number of SPI ISRs measured
+        uint16_t frameBytes;        //Bytes received in the current frame
+        uint16_t lastFrameBytes;    //Bytes received in the last complete frame
+        uint16_t maxFrameBytes;     //Largest frame received
+        uint16_t rxOverflows;       //RX FIFO overflow events (1 or more bytes lost)
+        uint16_t txUnderflows;      //TX FIFO underflow events (1 or more bytes repeated)
+    } SPI1_stats_t;
+    
+#endif
+    
     //Initializes a SPI Client
     //I/O must be initialized separately
     //TX and RX are enabled separately
@@ -45,12 +77,15 @@ extern "C" {
     //Returns true if the TX FIFO can accept data
     bool SPI1_canWriteData(void);
     
+    //Returns the number of bytes waiting in the TX FIFO (0 to 2)
+    uint8_t SPI1_getTXCount(void);
+    
     //Returns true when SS transitions from de-asserted to asserted
     bool SPI1_isStarted(void);
     
     //Returns true when SS transitions from asserted to de-asserted
     bool SPI1_isStopped(void);
-
+    
     //Clears the start flag
     void SPI1_clearStartFlag(void);
     
@@ -81,14 +116,26 @@ extern "C" {
     //Disable SPI Interrupts
     void SPI1_disableInterrupts(void);
     
+    //Enable the TX interrupt only
+    void SPI1_enableTXInterrupt(void);
+    
+    //Disable the TX interrupt only
+    void SPI1_disableTXInterrupt(void);
+    
+#ifndef SPI1_FAST_PATH
+    
     //Sets a TX callback function when new data can be sent
     //Interrupts must be enabled for the callback to be run
+    //Not available if SPI1_FAST_PATH is defined
     void SPI1_setTXHandler(uint8_t (*callback)(void));
     
     //Sets an RX callback function when new data can be read
     //Interrupts must be enabled for the callback to be run
+    //Not available if SPI1_FAST_PATH is defined
     void SPI1_setRXHandler(void (*callback)(uint8_t));
     
+#endif
+    
     //Sets a callback function when SS is asserted
     //Interrupts must be enabled for the callback to be run
     void SPI1_setStartHandler(void (*callback)(void));
@@ -96,7 +143,54 @@ extern "C" {
     //Sets a callback function when SS is de-asserted
     //Interrupts must be enabled for the callback to be run
     void SPI1_setStopHandler(void (*callback)(void));
-
+    
+    
+    //Sets a callback function when the RX FIFO overflows or the TX FIFO underflows
+    //The callback gets the SPI1_ERROR_* flags. Pass 0x00 to count errors only
+    //Interrupts must be enabled for the callback to be run
+    void SPI1_setErrorHandler(void (*callback)(uint8_t));
+    
+    //If enabled, the rest of the frame is discarded after an error
+    //The RX and TX handlers are not called until SS is asserted again
+    void SPI1_setResync(bool enable);
+    
+    //Returns true if the current frame is being discarded after an error
+    bool SPI1_isResyncing(void);
+    
+    //Returns the number of RX FIFO overflows
+    uint16_t SPI1_getRXOverflowCount(void);
+    
+    //Returns the number of TX FIFO underflows
+    uint16_t SPI1_getTXUnderflowCount(void);
+    
+    //Clears the error counters
+    void SPI1_clearErrorCounts(void);
+    
+#ifdef SPI1_ISR_STATS
+    
+    //Starts Timer1 as a free-running timer and clears the statistics
+    //Enables the overflow and underflow flags
+    void SPI1_initStats(void);
+    
+    //Copies the statistics
+    void SPI1_getStats(SPI1_stats_t* stats);
+    
+    //Returns the average time spent in a SPI ISR
+    uint16_t SPI1_getAverageISRCycles(void);
+    
+#endif
+    
+#ifdef SPI1_TRACE
+    
+    //Clears the trace and enables the interrupts used to record frames
+    //Frames are recorded when SS is de-asserted
+    void SPI1_initTrace(void);
+    
+    //Sets the bytes of the current frame when they were moved without the
+    //byte ISRs. Call from the stop handler - the record is added after it
+    void SPI1_traceSetFrame(const uint8_t* txData, uint16_t txLen, const uint8_t* rxData, uint16_t rxLen);
+    
+#endif
     
 #ifdef	__cplusplus
 }
@@ -0,0 +1,254 @@
+#include "spi1_client_dma.h"
+#include "spi1_client.h"
+
+#ifdef SPI1_TRACE
+#include "spi1_trace.h"
+#endif
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Capture buffer
+static uint8_t* captureBuffer = 0;
+static uint16_t captureSize = 0;
+static void (*captureCallback)(uint16_t) = 0;
+
+//Reply for each frame
+static uint8_t* replyData = 0;
+static uint16_t replyLen = 0;
+
+//Source of the TX channel when no reply is set (must be in RAM)
+static uint8_t fillByte = SPI1_DMA_FILL;
+
+//True while frameCallback runs - the stop handler loads the reply after it
+static bool inFrameCallback = false;
+
+//Loads the RX channel to move SPI1RXB into the capture buffer
+static void SPI1_DMA_armCapture(void)
+{
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    //Source is fixed, destination increments and stops at the end
+    DMAnCON1 = 0x60;
+    
+    //Source is the RX FIFO
+    DMAnSSA = (uint24_t) &SPI1RXB;
+    DMAnSSZ = 1;
+    
+    //Destination is the capture buffer
+    DMAnDSA = (uint16_t) captureBuffer;
+    DMAnDSZ = captureSize;
+    
+    //Move a byte every time the RX FIFO has data
+    DMAnSIRQ = SPI1_DMA_TRIGGER_RX;
+    
+    //Enable channel, start on trigger
+    DMAnCON0 = 0xC0;
+}
+
+//Loads the TX channel with the reply (or the fill byte)
+//The channel fills the TX FIFO before the frame starts. The destination and
+//trigger are set by SPI1_DMA_startCapture, so only the source is written here
+static void SPI1_DMA_armReply(void)
+{
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    if (replyLen != 0)
+    {
+        //Source increments and stops at the end, destination is fixed
+        DMAnCON1 = 0x03;
+        DMAnSSA = (uint24_t) replyData;
+        DMAnSSZ = replyLen;
+    }
+    else
+    {
+        //Source is fixed and never stops
+        DMAnCON1 = 0x00;
+        DMAnSSA = (uint24_t) &fillByte;
+        DMAnSSZ = 1;
+    }
+    
+    //Enable channel, start on trigger
+    DMAnCON0 = 0xC0;
+}
+
+//Sets the parts of the TX channel that stay the same for every reply
+static void SPI1_DMA_initReply(void)
+{
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    //Destination is the TX FIFO
+    DMAnDSA = (uint16_t) &SPI1TXB;
+    DMAnDSZ = 1;
+    
+    //Move a byte every time the TX FIFO has space
+    DMAnSIRQ = SPI1_DMA_TRIGGER_TX;
+}
+
+#ifdef SPI1_TRACE
+
+//Gives the trace the bytes of the frame - the byte ISRs that record them are off
+static void SPI1_DMA_traceFrame(uint16_t len)
+{
+    if (replyLen != 0)
+    {
+        SPI1_traceSetFrame(replyData, (len < replyLen) ? len : replyLen, captureBuffer, len);
+    }
+    else
+    {
+        uint8_t fill[SPI1_TRACE_DATA_BYTES / 2];
+        for (uint8_t i = 0; i < sizeof(fill); i++)
+        {
+            fill[i] = fillByte;
+        }
+        SPI1_traceSetFrame(&fill[0], len, captureBuffer, len);
+    }
+}
+
+#endif
+
+//Stop handler - reports the frame and re-arms both channels
+static void SPI1_DMA_frameStop(void)
+{
+    uint16_t len;
+    
+    //Main code may be using another channel
+    uint8_t channel = DMASELECT;
+    
+    //SIRQEN is cleared by hardware if the buffer filled up
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    len = (DMAnCON0bits.SIRQEN) ? (captureSize - DMAnDCNT) : captureSize;
+    DMAnCON0 = 0x00;
+    
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    //Discard the TX lookahead bytes and any bytes past the buffer
+    SPI1_flushBuffer();
+    
+#ifdef SPI1_TRACE
+    //Before the callback, which can change the reply
+    SPI1_DMA_traceFrame(len);
+#endif
+    
+    if (captureCallback != 0)
+    {
+        inFrameCallback = true;
+        captureCallback(len);
+        inFrameCallback = false;
+    }
+    
+    //Ready for the next frame before SS can be asserted again. The reply
+    //first: the TX FIFO must be full before the first SCK edge, while the RX
+    //channel has until the end of the first byte
+    SPI1_DMA_armReply();
+    SPI1_DMA_armCapture();
+    
+    DMASELECT = channel;
+}
+
+//Initializes the DMA channels used by the SPI Client
+void SPI1_DMA_initClient(void)
+{
+    //Make sure both channels are off
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    //Priorities (lower is higher) - RX is drained before TX is filled
+    ISRPR = 0;
+    DMA2PR = 1;
+    DMA1PR = 2;
+    MAINPR = 3;
+    
+    //Lock priorities - required for the DMA to run
+    PRLOCK = 0x55;
+    PRLOCK = 0xAA;
+    PRLOCKbits.PRLOCKED = 1;
+}
+
+//Starts capturing frames into rxBuffer with DMA
+bool SPI1_DMA_startCapture(uint8_t* rxBuffer, uint16_t rxSize, void (*frameCallback)(uint16_t))
+{
+    if ((rxSize == 0) || (rxSize > SPI1_DMA_MAX_LEN))
+    {
+        return false;
+    }
+    
+    //Bytes are moved by the DMA - only the frame edges interrupt the CPU
+    PIE3bits.SPI1TXIE = 0;
+    PIE3bits.SPI1RXIE = 0;
+    
+    captureBuffer = rxBuffer;
+    captureSize = rxSize;
+    captureCallback = frameCallback;
+    
+    SPI1_flushBuffer();
+    SPI1_DMA_armCapture();
+    SPI1_DMA_initReply();
+    SPI1_DMA_armReply();
+    
+    SPI1_setStopHandler(&SPI1_DMA_frameStop);
+    PIE3bits.SPI1IE = 1;
+    
+    return true;
+}
+
+//Sets the reply sent in each following frame
+void SPI1_DMA_setReply(uint8_t* data, uint16_t len)
+{
+    if (len > SPI1_DMA_MAX_LEN)
+    {
+        len = SPI1_DMA_MAX_LEN;
+    }
+    
+    if (inFrameCallback)
+    {
+        //The stop handler has flushed the FIFOs and loads the reply when the
+        //callback returns. Loading it here too would queue it twice
+        replyData = data;
+        replyLen = len;
+        return;
+    }
+    
+    //Stop the status ISR while the reply is swapped
+    bool ie = PIE3bits.SPI1IE;
+    PIE3bits.SPI1IE = 0;
+    
+    replyData = data;
+    replyLen = len;
+    
+    if (captureBuffer != 0)
+    {
+        uint8_t channel = DMASELECT;
+        
+        //Drop the bytes already queued from the old reply
+        DMASELECT = SPI1_DMA_TX_CHANNEL;
+        DMAnCON0 = 0x00;
+        SPI1STATUSbits.CLRBF = 1;
+        SPI1_DMA_armReply();
+        
+        DMASELECT = channel;
+    }
+    
+    PIE3bits.SPI1IE = ie;
+}
+
+//Stops capturing frames and releases the channels
+void SPI1_DMA_stopCapture(void)
+{
+    SPI1_setStopHandler(0);
+    
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    captureBuffer = 0;
+    SPI1_flushBuffer();
+}
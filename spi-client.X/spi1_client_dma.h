@@ -0,0 +1,70 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_CLIENT_DMA_H
+#define	SPI1_CLIENT_DMA_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//DMA channels used for frame capture (DMASELECT value, 0 = DMA1)
+#define SPI1_DMA_TX_CHANNEL 0
+#define SPI1_DMA_RX_CHANNEL 1
+    
+//Largest frame or reply the DMA counters can move
+#define SPI1_DMA_MAX_LEN 4095
+    
+//DMA trigger sources (interrupt vector numbers of the SPI1 flags)
+#define SPI1_DMA_TRIGGER_RX 0x18
+#define SPI1_DMA_TRIGGER_TX 0x19
+    
+//Byte sent when no reply is set
+#define SPI1_DMA_FILL 0x00
+    
+    //Initializes the DMA channels used by the SPI Client
+    //Locks the system arbiter priorities - call with interrupts disabled
+    void SPI1_DMA_initClient(void);
+    
+    //Starts capturing frames into rxBuffer (up to rxSize bytes) with DMA
+    //frameCallback is run from the status ISR at the end of each frame with the
+    //received length. The frame is in rxBuffer until the callback returns
+    //Replaces the stop handler and disables the TX and RX interrupts
+    //Returns false if rxSize is 0 or above SPI1_DMA_MAX_LEN
+    bool SPI1_DMA_startCapture(uint8_t* rxBuffer, uint16_t rxSize, void (*frameCallback)(uint16_t));
+    
+    //Sets the reply sent in each following frame. DATA must be in RAM, it is not copied
+    //If the host clocks more than LEN bytes, the TX FIFO underflows
+    //Pass LEN = 0 to send SPI1_DMA_FILL. Call between frames or from frameCallback
+    //(the reply is then loaded when the callback returns)
+    void SPI1_DMA_setReply(uint8_t* data, uint16_t len);
+    
+    //Stops capturing frames and releases the channels
+    void SPI1_DMA_stopCapture(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_CLIENT_DMA_H */
+
@@ -0,0 +1,135 @@
+#include "spi1_crcframe.h"
+#include "spi1_client.h"
+#include "crc.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+static void (*dataCallback)(uint8_t) = 0;
+static void (*frameCallback)(bool) = 0;
+
+//Last CRC_SIZE bytes received - only passed on once more data follows
+static uint8_t rxDelay[CRC_SIZE];
+static volatile uint8_t rxSlot = 0;
+static volatile uint8_t rxCount = 0;    //Stops at CRC_SIZE
+
+//Reply - the TX CRC is computed in software, the CRC module is used for RX
+static const uint8_t* txReply = 0;
+static volatile uint8_t txLen = 0;
+static volatile uint16_t txIndex = 0;
+static crc_t txCRC = CRC_SEED;
+
+static volatile uint8_t crcErrors = 0;
+
+//Sets the handlers that receive checked frames
+void SPI1_initCRCFrames(void (*rxHandler)(uint8_t), void (*frameHandler)(bool))
+{
+    dataCallback = rxHandler;
+    frameCallback = frameHandler;
+    
+    rxSlot = 0;
+    rxCount = 0;
+    txReply = 0;
+    txLen = 0;
+    txIndex = 0;
+    txCRC = CRC_SEED;
+    crcErrors = 0;
+}
+
+//Start handler - restarts the CRCs
+void SPI1_crcStartHandler(void)
+{
+    rxSlot = 0;
+    rxCount = 0;
+    CRC_startHardware();
+}
+
+//Stop handler - checks the received CRC
+void SPI1_crcStopHandler(void)
+{
+    //Discard the TX lookahead bytes and any unread data
+    SPI1_flushBuffer();
+    
+    //CRC over data and CRC bytes is 0 if the frame is intact
+    bool valid = (rxCount == CRC_SIZE) && (!SPI1_isResyncing())
+            && (CRC_getHardware() == CRC_RESIDUE);
+    
+    if (!valid)
+    {
+        crcErrors++;
+    }
+    
+    //Reply is only sent once
+    txLen = 0;
+    txIndex = 0;
+    
+    if (frameCallback != 0)
+    {
+        frameCallback(valid);
+    }
+}
+
+//RX handler - adds a byte to the received CRC
+void SPI1_crcRXHandler(uint8_t data)
+{
+    CRC_updateHardware(data);
+    
+    if (rxCount < CRC_SIZE)
+    {
+        rxCount++;
+    }
+    else if (dataCallback != 0)
+    {
+        //Byte received CRC_SIZE bytes ago can't be part of the CRC
+        dataCallback(rxDelay[rxSlot]);
+    }
+    
+    rxDelay[rxSlot] = data;
+    rxSlot = (rxSlot + 1) % CRC_SIZE;
+}
+
+//TX handler - sends the reply followed by its CRC, then 0x00
+uint8_t SPI1_crcTXHandler(void)
+{
+    uint8_t data = 0x00;
+    
+    if (txIndex < txLen)
+    {
+        data = txReply[txIndex];
+        txCRC = CRC_update(txCRC, data);
+        txIndex++;
+    }
+    else if ((txLen != 0) && (txIndex < (uint16_t) (txLen + CRC_SIZE)))
+    {
+        //Reply is done, append the CRC
+        data = CRC_getByte(txCRC, (uint8_t) (txIndex - txLen));
+        txIndex++;
+    }
+    
+    return data;
+}
+
+//Sets the reply sent in the next frame
+void SPI1_setCRCReply(const uint8_t* data, uint8_t len)
+{
+    //Stop the TX ISR while the reply is swapped
+    bool ie = PIE3bits.SPI1TXIE;
+    PIE3bits.SPI1TXIE = 0;
+    
+    txReply = data;
+    txIndex = 0;
+    txCRC = CRC_SEED;
+    txLen = len;
+    
+    //Drop the 0x00 fill bytes already queued
+    SPI1_flushBuffer();
+    
+    PIE3bits.SPI1TXIE = ie;
+}
+
+//Returns the number of frames with a bad CRC
+uint8_t SPI1_getCRCErrors(void)
+{
+    return crcErrors;
+}
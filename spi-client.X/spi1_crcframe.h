@@ -0,0 +1,61 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_CRCFRAME_H
+#define	SPI1_CRCFRAME_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+    //Sets the handlers that receive checked frames
+    //rxHandler gets the data bytes of a frame - the CRC bytes are held back
+    //frameHandler is run at the end of each frame with the result of the check
+    //Call before attaching the CRC handlers
+    void SPI1_initCRCFrames(void (*rxHandler)(uint8_t), void (*frameHandler)(bool));
+    
+    //Start handler - restarts the CRCs (attach with SPI1_setStartHandler)
+    void SPI1_crcStartHandler(void);
+    
+    //Stop handler - checks the received CRC (attach with SPI1_setStopHandler)
+    void SPI1_crcStopHandler(void);
+    
+    //RX handler - adds a byte to the received CRC (attach with SPI1_setRXHandler)
+    void SPI1_crcRXHandler(uint8_t data);
+    
+    //TX handler - sends the reply followed by its CRC, then 0x00 (attach with SPI1_setTXHandler)
+    uint8_t SPI1_crcTXHandler(void);
+    
+    //Sets the reply sent in the next frame. DATA is not copied
+    //Must be called between frames - the TX FIFO is flushed
+    void SPI1_setCRCReply(const uint8_t* data, uint8_t len);
+    
+    //Returns the number of frames with a bad CRC
+    uint8_t SPI1_getCRCErrors(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_CRCFRAME_H */
+
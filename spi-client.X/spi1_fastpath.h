@@ -0,0 +1,56 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_FASTPATH_H
+#define	SPI1_FASTPATH_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+    
+//Byte handlers compiled into the client ISRs when SPI1_FAST_PATH is defined
+//Only spi1_client.c includes this header. Replace the sample bodies with the
+//application's handlers. To stay inline, they may only use data declared
+//here (extern variables can be defined in an application file)
+//Each is run once per byte inside the ISR and must be short
+    
+//Sample: each received byte is sent back (loopback)
+static volatile uint8_t fastLastRX = 0x00;
+    
+//Called with each received byte
+static inline void SPI1_fastRX(uint8_t data)
+{
+    fastLastRX = data;
+}
+    
+//Returns the next byte to transmit
+static inline uint8_t SPI1_fastTX(void)
+{
+    return fastLastRX;
+}
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_FASTPATH_H */
+
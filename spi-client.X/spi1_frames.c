@@ -0,0 +1,230 @@
+#include "spi1_frames.h"
+#include "spi1_client.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Received frames - rxHead is written by the ISR, rxTail by the application
+static uint8_t frames[SPI1_FRAME_COUNT][SPI1_FRAME_SIZE];
+static volatile uint8_t frameLength[SPI1_FRAME_COUNT];
+static volatile uint8_t rxHead = 0, rxTail = 0;
+
+//State of the frame being received
+static volatile bool rxOpen = false;
+static volatile uint8_t rxFill = 0;
+
+//Transmit ring - txHead is written by the application, txTail by the ISR
+static uint8_t txRing[SPI1_TX_RING_SIZE];
+static volatile uint8_t txHead = 0, txTail = 0;
+
+//Source of the last bytes loaded into the TX FIFO (bit 0 is the newest)
+//A set bit is a byte from the ring, a clear bit is 0x00 filler
+static volatile uint8_t txLoaded = 0;
+
+//Set while SS is asserted
+static volatile bool frameActive = false;
+
+//Error counters
+static volatile uint8_t droppedFrames = 0;
+static volatile uint8_t longFrames = 0;
+static volatile uint8_t txUnderruns = 0;
+
+//Clears all frames and queued transmit data
+void SPI1_initFrames(void)
+{
+    rxHead = 0;
+    rxTail = 0;
+    rxOpen = false;
+    rxFill = 0;
+    
+    txHead = 0;
+    txTail = 0;
+    txLoaded = 0;
+    frameActive = false;
+    
+    droppedFrames = 0;
+    longFrames = 0;
+    txUnderruns = 0;
+}
+
+//Returns the ring bytes in the TX FIFO to the ring and empties both FIFOs
+//Returns the number of filler bytes that were in the TX FIFO
+static uint8_t SPI1_returnTXBytes(void)
+{
+    uint8_t count = SPI1_getTXCount();
+    uint8_t fillers = 0;
+    
+    //The newest bytes are the ones still waiting
+    for (uint8_t i = 0; i < count; i++)
+    {
+        if (txLoaded & (1 << i))
+        {
+            //Ring bytes are loaded in order, so the newest is at txTail - 1
+            txTail--;
+        }
+        else
+        {
+            fillers++;
+        }
+    }
+    
+    SPI1_flushBuffer();
+    txLoaded = 0;
+    
+    return fillers;
+}
+
+//Start handler - opens a new frame
+void SPI1_frameStartHandler(void)
+{
+    frameActive = true;
+    rxFill = 0;
+    
+    if ((uint8_t) (rxHead - rxTail) < SPI1_FRAME_COUNT)
+    {
+        rxOpen = true;
+    }
+    else
+    {
+        //No free slot
+        rxOpen = false;
+        droppedFrames++;
+    }
+}
+
+//Stop handler - completes the frame
+void SPI1_frameStopHandler(void)
+{
+    //Bytes loaded ahead of the bus are sent in the next frame instead
+    SPI1_returnTXBytes();
+    frameActive = false;
+    
+    if ((rxOpen) && (SPI1_isResyncing()))
+    {
+        //Frame lost data after a FIFO error
+        droppedFrames++;
+    }
+    else if ((rxOpen) && (rxFill != 0))
+    {
+        //Length is written before the frame is published
+        frameLength[rxHead % SPI1_FRAME_COUNT] = rxFill;
+        rxHead++;
+    }
+    
+    rxOpen = false;
+}
+
+//RX handler - stores a byte in the open frame
+void SPI1_frameRXHandler(uint8_t data)
+{
+    if (!rxOpen)
+    {
+        return;
+    }
+    
+    if (rxFill < SPI1_FRAME_SIZE)
+    {
+        frames[rxHead % SPI1_FRAME_COUNT][rxFill] = data;
+        rxFill++;
+    }
+    else
+    {
+        //Frame is too long
+        rxOpen = false;
+        droppedFrames++;
+        longFrames++;
+    }
+}
+
+//TX handler - returns the next queued byte, or 0x00
+uint8_t SPI1_frameTXHandler(void)
+{
+    if (txHead == txTail)
+    {
+        if (frameActive)
+        {
+            txUnderruns++;
+        }
+        
+        txLoaded <<= 1;
+        return 0x00;
+    }
+    
+    uint8_t data = txRing[txTail % SPI1_TX_RING_SIZE];
+    txTail++;
+    txLoaded = (uint8_t) ((txLoaded << 1) | 0x01);
+    return data;
+}
+
+//Returns the oldest completed frame in place, or 0 if there are none
+uint8_t* SPI1_getFrame(uint8_t* len)
+{
+    if (rxHead == rxTail)
+    {
+        return 0;
+    }
+    
+    *len = frameLength[rxTail % SPI1_FRAME_COUNT];
+    return &frames[rxTail % SPI1_FRAME_COUNT][0];
+}
+
+//Releases the oldest completed frame
+void SPI1_releaseFrame(void)
+{
+    if (rxHead != rxTail)
+    {
+        rxTail++;
+    }
+}
+
+//Queues LEN bytes to be transmitted. Returns the number of bytes queued
+uint8_t SPI1_queueReply(const uint8_t* data, uint8_t len)
+{
+    uint8_t count = 0;
+    
+    //2 slots are kept for bytes returned from the TX FIFO
+    while ((count < len) && ((uint8_t) (txHead - txTail) < (SPI1_TX_RING_SIZE - 2)))
+    {
+        //Byte is stored before it is published
+        txRing[txHead % SPI1_TX_RING_SIZE] = data[count];
+        txHead++;
+        count++;
+    }
+    
+    if ((count != 0) && (!frameActive))
+    {
+        //Between frames, filler loaded while the ring was empty would be sent
+        //ahead of the reply. Replace it with the reply
+        //SOSIF is set as soon as SS is asserted, before the first clock
+        bool gie = INTCON0bits.GIE;
+        INTCON0bits.GIE = 0;
+        
+        if ((!frameActive) && (SPI1INTFbits.SOSIF == 0))
+        {
+            SPI1_returnTXBytes();
+        }
+        
+        INTCON0bits.GIE = gie;
+    }
+    
+    return count;
+}
+
+//Returns the number of frames dropped
+uint8_t SPI1_getDroppedFrames(void)
+{
+    return droppedFrames;
+}
+
+//Returns the number of frames dropped because they were too long
+uint8_t SPI1_getLongFrames(void)
+{
+    return longFrames;
+}
+
+//Returns the number of times 0x00 was sent because no data was queued
+uint8_t SPI1_getTXUnderruns(void)
+{
+    return txUnderruns;
+}
@@ -0,0 +1,82 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_FRAMES_H
+#define	SPI1_FRAMES_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Number of received frames that can be stored (power of 2)
+#define SPI1_FRAME_COUNT 4
+    
+//Largest frame that can be received. Longer frames are dropped
+#define SPI1_FRAME_SIZE 64
+    
+//Size of the transmit ring buffer (power of 2)
+#define SPI1_TX_RING_SIZE 64
+    
+    //Clears all frames and queued transmit data
+    //Call before attaching the handlers
+    void SPI1_initFrames(void);
+    
+    //Start handler - opens a new frame (attach with SPI1_setStartHandler)
+    void SPI1_frameStartHandler(void);
+    
+    //Stop handler - completes the frame (attach with SPI1_setStopHandler)
+    void SPI1_frameStopHandler(void);
+    
+    //RX handler - stores a byte in the open frame (attach with SPI1_setRXHandler)
+    void SPI1_frameRXHandler(uint8_t data);
+    
+    //TX handler - returns the next queued byte, or 0x00 (attach with SPI1_setTXHandler)
+    uint8_t SPI1_frameTXHandler(void);
+    
+    //Returns the oldest completed frame in place, or 0 if there are none
+    //LEN is set to the number of bytes in the frame
+    //The frame stays valid until SPI1_releaseFrame is called
+    uint8_t* SPI1_getFrame(uint8_t* len);
+    
+    //Releases the oldest completed frame
+    void SPI1_releaseFrame(void);
+    
+    //Queues LEN bytes to be transmitted. Returns the number of bytes queued
+    uint8_t SPI1_queueReply(const uint8_t* data, uint8_t len);
+    
+    //Returns the number of frames dropped (no free slot, too long or FIFO error)
+    uint8_t SPI1_getDroppedFrames(void);
+    
+    //Returns the number of frames dropped because they were longer than
+    //SPI1_FRAME_SIZE (also counted by SPI1_getDroppedFrames)
+    uint8_t SPI1_getLongFrames(void);
+    
+    //Returns the number of times 0x00 was sent because no data was queued
+    uint8_t SPI1_getTXUnderruns(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_FRAMES_H */
+
@@ -0,0 +1,164 @@
+#include "spi1_regmap.h"
+#include "spi1_client.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//The register map attaches its own TX and RX callbacks, which are removed by
+//SPI1_FAST_PATH
+#ifndef SPI1_FAST_PATH
+
+typedef enum {
+    REGMAP_IDLE = 0, REGMAP_COMMAND, REGMAP_READ, REGMAP_WRITE
+} regmap_state_t;
+
+static const SPI1_register_t* registers = 0;
+static uint8_t registerCount = 0;
+
+static volatile regmap_state_t state = REGMAP_IDLE;
+
+//The command byte and the turnaround are pre-loaded into the 2-byte TX FIFO
+#if (SPI1_REGMAP_TURNAROUND + 1) > 2
+#error "SPI1_REGMAP_TURNAROUND must be 0 or 1"
+#endif
+
+//Next address to write (RX), to stage (TX) and sent to the host (RX)
+static volatile uint8_t rxAddress = 0, txAddress = 0, readAddress = 0;
+
+//Bytes received since the read command
+static volatile uint8_t readCount = 0;
+
+//Loads the FIFO for the command byte and the turnaround of the next frame
+//The TX interrupt stays off until the command is decoded
+static void SPI1_regmapPrefill(void)
+{
+    SPI1_disableTXInterrupt();
+    SPI1_flushBuffer();
+    
+    for (uint8_t i = 0; i < (SPI1_REGMAP_TURNAROUND + 1); i++)
+    {
+        SPI1_writeData(SPI1_REGMAP_FILL);
+    }
+}
+
+//SS asserted - wait for the command byte
+static void SPI1_regmapStart(void)
+{
+    //FIFO was loaded at the end of the last frame
+    state = REGMAP_COMMAND;
+}
+
+//SS de-asserted - end of the access
+static void SPI1_regmapStop(void)
+{
+    state = REGMAP_IDLE;
+    
+    //Done here, so the FIFO is ready long before the next SS assertion
+    SPI1_regmapPrefill();
+}
+
+static void SPI1_regmapRX(uint8_t data)
+{
+    switch (state)
+    {
+        case REGMAP_COMMAND:
+        {
+            uint8_t address = data & SPI1_REGMAP_ADDR_MASK;
+            
+            if (data & SPI1_REGMAP_READ)
+            {
+                //Stage read data from here on
+                txAddress = address;
+                readAddress = address;
+                readCount = 0;
+                state = REGMAP_READ;
+            }
+            else
+            {
+                rxAddress = address;
+                state = REGMAP_WRITE;
+            }
+            
+            //Keep the TX FIFO fed (with SPI1_REGMAP_FILL during writes)
+            SPI1_enableTXInterrupt();
+            break;
+        }
+        case REGMAP_READ:
+        {
+            //A byte was sent for each byte received
+            if (readCount < SPI1_REGMAP_TURNAROUND)
+            {
+                readCount++;
+            }
+            else
+            {
+                if ((readAddress < registerCount) && (registers[readAddress].flags & SPI1_REG_READ)
+                        && (registers[readAddress].onRead != 0))
+                {
+                    registers[readAddress].onRead(readAddress);
+                }
+                
+                readAddress++;
+            }
+            break;
+        }
+        case REGMAP_WRITE:
+        {
+            if ((rxAddress < registerCount) && (registers[rxAddress].flags & SPI1_REG_WRITE))
+            {
+                *registers[rxAddress].data = data;
+                
+                if (registers[rxAddress].onWrite != 0)
+                {
+                    registers[rxAddress].onWrite(rxAddress, data);
+                }
+            }
+            
+            rxAddress++;
+            break;
+        }
+        default:
+        {
+            //Bytes clocked in during a read (or outside a frame) are ignored
+            break;
+        }
+    }
+}
+
+static uint8_t SPI1_regmapTX(void)
+{
+    uint8_t value = SPI1_REGMAP_FILL;
+    
+    if (state != REGMAP_READ)
+    {
+        return value;
+    }
+    
+    //Staged up to 2 bytes ahead of the bus, so no hooks are run here
+    if ((txAddress < registerCount) && (registers[txAddress].flags & SPI1_REG_READ))
+    {
+        value = *registers[txAddress].data;
+    }
+    
+    txAddress++;
+    return value;
+}
+
+//Attaches the register map to the client driver
+void SPI1_initRegisterMap(const SPI1_register_t* table, uint8_t count)
+{
+    registers = table;
+    registerCount = count;
+    state = REGMAP_IDLE;
+    
+    SPI1_setTXHandler(&SPI1_regmapTX);
+    SPI1_setRXHandler(&SPI1_regmapRX);
+    SPI1_setStartHandler(&SPI1_regmapStart);
+    SPI1_setStopHandler(&SPI1_regmapStop);
+    
+    //Ready for the first frame
+    SPI1_regmapPrefill();
+}
+
+#endif
@@ -0,0 +1,65 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_REGMAP_H
+#define	SPI1_REGMAP_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Command byte - bit 7 selects a read, bits 6:0 are the start address
+#define SPI1_REGMAP_READ 0x80
+#define SPI1_REGMAP_ADDR_MASK 0x7F
+    
+//Filler bytes sent after the command byte, before read data (0 or 1)
+//Gives the ISR one byte time to stage data into the TX FIFO
+#define SPI1_REGMAP_TURNAROUND 1
+    
+//Value returned for unmapped or write-only registers
+#define SPI1_REGMAP_FILL 0x00
+    
+//Register flags
+#define SPI1_REG_READ 0x01
+#define SPI1_REG_WRITE 0x02
+    
+    //Register table entry
+    typedef struct {
+        volatile uint8_t* data;                     //Register storage
+        uint8_t flags;                              //SPI1_REG_READ and/or SPI1_REG_WRITE
+        void (*onRead)(uint8_t address);            //Run after the value was sent to the host (can be 0)
+        void (*onWrite)(uint8_t address, uint8_t value);    //Run after the value is stored (can be 0)
+    } SPI1_register_t;
+    
+    //Attaches the register map to the client driver
+    //Replaces the TX, RX, start and stop handlers
+    //Not available if SPI1_FAST_PATH is defined
+    //Interrupts must be enabled for the register map to run
+    void SPI1_initRegisterMap(const SPI1_register_t* table, uint8_t count);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_REGMAP_H */
+
@@ -0,0 +1,52 @@
+#include "spi2_client.h"
+#include "spi_config.h"
+#include "interrupts.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Only built on devices with a second SPI module
+#ifdef SPI2CON0
+
+//Core functions are generated from the client template
+#define SPI_INSTANCE 2
+#define SPIx_TXIF PIR7bits.SPI2TXIF
+#define SPIx_RXIF PIR7bits.SPI2RXIF
+#define SPIx_TXIE PIE7bits.SPI2TXIE
+#define SPIx_RXIE PIE7bits.SPI2RXIE
+#define SPIx_IE PIE7bits.SPI2IE
+#define SPIx_ISRS
+#include "spi_client_template.h"
+
+//Initializes the I/O for the SPI2 Client
+void SPI2_initPins(void)
+{
+    //Pins are set in spi_config.h
+    //RB2 - SDO
+    //RB3 - SDI
+    //RB1 - SCK
+    //RB4 - SS2
+    
+    //SDO Config
+    SPI_PIN_TRIS(SPI2_CFG_SDO_PIN) = 1;     //Set as input for tri-stating
+    SPI_PIN_ANSEL(SPI2_CFG_SDO_PIN) = 0;
+    SPI_PIN_PPS(SPI2_CFG_SDO_PIN) = SPI2_PPS_SDO;
+    
+    //SDI Config
+    SPI_PIN_TRIS(SPI2_CFG_SDI_PIN) = 1;
+    SPI_PIN_ANSEL(SPI2_CFG_SDI_PIN) = 0;
+    SPI2SDIPPS = SPI_PIN_INPUT(SPI2_CFG_SDI_PIN);
+    
+    //SCK Config
+    SPI_PIN_TRIS(SPI2_CFG_SCK_PIN) = 1;
+    SPI_PIN_ANSEL(SPI2_CFG_SCK_PIN) = 0;
+    SPI2SCKPPS = SPI_PIN_INPUT(SPI2_CFG_SCK_PIN);
+    
+    //SS Config
+    SPI_PIN_TRIS(SPI2_CFG_SS_PIN) = 1;
+    SPI_PIN_ANSEL(SPI2_CFG_SS_PIN) = 0;
+    SPI2SSPPS = SPI_PIN_INPUT(SPI2_CFG_SS_PIN);
+}
+
+#endif
@@ -0,0 +1,114 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI2_CLIENT_H
+#define	SPI2_CLIENT_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+    //Initializes a SPI2 Client
+    //I/O must be initialized separately
+    //TX and RX are enabled separately
+    void SPI2_initClient(void);
+    
+    //Initializes the I/O for the SPI2 Client
+    void SPI2_initPins(void);
+    
+    //Flushes the SPI Buffer
+    void SPI2_flushBuffer(void);
+    
+    //Returns true if the RX FIFO can be read from
+    bool SPI2_canReadData(void);
+    
+    //Returns true if the TX FIFO can accept data
+    bool SPI2_canWriteData(void);
+    
+    //Returns the number of bytes waiting in the TX FIFO (0 to 2)
+    uint8_t SPI2_getTXCount(void);
+    
+    //Returns true when SS transitions from de-asserted to asserted
+    bool SPI2_isStarted(void);
+    
+    //Returns true when SS transitions from asserted to de-asserted
+    bool SPI2_isStopped(void);
+
+    //Clears the start flag
+    void SPI2_clearStartFlag(void);
+    
+    //Clears the stop flag
+    void SPI2_clearStopFlag(void);
+    
+    //Reads a byte of data from the RX FIFO
+    uint8_t SPI2_readData(void);
+    
+    //Writes a byte of data to the TX FIFO
+    void SPI2_writeData(uint8_t data);
+    
+    //Enable TX
+    void SPI2_enableTransmit(void);
+    
+    //Disable TX
+    void SPI2_disableTransmit(void);
+    
+    //Enable RX
+    void SPI2_enableReceive(void);
+    
+    //Disable RX
+    void SPI2_disableReceive(void);
+    
+    //Enable SPI Interrupts
+    void SPI2_enableInterrupts(void);
+    
+    //Disable SPI Interrupts
+    void SPI2_disableInterrupts(void);
+    
+    //Enable the TX interrupt only
+    void SPI2_enableTXInterrupt(void);
+    
+    //Disable the TX interrupt only
+    void SPI2_disableTXInterrupt(void);
+    
+    //Sets a TX callback function when new data can be sent
+    //Interrupts must be enabled for the callback to be run
+    void SPI2_setTXHandler(uint8_t (*callback)(void));
+    
+    //Sets an RX callback function when new data can be read
+    //Interrupts must be enabled for the callback to be run
+    void SPI2_setRXHandler(void (*callback)(uint8_t));
+    
+    //Sets a callback function when SS is asserted
+    //Interrupts must be enabled for the callback to be run
+    void SPI2_setStartHandler(void (*callback)(void));
+    
+    //Sets a callback function when SS is de-asserted
+    //Interrupts must be enabled for the callback to be run
+    void SPI2_setStopHandler(void (*callback)(void));
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI2_CLIENT_H */
+
@@ -0,0 +1,298 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+//SPI Client driver template
+//Generates the core functions of a client driver for one SPI module
+//Registers and functions are pasted at compile time, so there is no runtime
+//indirection. Not a stand-alone header - include once from spiN_client.c with:
+//
+//  #define SPI_INSTANCE n          //Module number (SPInCON0, SPIn_readData, ...)
+//  #define SPIx_TXIF PIRybits.SPInTXIF
+//  #define SPIx_RXIF PIRybits.SPInRXIF
+//  #define SPIx_TXIE PIEybits.SPInTXIE
+//  #define SPIx_RXIE PIEybits.SPInRXIE
+//  #define SPIx_IE PIEybits.SPInIE
+//  #define SPIx_FAST_PATH          //Optional - no TX / RX callbacks or setters
+//  #define SPIx_ISRS               //Optional - also generate the interrupt handlers
+//
+//The callbacks set here (rxCallback, txCallback, startCallback, stopCallback)
+//are run by the interrupt handlers, either generated here (SPIx_ISRS) or
+//written in spiN_client.c. Generated handlers need INTERRUPT_BASE from
+//interrupts.h. spi_config.h must define the SPIn register images
+
+#if !defined(SPI_INSTANCE) || !defined(SPIx_TXIF) || !defined(SPIx_RXIF) \
+    || !defined(SPIx_TXIE) || !defined(SPIx_RXIE) || !defined(SPIx_IE)
+#error "Define SPI_INSTANCE and the SPIx_ interrupt bits before including spi_client_template.h"
+#endif
+
+#if defined(SPIx_ISRS) && defined(SPIx_FAST_PATH)
+#error "The generated interrupt handlers run the TX / RX callbacks - write them in spiN_client.c for the fast path"
+#endif
+
+#include "spi_config.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//SPIx(name) expands to SPIn##name for the instance being generated
+#define SPI_PASTE(n, name) SPI ## n ## name
+#define SPI_EXPAND(n, name) SPI_PASTE(n, name)
+#define SPIx(name) SPI_EXPAND(SPI_INSTANCE, name)
+
+#ifndef SPIx_FAST_PATH
+static void (*rxCallback)(uint8_t) = 0;
+static uint8_t (*txCallback)(void) = 0;
+#endif
+static void (*startCallback)(void) = 0;
+static void (*stopCallback)(void) = 0;
+
+//Initializes a SPI Client
+//I/O must be initialized separately
+//TX and RX are enabled separately
+void SPIx(_initClient)(void)
+{
+    //Images are from spi_config.h
+    //Configure with the module disabled
+    SPIx(CON0) = SPIx(_CLIENT_CON0_IMAGE) & 0x7F;
+    SPIx(CON1) = SPIx(_CON1_IMAGE);
+    SPIx(CON2) = SPIx(_CON2_IMAGE);
+    SPIx(CLK) = SPIx(_CLK_IMAGE);
+    SPIx(BAUD) = SPIx(_BAUD_IMAGE);
+    SPIx(TWIDTH) = SPIx(_TWIDTH_IMAGE);
+    
+    //Clear Flags
+    SPIx(INTF) = 0x00;
+    
+    //Clear set interrupts
+    SPIx(INTE) = 0x00;
+    
+    //Enable Module
+    SPIx(CON0) = SPIx(_CLIENT_CON0_IMAGE);
+}
+
+//Flushes the SPI Buffer
+void SPIx(_flushBuffer)(void)
+{
+    SPIx(STATUSbits).CLRBF = 1;
+}
+
+//Returns true if the RX FIFO can be read from
+bool SPIx(_canReadData)(void)
+{
+    return SPIx_RXIF;
+}
+
+//Returns true if the TX FIFO can accept data
+bool SPIx(_canWriteData)(void)
+{
+    return SPIx_TXIF;
+}
+
+//Returns the number of bytes waiting in the TX FIFO (0 to 2)
+//The byte being shifted out is not counted
+uint8_t SPIx(_getTXCount)(void)
+{
+    if (SPIx(STATUSbits).TXBE)
+    {
+        return 0;
+    }
+    
+    return SPIx_TXIF ? 1 : 2;
+}
+
+//Returns true when SS transitions from de-asserted to asserted
+bool SPIx(_isStarted)(void)
+{
+    return SPIx(INTFbits).SOSIF;
+}
+
+//Returns true when SS transitions from asserted to de-asserted
+bool SPIx(_isStopped)(void)
+{
+    return SPIx(INTFbits).EOSIF;
+}
+
+//Clears the start flag
+void SPIx(_clearStartFlag)(void)
+{
+    SPIx(INTFbits).SOSIF = 0;
+}
+
+//Clears the stop flag
+void SPIx(_clearStopFlag)(void)
+{
+    SPIx(INTFbits).EOSIF = 0;
+}
+
+//Reads a byte of data from the RX FIFO
+uint8_t SPIx(_readData)(void)
+{
+    return SPIx(RXB);
+}
+
+//Writes a byte of data to the TX FIFO
+void SPIx(_writeData)(uint8_t data)
+{
+    SPIx(TXB) = data;
+}
+
+//Enable TX
+void SPIx(_enableTransmit)(void)
+{
+    SPIx(CON2bits).TXR = 1;
+}
+
+//Disable TX
+void SPIx(_disableTransmit)(void)
+{
+    SPIx(CON2bits).TXR = 0;
+}
+
+//Enable RX
+void SPIx(_enableReceive)(void)
+{
+    SPIx(CON2bits).RXR = 1;
+}
+
+//Disable RX
+void SPIx(_disableReceive)(void)
+{
+    SPIx(CON2bits).RXR = 0;
+}
+
+//Enable SPI Interrupts
+void SPIx(_enableInterrupts)(void)
+{
+    SPIx_TXIE = 1;
+    SPIx_RXIE = 1;
+    SPIx_IE = 1;
+}
+
+//Disable SPI Interrupts
+void SPIx(_disableInterrupts)(void)
+{
+    SPIx_TXIE = 0;
+    SPIx_RXIE = 0;
+    SPIx_IE = 0;
+}
+
+//Enable the TX interrupt only
+void SPIx(_enableTXInterrupt)(void)
+{
+    SPIx_TXIE = 1;
+}
+
+//Disable the TX interrupt only
+void SPIx(_disableTXInterrupt)(void)
+{
+    SPIx_TXIE = 0;
+}
+
+
+#ifndef SPIx_FAST_PATH
+
+//Sets a TX callback function when new data can be sent
+void SPIx(_setTXHandler)(uint8_t (*callback)(void))
+{
+    txCallback = callback;
+}
+
+//Sets an RX callback function when new data can be read
+void SPIx(_setRXHandler)(void (*callback)(uint8_t))
+{
+    rxCallback = callback;
+}
+
+#endif
+
+//Sets a callback function when SS is asserted
+//Interrupts must be enabled for the callback to be run
+void SPIx(_setStartHandler)(void (*callback)(void))
+{
+    //Enable Start Interrupt
+    SPIx(INTEbits).SOSIE = 1;
+    
+    startCallback = callback;
+}
+    
+//Sets a callback function when SS is de-asserted
+//Interrupts must be enabled for the callback to be run
+void SPIx(_setStopHandler)(void (*callback)(void))
+{
+    //Enable Stop Interrupt
+    SPIx(INTEbits).EOSIE = 1;
+    
+    stopCallback = callback;
+}
+
+#ifdef SPIx_ISRS
+
+void __interrupt(irq(SPIx(TX)), base(INTERRUPT_BASE)) SPIx(_readTX_ISR)(void)
+{
+    if (txCallback != 0)
+    {
+        SPIx(TXB) = txCallback();
+    }
+    else
+    {
+        SPIx(TXB) = 0x00;
+    }
+    
+    //Interrupt flag is cleared automatically by writing
+}
+
+void __interrupt(irq(SPIx(RX)), base(INTERRUPT_BASE)) SPIx(_readRX_ISR)(void)
+{
+    volatile uint8_t rx = SPIx(RXB);
+    
+    if (rxCallback != 0)
+    {
+        rxCallback(rx);
+    }
+    
+    //Interrupt flag is cleared automatically by reading
+}
+
+void __interrupt(irq(SPIx()), base(INTERRUPT_BASE)) SPIx(_status_ISR)(void)
+{
+    if (SPIx(INTFbits).SOSIF)
+    {
+        //SS was Asserted
+        if (startCallback != 0)
+        {
+            startCallback();
+        }
+        
+        SPIx(INTFbits).SOSIF = 0;
+    }
+    else if (SPIx(INTFbits).EOSIF)
+    {
+        //SS was De-asserted
+        if (stopCallback != 0)
+        {
+            stopCallback();
+        }
+        
+        SPIx(INTFbits).EOSIF = 0;
+    }
+}
+
+#endif
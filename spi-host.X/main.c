@@ -84,6 +84,9 @@
 
 #include <xc.h>
 #include "spi1_host.h"
+#include "spi1_host_dma.h"
+#include "interrupts.h"
+#include "softspi.h"
 
 #include <stdint.h>
 #include <stdbool.h>
@@ -153,9 +156,173 @@ bool SPI_TEST_Receive(void)
     return true;
 }
 
+bool SPI_TEST_DMA(void)
+{
+    uint8_t testPattern[64];
+    uint8_t results[64];
+    
+    for (uint8_t i = 0; i < sizeof(testPattern); i++)
+    {
+        testPattern[i] = i ^ 0x5A;
+        results[i] = 0x00;
+    }
+    
+    //Start the transfer, then wait for it
+    if (!SPI1_DMA_startExchange(&testPattern[0], &results[0], sizeof(testPattern)))
+    {
+        return false;
+    }
+    
+    if (SPI1_DMA_complete() != SPI1_OK)
+    {
+        return false;
+    }
+    
+    //Validate Data
+    for (uint8_t i = 0; i < sizeof(testPattern); i++)
+    {
+        if (results[i] != testPattern[i])
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool SPI_TEST_Words(void)
+{
+    uint16_t testPattern[] = {0x1234, 0xA55A, 0x00FF};
+    uint16_t results[3];
+    uint8_t bytes[2];
+    
+    //Test 16-bit words, MSB first
+    SPI1_exchangeWords16(&testPattern[0], &results[0], 3, SPI1_MSB_FIRST);
+    
+    for (uint8_t i = 0; i < 3; i++)
+    {
+        if (results[i] != testPattern[i])
+        {
+            return false;
+        }
+    }
+    
+    //Test 4-bit frames
+    bytes[0] = 0x0A;
+    bytes[1] = 0x05;
+    SPI1_exchangeBits(&bytes[0], &bytes[0], 2, 4);
+    
+    if ((bytes[0] != 0x0A) || (bytes[1] != 0x05))
+    {
+        return false;
+    }
+    
+    return true;
+}
+
+bool SPI_TEST_Frame(void)
+{
+    uint8_t testPattern[] = {0x31, 0x32, 0x33, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39};
+    uint8_t results[9];
+    
+    //In loopback, the received CRC is our own, so the check must pass
+    if (SPI1_exchangeFrame(&testPattern[0], &results[0], sizeof(testPattern)) != SPI1_OK)
+    {
+        return false;
+    }
+    
+    //Validate Data
+    for (uint8_t i = 0; i < sizeof(testPattern); i++)
+    {
+        if (results[i] != testPattern[i])
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+bool SPI_TEST_Soft(void)
+{
+    uint8_t testPattern[] = {0xA5, 0x3C, 0x01, 0x80, 0xFF, 0x00};
+    uint8_t results[6];
+    
+    //Connect RD1 (SDO) to RD2 (SDI)
+    SOFTSPI_exchangeBytes(&testPattern[0], &results[0], sizeof(testPattern));
+    
+    for (uint8_t i = 0; i < sizeof(testPattern); i++)
+    {
+        if (results[i] != testPattern[i])
+        {
+            return false;
+        }
+    }
+    
+    //Connect RD4 (SDO1) to RD5 (SDI1) as well
+    //Each lane receives its own (interleaved) data
+    SOFTSPI_exchangeLockstep(&testPattern[0], &results[0], sizeof(testPattern) / SOFTSPI_LANES);
+    
+    for (uint8_t i = 0; i < sizeof(testPattern); i++)
+    {
+        if (results[i] != testPattern[i])
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
+static volatile bool asyncDone = false;
+
+void SPI_TEST_myDoneFunction(void)
+{
+    asyncDone = true;
+}
+
+bool SPI_TEST_Async(void)
+{
+    uint8_t testPattern[] = {0x12, 0x34, 0x56, 0x78, 0x9A, 0xBC, 0xDE, 0xF0};
+    uint8_t results[8];
+    uint16_t workload = 0;
+    
+    asyncDone = false;
+    
+    if (!SPI1_exchangeBytesAsync(&testPattern[0], &results[0], sizeof(testPattern), &SPI_TEST_myDoneFunction))
+    {
+        return false;
+    }
+    
+    //Main loop keeps running while the transfer is in progress
+    while (SPI1_isBusy())
+    {
+        workload++;
+    }
+    
+    if ((!asyncDone) || (workload == 0))
+    {
+        return false;
+    }
+    
+    //Validate Data
+    for (uint8_t i = 0; i < sizeof(testPattern); i++)
+    {
+        if (results[i] != testPattern[i])
+        {
+            return false;
+        }
+    }
+    
+    return true;
+}
+
 #define TEST_ENABLE_TX
 //#define TEST_ENABLE_RX
 
+//Software SPI test - needs the RD1 - RD2 and RD4 - RD5 loopbacks
+//#define TEST_ENABLE_SOFT
+
 void main(void) {
     
     //Init SPI I/O
@@ -164,6 +331,13 @@ void main(void) {
     //Init the SPI peripheral in Host mode
     SPI1_initHost();
     
+    //Init the DMA channels for bulk transfers
+    SPI1_DMA_init();
+    
+    //Init Interrupts (async transfers)
+    Interrupts_init();
+    Interrupts_enable();
+    
     //Configure LED0 on Board
     TRISC7 = 0;
     LATC7 = 1;
@@ -190,6 +364,55 @@ void main(void) {
         LATC7 = 0;
     }
     
+    //Test DMA Functions
+    ok = SPI_TEST_DMA();
+    
+    if (!ok)
+    {
+        //If test failed, set LED
+        LATC7 = 0;
+    }
+    
+    //Test Word Functions
+    ok = SPI_TEST_Words();
+    
+    if (!ok)
+    {
+        //If test failed, set LED
+        LATC7 = 0;
+    }
+    
+    //Test CRC Frames
+    ok = SPI_TEST_Frame();
+    
+    if (!ok)
+    {
+        //If test failed, set LED
+        LATC7 = 0;
+    }
+    
+    //Test Async Functions
+    ok = SPI_TEST_Async();
+    
+    if (!ok)
+    {
+        //If test failed, set LED
+        LATC7 = 0;
+    }
+    
+#ifdef TEST_ENABLE_SOFT
+    //Test Software SPI
+    SOFTSPI_initPins();
+    SOFTSPI_initHost();
+    ok = SPI_TEST_Soft();
+    
+    if (!ok)
+    {
+        //If test failed, set LED
+        LATC7 = 0;
+    }
+#endif
+    
 #elif defined TEST_ENABLE_RX
     
     //Test Read Functions
@@ -0,0 +1,273 @@
+#include "softspi.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Pin names are pasted from the port and bit (e.g. LAT, D, 0 -> LATD0)
+#define SOFTSPI_PASTE(a, b, c) SOFTSPI_PASTE_(a, b, c)
+#define SOFTSPI_PASTE_(a, b, c) a ## b ## c
+
+#define SOFTSPI_LAT(bit) SOFTSPI_PASTE(LAT, SOFTSPI_PORT, bit)
+#define SOFTSPI_READ(bit) SOFTSPI_PASTE(R, SOFTSPI_PORT, bit)
+#define SOFTSPI_TRIS(bit) SOFTSPI_PASTE(TRIS, SOFTSPI_PORT, bit)
+#define SOFTSPI_ANSEL(bit) SOFTSPI_PASTE(ANSEL, SOFTSPI_PORT, bit)
+
+//Whole port registers, used by the lockstep buses
+#define SOFTSPI_LAT_PORT SOFTSPI_PASTE(LAT, SOFTSPI_PORT, )
+#define SOFTSPI_PORT_PORT SOFTSPI_PASTE(PORT, SOFTSPI_PORT, )
+
+//SCK edges. CPOL sets the idle level
+#define SOFTSPI_CPOL (SOFTSPI_MODE >> 1)
+#define SOFTSPI_LEAD() SOFTSPI_LAT(SOFTSPI_SCK_BIT) = !SOFTSPI_CPOL
+#define SOFTSPI_TRAIL() SOFTSPI_LAT(SOFTSPI_SCK_BIT) = SOFTSPI_CPOL
+
+//Data out / in for bit MASK of the current byte
+#define SOFTSPI_OUT(mask) \
+    if (tx & (mask)) { SOFTSPI_LAT(SOFTSPI_SDO_BIT) = 1; } else { SOFTSPI_LAT(SOFTSPI_SDO_BIT) = 0; }
+#define SOFTSPI_IN(mask) \
+    if (SOFTSPI_READ(SOFTSPI_SDI_BIT)) { rx |= (mask); }
+#define SOFTSPI_NONE(mask)
+
+//1 bit. With CPHA = 0 data is set up before the leading edge and sampled on it
+//With CPHA = 1 data changes on the leading edge and is sampled on the trailing edge
+#if (SOFTSPI_MODE & 0x01) == 0
+#define SOFTSPI_CLOCK(out, in, mask) \
+    out(mask) SOFTSPI_DELAY(); SOFTSPI_LEAD(); in(mask) SOFTSPI_DELAY(); SOFTSPI_TRAIL();
+#else
+#define SOFTSPI_CLOCK(out, in, mask) \
+    SOFTSPI_LEAD(); out(mask) SOFTSPI_DELAY(); SOFTSPI_TRAIL(); in(mask) SOFTSPI_DELAY();
+#endif
+
+//1 byte, unrolled
+#if SOFTSPI_LSB_FIRST
+#define SOFTSPI_BYTE(out, in) \
+    SOFTSPI_CLOCK(out, in, 0x01) SOFTSPI_CLOCK(out, in, 0x02) \
+    SOFTSPI_CLOCK(out, in, 0x04) SOFTSPI_CLOCK(out, in, 0x08) \
+    SOFTSPI_CLOCK(out, in, 0x10) SOFTSPI_CLOCK(out, in, 0x20) \
+    SOFTSPI_CLOCK(out, in, 0x40) SOFTSPI_CLOCK(out, in, 0x80)
+#else
+#define SOFTSPI_BYTE(out, in) \
+    SOFTSPI_CLOCK(out, in, 0x80) SOFTSPI_CLOCK(out, in, 0x40) \
+    SOFTSPI_CLOCK(out, in, 0x20) SOFTSPI_CLOCK(out, in, 0x10) \
+    SOFTSPI_CLOCK(out, in, 0x08) SOFTSPI_CLOCK(out, in, 0x04) \
+    SOFTSPI_CLOCK(out, in, 0x02) SOFTSPI_CLOCK(out, in, 0x01)
+#endif
+
+#ifdef SOFTSPI_SS_ENABLE
+#define SOFTSPI_SELECT() SOFTSPI_LAT(SOFTSPI_SS_BIT) = SOFTSPI_SS_ACTIVE_HIGH
+#define SOFTSPI_DESELECT() SOFTSPI_LAT(SOFTSPI_SS_BIT) = !SOFTSPI_SS_ACTIVE_HIGH
+#else
+#define SOFTSPI_SELECT()
+#define SOFTSPI_DESELECT()
+#endif
+
+//Lockstep lanes. Missing lanes have no pins
+#define SOFTSPI_LANE0_SDO_MASK (1 << SOFTSPI_SDO_BIT)
+#define SOFTSPI_LANE0_SDI_MASK (1 << SOFTSPI_SDI_BIT)
+
+#if SOFTSPI_LANES > 1
+#define SOFTSPI_LANE1_SDO_MASK (1 << SOFTSPI_LANE1_SDO_BIT)
+#define SOFTSPI_LANE1_SDI_MASK (1 << SOFTSPI_LANE1_SDI_BIT)
+#else
+#define SOFTSPI_LANE1_SDO_MASK 0
+#define SOFTSPI_LANE1_SDI_MASK 0
+#endif
+
+#if SOFTSPI_LANES > 2
+#define SOFTSPI_LANE2_SDO_MASK (1 << SOFTSPI_LANE2_SDO_BIT)
+#define SOFTSPI_LANE2_SDI_MASK (1 << SOFTSPI_LANE2_SDI_BIT)
+#else
+#define SOFTSPI_LANE2_SDO_MASK 0
+#define SOFTSPI_LANE2_SDI_MASK 0
+#endif
+
+#define SOFTSPI_SDO_MASK (SOFTSPI_LANE0_SDO_MASK | SOFTSPI_LANE1_SDO_MASK | SOFTSPI_LANE2_SDO_MASK)
+
+_Static_assert(((SOFTSPI_LANE1_SDO_MASK | SOFTSPI_LANE1_SDI_MASK | SOFTSPI_LANE2_SDO_MASK | SOFTSPI_LANE2_SDI_MASK) &
+    ((1 << SOFTSPI_SCK_BIT) | (1 << SOFTSPI_SS_BIT) | SOFTSPI_LANE0_SDO_MASK | SOFTSPI_LANE0_SDI_MASK)) == 0,
+    "SOFTSPI lane pins must not be used by the first bus");
+_Static_assert((SOFTSPI_LANE1_SDO_MASK & SOFTSPI_LANE1_SDI_MASK) == 0, "SOFTSPI lane 1 pins must be different");
+_Static_assert(((SOFTSPI_LANE1_SDO_MASK | SOFTSPI_LANE1_SDI_MASK) & (SOFTSPI_LANE2_SDO_MASK | SOFTSPI_LANE2_SDI_MASK)) == 0,
+    "SOFTSPI lane 2 pins must not be used by lane 1");
+
+//Every lane's data bit is written with 1 port write, then every SDI is read with 1 port read
+#define SOFTSPI_LOCK_OUT(mask) \
+    out = SOFTSPI_LAT_PORT & ~SOFTSPI_SDO_MASK; \
+    if (tx0 & (mask)) { out |= SOFTSPI_LANE0_SDO_MASK; } \
+    if (tx1 & (mask)) { out |= SOFTSPI_LANE1_SDO_MASK; } \
+    if (tx2 & (mask)) { out |= SOFTSPI_LANE2_SDO_MASK; } \
+    SOFTSPI_LAT_PORT = out;
+#define SOFTSPI_LOCK_IN(mask) \
+    in = SOFTSPI_PORT_PORT; \
+    if (in & SOFTSPI_LANE0_SDI_MASK) { rx0 |= (mask); } \
+    if (in & SOFTSPI_LANE1_SDI_MASK) { rx1 |= (mask); } \
+    if (in & SOFTSPI_LANE2_SDI_MASK) { rx2 |= (mask); }
+
+//Shifts 1 byte out and in
+static uint8_t SOFTSPI_shiftByte(uint8_t tx)
+{
+    uint8_t rx = 0;
+    SOFTSPI_BYTE(SOFTSPI_OUT, SOFTSPI_IN)
+    return rx;
+}
+
+//Shifts 1 byte out
+static void SOFTSPI_shiftOut(uint8_t tx)
+{
+    SOFTSPI_BYTE(SOFTSPI_OUT, SOFTSPI_NONE)
+}
+
+//Shifts 1 byte in. SDO must be low
+static uint8_t SOFTSPI_shiftIn(void)
+{
+    uint8_t rx = 0;
+    SOFTSPI_BYTE(SOFTSPI_NONE, SOFTSPI_IN)
+    return rx;
+}
+
+//Sets the idle levels of SCK, SDO and SS
+void SOFTSPI_initHost(void)
+{
+    SOFTSPI_TRAIL();
+    SOFTSPI_LAT_PORT &= ~SOFTSPI_SDO_MASK;
+    
+#ifdef SOFTSPI_SS_ENABLE
+    SOFTSPI_DESELECT();
+#endif
+}
+
+//Initializes the I/O for the Software SPI Host
+void SOFTSPI_initPins(void)
+{
+    //RD0 - SCK
+    //RD1 - SDO
+    //RD2 - SDI
+    //RD3 - SS
+    
+    //SCK Config
+    SOFTSPI_TRIS(SOFTSPI_SCK_BIT) = 0;
+    
+    //SDO Config
+    SOFTSPI_TRIS(SOFTSPI_SDO_BIT) = 0;
+    
+    //SDI Config
+    SOFTSPI_TRIS(SOFTSPI_SDI_BIT) = 1;
+    SOFTSPI_ANSEL(SOFTSPI_SDI_BIT) = 0;
+    
+#ifdef SOFTSPI_SS_ENABLE
+    //SS Config
+    SOFTSPI_TRIS(SOFTSPI_SS_BIT) = 0;
+#endif
+    
+#if SOFTSPI_LANES > 1
+    //Lane 1 Config
+    SOFTSPI_TRIS(SOFTSPI_LANE1_SDO_BIT) = 0;
+    SOFTSPI_TRIS(SOFTSPI_LANE1_SDI_BIT) = 1;
+    SOFTSPI_ANSEL(SOFTSPI_LANE1_SDI_BIT) = 0;
+#endif
+    
+#if SOFTSPI_LANES > 2
+    //Lane 2 Config
+    SOFTSPI_TRIS(SOFTSPI_LANE2_SDO_BIT) = 0;
+    SOFTSPI_TRIS(SOFTSPI_LANE2_SDI_BIT) = 1;
+    SOFTSPI_ANSEL(SOFTSPI_LANE2_SDI_BIT) = 0;
+#endif
+}
+
+//Sends and receives a single byte
+uint8_t SOFTSPI_exchangeByte(uint8_t data)
+{
+    uint8_t rx;
+    SOFTSPI_exchangeBytes(&data, &rx, 1);
+    return rx;
+}
+
+//Sends a single byte. Received data is discarded
+void SOFTSPI_sendByte(uint8_t data)
+{
+    SOFTSPI_sendBytes(&data, 1);
+}
+
+//Receives a single byte. Transmitted data is 0x00
+uint8_t SOFTSPI_recieveByte(void)
+{
+    uint8_t rx;
+    SOFTSPI_receiveBytes(&rx, 1);
+    return rx;
+}
+
+//Send and receives LEN bytes
+SOFTSPI_result_t SOFTSPI_exchangeBytes(uint8_t* txData, uint8_t* rxData, uint16_t len)
+{
+    SOFTSPI_SELECT();
+    
+    for (uint16_t i = 0; i < len; i++)
+    {
+        rxData[i] = SOFTSPI_shiftByte(txData[i]);
+    }
+    
+    SOFTSPI_DESELECT();
+    return SOFTSPI_OK;
+}
+
+//Sends LEN bytes. Received data is discarded
+SOFTSPI_result_t SOFTSPI_sendBytes(uint8_t* txData, uint16_t len)
+{
+    SOFTSPI_SELECT();
+    
+    for (uint16_t i = 0; i < len; i++)
+    {
+        SOFTSPI_shiftOut(txData[i]);
+    }
+    
+    SOFTSPI_DESELECT();
+    return SOFTSPI_OK;
+}
+
+//Receives LEN bytes. Transmitted data is 0x00
+SOFTSPI_result_t SOFTSPI_receiveBytes(uint8_t* rxData, uint16_t len)
+{
+    SOFTSPI_LAT(SOFTSPI_SDO_BIT) = 0;
+    SOFTSPI_SELECT();
+    
+    for (uint16_t i = 0; i < len; i++)
+    {
+        rxData[i] = SOFTSPI_shiftIn();
+    }
+    
+    SOFTSPI_DESELECT();
+    return SOFTSPI_OK;
+}
+
+//Sends and receives LEN bytes on each lockstep bus at once
+SOFTSPI_result_t SOFTSPI_exchangeLockstep(uint8_t* txData, uint8_t* rxData, uint16_t len)
+{
+    uint8_t out, in;
+    
+    SOFTSPI_SELECT();
+    
+    for (uint16_t i = 0; i < len; i++)
+    {
+        uint8_t tx0 = txData[0];
+        uint8_t tx1 = (SOFTSPI_LANES > 1) ? txData[1] : 0;
+        uint8_t tx2 = (SOFTSPI_LANES > 2) ? txData[2] : 0;
+        uint8_t rx0 = 0, rx1 = 0, rx2 = 0;
+        
+        SOFTSPI_BYTE(SOFTSPI_LOCK_OUT, SOFTSPI_LOCK_IN)
+        
+        rxData[0] = rx0;
+#if SOFTSPI_LANES > 1
+        rxData[1] = rx1;
+#endif
+#if SOFTSPI_LANES > 2
+        rxData[2] = rx2;
+#endif
+        
+        txData += SOFTSPI_LANES;
+        rxData += SOFTSPI_LANES;
+    }
+    
+    SOFTSPI_DESELECT();
+    return SOFTSPI_OK;
+}
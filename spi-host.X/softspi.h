@@ -0,0 +1,112 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SOFTSPI_H
+#define	SOFTSPI_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//Software (bit-banged) SPI Host
+//The mode and pins are fixed at compile time, so each bit is a few
+//single-cycle bit set / clear / test instructions
+    
+//SPI Mode (0 to 3)
+#define SOFTSPI_MODE 0
+    
+//If set, bytes are sent LSB first
+#define SOFTSPI_LSB_FIRST 0
+    
+//If defined, SS is asserted for each call (like HW_SS_ENABLE)
+#define SOFTSPI_SS_ENABLE
+#define SOFTSPI_SS_ACTIVE_HIGH 0
+    
+//All pins are on one port, so the lockstep buses can share writes
+//RD0 - SCK, RD1 - SDO, RD2 - SDI, RD3 - SS
+#define SOFTSPI_PORT D
+#define SOFTSPI_SCK_BIT 0
+#define SOFTSPI_SDO_BIT 1
+#define SOFTSPI_SDI_BIT 2
+#define SOFTSPI_SS_BIT 3
+    
+//Lockstep buses share SCK and SS. Lane 0 uses SOFTSPI_SDO_BIT / SOFTSPI_SDI_BIT
+//RD4 - SDO1, RD5 - SDI1 (RD6 / RD7 for a third lane)
+#define SOFTSPI_LANES 2
+#define SOFTSPI_LANE1_SDO_BIT 4
+#define SOFTSPI_LANE1_SDI_BIT 5
+#define SOFTSPI_LANE2_SDO_BIT 6
+#define SOFTSPI_LANE2_SDI_BIT 7
+    
+//Run on each half of a bit. Add NOPs for devices slower than the default SCK
+#define SOFTSPI_DELAY()
+    
+    //Result of a blocking transfer (bit-banged transfers can't time out)
+    typedef enum {
+        SOFTSPI_OK = 0
+    } SOFTSPI_result_t;
+    
+    //Sets the idle levels of SCK, SDO and SS
+    //I/O must be initialized separately
+    void SOFTSPI_initHost(void);
+    
+    //Initializes the I/O for the Software SPI Host, including the lockstep lanes
+    void SOFTSPI_initPins(void);
+    
+    //Sends and receives a single byte
+    uint8_t SOFTSPI_exchangeByte(uint8_t data);
+    
+    //Sends a single byte. Received data is discarded
+    void SOFTSPI_sendByte(uint8_t data);
+    
+    //Receives a single byte. Transmitted data is 0x00
+    uint8_t SOFTSPI_recieveByte(void);
+    
+    //Send and receives LEN bytes
+    SOFTSPI_result_t SOFTSPI_exchangeBytes(uint8_t* txData, uint8_t* rxData, uint16_t len);
+    
+    //Sends LEN bytes. Received data is discarded
+    SOFTSPI_result_t SOFTSPI_sendBytes(uint8_t* txData, uint16_t len);
+    
+    //Receives LEN bytes. Transmitted data is 0x00
+    SOFTSPI_result_t SOFTSPI_receiveBytes(uint8_t* rxData, uint16_t len);
+    
+    //Sends and receives LEN bytes on each of the SOFTSPI_LANES buses at once
+    //Data is interleaved - byte i of lane n is at [(i * SOFTSPI_LANES) + n]
+    //Nothing else may write the port while this runs
+    SOFTSPI_result_t SOFTSPI_exchangeLockstep(uint8_t* txData, uint8_t* rxData, uint16_t len);
+    
+_Static_assert((SOFTSPI_MODE >= 0) && (SOFTSPI_MODE <= 3), "SOFTSPI_MODE must be 0 to 3");
+_Static_assert((SOFTSPI_LANES >= 1) && (SOFTSPI_LANES <= 3), "SOFTSPI_LANES must be 1 to 3");
+_Static_assert((SOFTSPI_SCK_BIT <= 7) && (SOFTSPI_SDO_BIT <= 7) && (SOFTSPI_SDI_BIT <= 7) &&
+    (SOFTSPI_SS_BIT <= 7), "SOFTSPI pins must be bits 0 to 7");
+_Static_assert(((1 << SOFTSPI_SCK_BIT) | (1 << SOFTSPI_SDO_BIT) | (1 << SOFTSPI_SDI_BIT) |
+    (1 << SOFTSPI_SS_BIT)) == ((1 << SOFTSPI_SCK_BIT) + (1 << SOFTSPI_SDO_BIT) +
+    (1 << SOFTSPI_SDI_BIT) + (1 << SOFTSPI_SS_BIT)), "SOFTSPI pins must all be different");
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SOFTSPI_H */
+
@@ -0,0 +1,309 @@
+#include "spi1_benchmark.h"
+#include "spi1_host.h"
+#include "spi1_host_dma.h"
+#include "spi_config.h"
+
+#ifdef SPI1_BENCH_SOFTSPI
+#include "softspi.h"
+#endif
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Functions measured
+typedef enum {
+    BENCH_EXCHANGE = 0, BENCH_SEND, BENCH_RECEIVE, BENCH_DMA_EXCHANGE,
+    BENCH_READ_COPY, BENCH_READ_COMMAND, BENCH_SEND_COPY, BENCH_SEND_SEGMENTS,
+#ifdef SPI1_BENCH_SOFTSPI
+    BENCH_SOFT_EXCHANGE, BENCH_SOFT_SEND, BENCH_SOFT_LOCKSTEP,
+#endif
+    BENCH_COUNT
+} bench_api_t;
+
+//First software SPI function (none if BENCH_COUNT)
+#ifdef SPI1_BENCH_SOFTSPI
+#define BENCH_SOFT_FIRST BENCH_SOFT_EXCHANGE
+#else
+#define BENCH_SOFT_FIRST BENCH_COUNT
+#endif
+
+static const char* const apiNames[BENCH_COUNT] = {
+    "exchangeBytes", "sendBytes", "receiveBytes", "DMA_exchange",
+    "readCopy", "executeCommand", "sendCopy", "sendSegments",
+#ifdef SPI1_BENCH_SOFTSPI
+    "softExchange", "softSend", "softLockstep"
+#endif
+};
+
+//Flash read used for the command benchmarks - opcode, 3 address bytes, 1 dummy byte
+#define BENCH_READ_OPCODE 0x0B
+#define BENCH_READ_HEADER 5
+
+//Packet used for the scatter-gather benchmarks - header, payload, trailer
+static uint8_t benchHeader[4] = {0x02, 0x10, 0x00, 0x00};
+static uint8_t benchTrailer[2] = {0x00, 0x03};
+
+//Timer1 counts (32 / FOSC) per Timer0 tick. Timer0 is the timeout timebase,
+//and counts the Timer1 overflows of a long run
+#define BENCH_TMR1_PER_TMR0 ((4UL << SPI_TIMER0_CKPS) / 32)
+_Static_assert(((4UL << SPI_TIMER0_CKPS) % 32) == 0, "Timer0 tick must be a whole number of Timer1 counts");
+
+//SPI1BAUD values measured (1, 4, 8, 16 and 32 MHz from HFINTOSC)
+static const uint8_t baudSettings[] = {31, 7, 3, 1, 0};
+
+//Data buffer - exchanges are done in place
+static uint8_t benchBuffer[SPI1_BENCH_MAX_LEN];
+
+//Writes a string
+static void SPI1_benchPrint(void (*putChar)(char), const char* text)
+{
+    while (*text != '\0')
+    {
+        putChar(*text);
+        text++;
+    }
+}
+
+//Writes an unsigned number in decimal, followed by a separator
+static void SPI1_benchPrintNumber(void (*putChar)(char), uint32_t value, char separator)
+{
+    char digits[10];
+    uint8_t count = 0;
+    
+    do
+    {
+        digits[count] = (char) ('0' + (value % 10));
+        value /= 10;
+        count++;
+    } while (value != 0);
+    
+    while (count != 0)
+    {
+        count--;
+        putChar(digits[count]);
+    }
+    
+    putChar(separator);
+}
+
+//Flash read in a staging buffer, then copied out (the first half of benchBuffer
+//is the staging buffer, the second half is the destination)
+static void SPI1_benchReadCopy(uint16_t len)
+{
+    uint8_t* staging = &benchBuffer[0];
+    uint8_t* output = &benchBuffer[SPI1_BENCH_MAX_LEN / 2];
+    
+    staging[0] = BENCH_READ_OPCODE;
+    staging[1] = 0x00;
+    staging[2] = 0x00;
+    staging[3] = 0x00;
+    staging[4] = 0x00;
+    
+    SPI1_exchangeBytes(staging, staging, len + BENCH_READ_HEADER);
+    
+    for (uint16_t i = 0; i < len; i++)
+    {
+        output[i] = staging[i + BENCH_READ_HEADER];
+    }
+}
+
+//Packet copied into a staging buffer, then sent (the payload is in the
+//second half of benchBuffer, the first half is the staging buffer)
+static void SPI1_benchSendCopy(uint16_t len)
+{
+    uint8_t* staging = &benchBuffer[0];
+    uint8_t* payload = &benchBuffer[SPI1_BENCH_MAX_LEN / 2];
+    uint16_t fill = 0;
+    
+    for (uint8_t i = 0; i < sizeof(benchHeader); i++)
+    {
+        staging[fill++] = benchHeader[i];
+    }
+    
+    for (uint16_t i = 0; i < len; i++)
+    {
+        staging[fill++] = payload[i];
+    }
+    
+    for (uint8_t i = 0; i < sizeof(benchTrailer); i++)
+    {
+        staging[fill++] = benchTrailer[i];
+    }
+    
+    SPI1_sendBytes(staging, fill);
+}
+
+//Runs one function REPS times and returns the time in Timer1 counts
+//Runs longer than Timer1 (2.1 M cycles) are measured up to the Timer0 period
+static uint32_t SPI1_benchMeasure(bench_api_t api, uint16_t len, uint16_t reps)
+{
+    //Same flash read as SPI1_benchReadCopy, straight into the destination
+    SPI1_command_t benchRead = {BENCH_READ_OPCODE, 3, 0x000000, 1, 0, &benchBuffer[SPI1_BENCH_MAX_LEN / 2], len};
+    
+    //Same packet as SPI1_benchSendCopy, sent from where it is
+    SPI1_segment_t benchPacket[3] = {
+        {&benchHeader[0], 0, sizeof(benchHeader)},
+        {&benchBuffer[SPI1_BENCH_MAX_LEN / 2], 0, len},
+        {&benchTrailer[0], 0, sizeof(benchTrailer)}
+    };
+    
+    uint16_t start = SPI1_readTimer();
+    TMR1 = 0;
+    T1CONbits.ON = 1;
+    
+    for (uint16_t i = 0; i < reps; i++)
+    {
+        switch (api)
+        {
+            case BENCH_EXCHANGE:
+                SPI1_exchangeBytes(&benchBuffer[0], &benchBuffer[0], len);
+                break;
+            case BENCH_SEND:
+                SPI1_sendBytes(&benchBuffer[0], len);
+                break;
+            case BENCH_RECEIVE:
+                SPI1_receiveBytes(&benchBuffer[0], len);
+                break;
+            case BENCH_READ_COPY:
+                SPI1_benchReadCopy(len);
+                break;
+            case BENCH_READ_COMMAND:
+                SPI1_executeCommand(&benchRead);
+                break;
+            case BENCH_SEND_COPY:
+                SPI1_benchSendCopy(len);
+                break;
+            case BENCH_SEND_SEGMENTS:
+                SPI1_exchangeSegments(&benchPacket[0], 3);
+                break;
+#ifdef SPI1_BENCH_SOFTSPI
+            case BENCH_SOFT_EXCHANGE:
+                SOFTSPI_exchangeBytes(&benchBuffer[0], &benchBuffer[0], len);
+                break;
+            case BENCH_SOFT_SEND:
+                SOFTSPI_sendBytes(&benchBuffer[0], len);
+                break;
+            case BENCH_SOFT_LOCKSTEP:
+                //LEN bytes in total, split across the lanes
+                SOFTSPI_exchangeLockstep(&benchBuffer[0], &benchBuffer[0], len / SOFTSPI_LANES);
+                break;
+#endif
+            case BENCH_DMA_EXCHANGE:
+                SPI1_DMA_startExchange(&benchBuffer[0], &benchBuffer[0], len);
+                SPI1_DMA_complete();
+                break;
+            default:
+                break;
+        }
+    }
+    
+    T1CONbits.ON = 0;
+    uint16_t counts = TMR1;
+    
+    //Timer0 is coarse, but close enough to tell how many times Timer1 wrapped
+    uint32_t coarse = (uint32_t) (uint16_t) (SPI1_readTimer() - start) * BENCH_TMR1_PER_TMR0;
+    uint32_t wraps = (coarse + 32768 - counts) >> 16;
+    
+    return (wraps << 16) | counts;
+}
+
+//Measures each transfer function across lengths and baud settings
+void SPI1_runBenchmark(void (*putChar)(char))
+{
+    uint8_t oldBaud = SPI1BAUD;
+    
+    //Timer1 - FOSC / 4, 1:8, 16-bit reads (1 count = 32 / FOSC, 32.7 ms to overflow)
+    T1CON = 0x00;
+    T1CLK = 0b00001;
+    T1CONbits.CKPS = 0b11;
+    T1CONbits.RD16 = 1;
+    
+    for (uint16_t i = 0; i < SPI1_BENCH_MAX_LEN; i++)
+    {
+        benchBuffer[i] = (uint8_t) i;
+    }
+    
+    SPI1_benchPrint(putChar, "api,baud,sck_hz,len,cycles_per_call,bytes_per_sec,bus_util_pct,gap_cycles_per_byte\r\n");
+    
+    for (uint8_t b = 0; b < sizeof(baudSettings); b++)
+    {
+        //Baud can only be changed while the module is disabled
+        SPI1CON0bits.EN = 0;
+        SPI1BAUD = baudSettings[b];
+        SPI1CON0bits.EN = 1;
+        
+        //1 byte on the bus, in instruction cycles (FOSC / 4)
+        uint32_t busCyclesPerByte = 4 * ((uint32_t) baudSettings[b] + 1);
+        uint32_t sckHz = SPI1_BENCH_FOSC_HZ / (2 * ((uint32_t) baudSettings[b] + 1));
+        
+        for (uint8_t api = 0; api < BENCH_COUNT; api++)
+        {
+            for (uint16_t len = 1; len <= SPI1_BENCH_MAX_LEN; len <<= 1)
+            {
+                if ((api >= BENCH_READ_COPY) && (api <= BENCH_SEND_SEGMENTS) && ((len + BENCH_READ_HEADER) > (SPI1_BENCH_MAX_LEN / 2)))
+                {
+                    //Staging buffer and payload / destination must both fit
+                    break;
+                }
+                
+#ifdef SPI1_BENCH_SOFTSPI
+                if ((api >= BENCH_SOFT_EXCHANGE) && ((b != 0) || ((api == BENCH_SOFT_LOCKSTEP) && (len < SOFTSPI_LANES))))
+                {
+                    //Software SPI does not use SPI1BAUD, so it is only measured once
+                    break;
+                }
+#endif
+                
+                if ((api == BENCH_DMA_EXCHANGE) && (len > SPI1_DMA_MAX_LEN))
+                {
+                    //Longer than the DMA counters
+                    break;
+                }
+                
+                uint16_t reps = (len < SPI1_BENCH_MIN_BYTES) ? (SPI1_BENCH_MIN_BYTES / len) : 1;
+                uint32_t bytes = (uint32_t) len * reps;
+                
+                //Convert to instruction cycles
+                uint32_t cycles = SPI1_benchMeasure((bench_api_t) api, len, reps) * 8;
+                uint32_t busCycles = bytes * busCyclesPerByte;
+                
+                if (cycles == 0)
+                {
+                    cycles = 1;
+                }
+                
+                //Bytes / sec = (FOSC / 4) / (cycles / byte), in 1/256 cycle steps
+                uint32_t cyclesPerByte256 = (cycles * 256) / bytes;
+                uint32_t rate = (cyclesPerByte256 != 0) ? (((SPI1_BENCH_FOSC_HZ / 4) * 256) / cyclesPerByte256) : 0;
+                uint32_t gap = (cycles > busCycles) ? ((cycles - busCycles) / bytes) : 0;
+                
+                uint32_t rowSckHz = sckHz;
+                
+                if (api >= BENCH_SOFT_FIRST)
+                {
+                    //The bus is always clocking - report the achieved bit rate as SCK
+                    rowSckHz = rate * 8;
+                    busCycles = cycles;
+                    gap = 0;
+                }
+                
+                SPI1_benchPrint(putChar, apiNames[api]);
+                putChar(',');
+                SPI1_benchPrintNumber(putChar, (api >= BENCH_SOFT_FIRST) ? 0 : baudSettings[b], ',');
+                SPI1_benchPrintNumber(putChar, rowSckHz, ',');
+                SPI1_benchPrintNumber(putChar, len, ',');
+                SPI1_benchPrintNumber(putChar, cycles / reps, ',');
+                SPI1_benchPrintNumber(putChar, rate, ',');
+                SPI1_benchPrintNumber(putChar, (busCycles * 100) / cycles, ',');
+                SPI1_benchPrintNumber(putChar, gap, '\r');
+                putChar('\n');
+            }
+        }
+    }
+    
+    //Restore the baud rate
+    SPI1CON0bits.EN = 0;
+    SPI1BAUD = oldBaud;
+    SPI1CON0bits.EN = 1;
+}
@@ -0,0 +1,56 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_BENCHMARK_H
+#define	SPI1_BENCHMARK_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+    
+//System clock, used to convert Timer1 counts into rates
+#define SPI1_BENCH_FOSC_HZ 64000000UL
+    
+//Longest transfer measured (limited by RAM, can be set by the build)
+#ifndef SPI1_BENCH_MAX_LEN
+#define SPI1_BENCH_MAX_LEN 2048
+#endif
+    
+//Transfers shorter than this are repeated to improve resolution
+#define SPI1_BENCH_MIN_BYTES 256
+    
+//If defined, the software SPI host (softspi.c) is measured as well
+//#define SPI1_BENCH_SOFTSPI
+    
+    //Measures each transfer function across lengths 1 to SPI1_BENCH_MAX_LEN
+    //and several baud settings. Results are written as CSV through putChar
+    //Uses Timer1. SPI1 must be initialized as a host, and SPI1_DMA_init called
+    //No async transfer may be running
+    //With SPI1_BENCH_SOFTSPI, also call SOFTSPI_initPins and SOFTSPI_initHost
+    void SPI1_runBenchmark(void (*putChar)(char));
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_BENCHMARK_H */
+
@@ -0,0 +1,121 @@
+#include "spi1_device.h"
+#include "spi1_host.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Currently selected device
+static const SPI1_device_t* activeDevice = 0;
+
+//Device whose pin is currently routed to the hardware SS
+static const SPI1_device_t* hwSSDevice = 0;
+
+//Device table for the chip select handler
+static const SPI1_device_t* deviceTable = 0;
+static uint8_t deviceCount = 0;
+
+//Drives the GPIO SS of a device
+static void SPI1_driveSS(const SPI1_device_t* device, bool assert)
+{
+    bool high = (device->flags & SPI1_DEVICE_SS_ACTIVE_HIGH) ? assert : !assert;
+    
+    if (high)
+    {
+        *device->ssReg |= device->ssMask;
+    }
+    else
+    {
+        *device->ssReg &= ~device->ssMask;
+    }
+}
+
+//Returns the pin of the hardware SS to LAT control, at the idle level
+static void SPI1_releaseHWSS(void)
+{
+    //Idle level first - the pin follows LAT as soon as PPS is cleared
+    if (hwSSDevice->ssLat != 0)
+    {
+        if (hwSSDevice->con1 & SPI1_CON1_SSP)
+        {
+            *hwSSDevice->ssLat |= hwSSDevice->ssMask;
+        }
+        else
+        {
+            *hwSSDevice->ssLat &= ~hwSSDevice->ssMask;
+        }
+    }
+    
+    *hwSSDevice->ssReg = 0x00;
+    hwSSDevice = 0;
+}
+
+//Reprograms the registers that differ for this device and selects it
+void SPI1_selectDevice(const SPI1_device_t* device)
+{
+    if ((hwSSDevice != 0) && (hwSSDevice != device))
+    {
+        //Release the hardware SS before SSP changes, or it would select the old device
+        SPI1_releaseHWSS();
+    }
+    
+    //Mode and clock, with one disable / enable if either changed
+    SPI1_applySettings(device->con1, &device->clock);
+    
+    if (SPI1TWIDTH != device->width)
+    {
+        SPI1TWIDTH = device->width;
+    }
+    
+    if (device->flags & SPI1_DEVICE_HW_SS)
+    {
+        if (hwSSDevice == 0)
+        {
+            //Route the hardware SS to this device's pin
+            *device->ssReg = SPI1_SS_PPS;
+            hwSSDevice = device;
+        }
+    }
+    else
+    {
+        SPI1_driveSS(device, true);
+    }
+    
+    activeDevice = device;
+}
+
+//De-asserts the GPIO SS of the selected device
+void SPI1_deselectDevice(void)
+{
+    if ((activeDevice != 0) && (!(activeDevice->flags & SPI1_DEVICE_HW_SS)))
+    {
+        SPI1_driveSS(activeDevice, false);
+    }
+    
+    activeDevice = 0;
+}
+
+//Sets the table of devices used by SPI1_deviceChipSelect
+void SPI1_setDeviceTable(const SPI1_device_t* devices, uint8_t count)
+{
+    deviceTable = devices;
+    deviceCount = count;
+}
+
+//Chip select handler for queued transactions
+void SPI1_deviceChipSelect(uint8_t cs, bool select)
+{
+    if (cs >= deviceCount)
+    {
+        return;
+    }
+    
+    if (select)
+    {
+        SPI1_selectDevice(&deviceTable[cs]);
+    }
+    else
+    {
+        SPI1_deselectDevice();
+    }
+}
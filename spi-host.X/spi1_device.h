@@ -0,0 +1,82 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_DEVICE_H
+#define	SPI1_DEVICE_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+#include "spi1_host.h"
+    
+//SPI1CON1 images for the SPI modes (CPOL / CPHA)
+#define SPI1_CON1_MODE0 0x40
+#define SPI1_CON1_MODE1 0x00
+#define SPI1_CON1_MODE2 0x60
+#define SPI1_CON1_MODE3 0x20
+    
+//SPI1CON1 bit for an active low hardware SS
+#define SPI1_CON1_SSP 0x04
+    
+//Device flags
+#define SPI1_DEVICE_HW_SS 0x01              //SS driven by the SPI module (ssReg is RxyPPS)
+#define SPI1_DEVICE_SS_ACTIVE_HIGH 0x02     //GPIO SS is active high (ssReg is LATx)
+    
+//PPS output code for SS1
+#define SPI1_SS_PPS 0x1F
+    
+    //Settings for a device on the bus
+    typedef struct {
+        uint8_t con1;               //SPI1CON1 image (mode, sampling, SS polarity)
+        SPI1_clock_t clock;         //SCK setting
+        uint8_t width;              //SPI1TWIDTH
+        uint8_t flags;              //SPI1_DEVICE_* flags
+        volatile uint8_t* ssReg;    //RxyPPS (hardware SS) or LATx (GPIO SS)
+        uint8_t ssMask;             //Pin mask of the SS pin
+        volatile uint8_t* ssLat;    //LATx of the hardware SS pin (0 for GPIO SS)
+    } SPI1_device_t;
+    
+    //Reprograms the registers that differ for this device and selects it
+    //GPIO SS is asserted, hardware SS is routed to the device's pin
+    //A hardware SS pin is driven idle through ssLat before it is released,
+    //so it does not glitch to its old LAT value. Its TRIS must stay output
+    void SPI1_selectDevice(const SPI1_device_t* device);
+    
+    //De-asserts the GPIO SS of the selected device
+    //Settings are kept to speed up the next selection
+    void SPI1_deselectDevice(void);
+    
+    //Sets the table of devices used by SPI1_deviceChipSelect
+    void SPI1_setDeviceTable(const SPI1_device_t* devices, uint8_t count);
+    
+    //Chip select handler for queued transactions (see SPI1_setChipSelectHandler)
+    //cs is the index of the device in the device table
+    void SPI1_deviceChipSelect(uint8_t cs, bool select);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_DEVICE_H */
+
@@ -1,90 +1,289 @@
 #include "spi1_host.h"
+#include "spi_config.h"
+#include "crc.h"
+#include "interrupts.h"
+
+#ifdef SPI1_TRACE
+#include "spi1_trace.h"
+#endif
 
 #include <xc.h>
 #include <stdint.h>
 #include <stdbool.h>
 
-//Initializes a SPI Host
-//I/O must be initialized separately
-void SPI1_initHost(void)
+//Transaction queue (head is written by the application, tail by the ISR)
+static SPI1_transaction_t queue[SPI1_QUEUE_SIZE];
+static volatile uint8_t queueHead = 0, queueTail = 0;
+
+//Active transaction state
+static uint8_t* asyncTXData = 0;
+static uint8_t* asyncRXData = 0;
+static volatile uint16_t asyncLen = 0;
+static volatile uint16_t asyncWIndex = 0, asyncRIndex = 0;
+static volatile bool asyncRunning = false, asyncTopUp = false;
+
+//Settings of the last transaction, used to skip redundant reconfiguration
+static uint8_t activeCS = SPI1_CS_NONE;
+static uint8_t activeFlags = 0xFF;
+
+static void (*csCallback)(uint8_t, bool) = 0;
+
+#ifdef SPI1_TRACE
+
+//Results and transaction flags are stored as they are
+_Static_assert((SPI1_TIMEOUT == SPI1_TRACE_TIMEOUT) && (SPI1_CRC_ERROR == SPI1_TRACE_CRC_ERROR), "SPI1 results must match the trace status");
+_Static_assert((SPI1_XFER_TX == SPI1_TRACE_TX) && (SPI1_XFER_RX == SPI1_TRACE_RX), "SPI1 transaction flags must match the trace flags");
+
+//Timestamps and timeouts both count Timer0 ticks
+_Static_assert(SPI1_TRACE_TICK_US == SPI_TIMER0_TICK_US, "SPI1_TRACE_TICK_US must match the Timer0 tick of spi_config.h");
+
+//First bytes sent by the running transfer, copied before it starts
+//Exchanges can be in place, so txData holds received bytes by the end
+static uint8_t traceTX[SPI1_TRACE_DATA_BYTES];
+static uint8_t traceTXLen = 0;
+
+//First bytes received by a segment list (segments can discard them), and
+//the TX / RX flags of the list
+static uint8_t traceRX[SPI1_TRACE_DATA_BYTES];
+static uint16_t traceRXCount = 0;
+static uint8_t traceFlags = 0;
+
+//TX / RX flags of a transfer from its buffers (0 if not used)
+#define SPI1_TRACE_FLAGS(txData, rxData) \
+    ((((txData) != 0) ? SPI1_TRACE_TX : 0) | (((rxData) != 0) ? SPI1_TRACE_RX : 0))
+
+//Copies the first bytes of TXDATA (0 if nothing is sent)
+static void SPI1_traceStart(const uint8_t* txData, uint16_t len)
 {
-    //Host Mode, Bit Mode
-    SPI1CON0 = 0x00;
-    SPI1CON0bits.MST = 1;
-    
-    //SS is Active Low
-    SPI1CON1 = 0x00;
-    SPI1CON1bits.SSP = 1;
+    traceTXLen = 0;
     
-    //Clear RXR, TXR, SS is active only when CNT > 0
-    SPI1CON2 = 0x00;
-    
-    //Select HFINTOSC as Clock Source
-    SPI1CLK = 0b00001;
-    
-    //From a 64MHz clock, 1 MHz SCK
-    SPI1BAUD = 31;
+    if (txData == 0)
+    {
+        return;
+    }
     
-    //Set Width to 8-bits (n = 0)
-    SPI1TWIDTH = 0;
+    while ((traceTXLen < sizeof(traceTX)) && (traceTXLen < len))
+    {
+        traceTX[traceTXLen] = txData[traceTXLen];
+        traceTXLen++;
+    }
+}
+
+//Copies the first bytes sent by a segment list, fill bytes included
+static void SPI1_traceStartSegments(const SPI1_segment_t* segments, uint8_t count)
+{
+    traceTXLen = 0;
+    traceRXCount = 0;
+    traceFlags = 0;
     
-    //Enable SPI
-    SPI1CON0bits.EN = 1;
+    for (uint8_t i = 0; i < count; i++)
+    {
+        traceFlags |= SPI1_TRACE_FLAGS(segments[i].txData, segments[i].rxData);
+        
+        for (uint16_t j = 0; (j < segments[i].len) && (traceTXLen < sizeof(traceTX)); j++)
+        {
+            traceTX[traceTXLen] = (segments[i].txData != 0) ? segments[i].txData[j] : SPI1_SEGMENT_FILL;
+            traceTXLen++;
+        }
+    }
 }
 
+#define SPI1_TRACE_START(txData, len) SPI1_traceStart(txData, len)
+#define SPI1_TRACE_START_SEGMENTS(segments, count) SPI1_traceStartSegments(segments, count)
+#define SPI1_TRACE_RX_BYTE(data) do { if (traceRXCount < sizeof(traceRX)) { traceRX[traceRXCount] = (data); } traceRXCount++; } while (0)
+
+//Records are written with the copy of the TX data
+#define SPI1_TRACE_BLOCKING(flags, rxData, rxLen, len, result) \
+    SPI1_traceAdd((flags) | SPI1_TRACE_STATUS(result), SPI1_traceGetDevice(), &traceTX[0], traceTXLen, rxData, rxLen, len)
+#define SPI1_TRACE_QUEUED(transaction) \
+    SPI1_traceAdd((transaction)->flags | SPI1_TRACE_ASYNC, (transaction)->cs, \
+    &traceTX[0], traceTXLen, (transaction)->rxData, (transaction)->len, (transaction)->len)
+
+//Hooks for the template functions
+#define SPIx_TRACE_START(txData, len) SPI1_traceStart(txData, len)
+#define SPIx_TRACE(txData, rxData, len, result) \
+    SPI1_TRACE_BLOCKING(SPI1_TRACE_FLAGS(txData, rxData), rxData, len, len, result)
+
+#else
+
+#define SPI1_TRACE_START(txData, len)
+#define SPI1_TRACE_START_SEGMENTS(segments, count)
+#define SPI1_TRACE_RX_BYTE(data)
+#define SPI1_TRACE_BLOCKING(flags, rxData, rxLen, len, result)
+#define SPI1_TRACE_QUEUED(transaction)
+
+#endif
+
+//Core blocking functions are generated from the host template
+#define SPI_INSTANCE 1
+#define SPIx_TXIF PIR3bits.SPI1TXIF
+#define SPIx_RXIF PIR3bits.SPI1RXIF
+#include "spi_host_template.h"
+
 //Initializes the I/O for the SPI Host
 void SPI1_initPins(void)
 {
+    //Pins are set in spi_config.h
     //RC2 - SDO
     //RC5 - SDI
     //RC6 - SCK
     //RA5 - SS1 (alt. CS1)
     
     //SDO Config
-    TRISC2 = 0;
-    RC2PPS = 0x1E;
+    SPI_PIN_TRIS(SPI1_CFG_SDO_PIN) = 0;
+    SPI_PIN_PPS(SPI1_CFG_SDO_PIN) = SPI1_PPS_SDO;
     
     //SDI Config
-    TRISC5 = 1;
-    ANSELC5 = 0;
-    SPI1SDIPPS = 0b010101;
+    SPI_PIN_TRIS(SPI1_CFG_SDI_PIN) = 1;
+    SPI_PIN_ANSEL(SPI1_CFG_SDI_PIN) = 0;
+    SPI1SDIPPS = SPI_PIN_INPUT(SPI1_CFG_SDI_PIN);
     
     //SCK Config
-    TRISC6 = 0;
-    RC6PPS = 0x1D;
+    SPI_PIN_TRIS(SPI1_CFG_SCK_PIN) = 0;
+    SPI_PIN_PPS(SPI1_CFG_SCK_PIN) = SPI1_PPS_SCK;
     
 #ifdef HW_SS_ENABLE
     //CS Config
-    TRISA5 = 0;
-    RA5PPS = 0x1F;
+    SPI_PIN_TRIS(SPI1_CFG_SS_PIN) = 0;
+    SPI_PIN_PPS(SPI1_CFG_SS_PIN) = SPI1_PPS_SS;
 #endif
 }
 
-//Sends and receives a single byte
-uint8_t SPI1_exchangeByte(uint8_t data)
+//Finds the BAUD value for a clock source, rounding towards a slower SCK
+//Returns the achieved SCK frequency, or 0 if targetHz can't be reached
+static uint32_t SPI1_computeBaud(uint32_t targetHz, uint32_t sourceHz, uint8_t* baud)
+{
+    //SCK = Source / (2 * (BAUD + 1))
+    uint32_t divider = 1;
+    
+    if (sourceHz == 0)
+    {
+        return 0;
+    }
+    
+    if (targetHz < (sourceHz / 2))
+    {
+        //Smallest divider that does not exceed targetHz, rounded up
+        //targetHz is below 2^31 here, so 2 * targetHz can't overflow
+        divider = sourceHz / (2 * targetHz);
+        if ((sourceHz % (2 * targetHz)) != 0)
+        {
+            divider++;
+        }
+        
+        if (divider > 256)
+        {
+            //Target is below the slowest SCK
+            return 0;
+        }
+    }
+    
+    *baud = (uint8_t) (divider - 1);
+    return sourceHz / (2 * divider);
+}
+
+//Computes the fastest SCK setting that does not exceed targetHz
+uint32_t SPI1_computeClock(uint32_t targetHz, uint32_t foscHz, SPI1_clock_t* clock)
 {
-    uint8_t output = data;
-    SPI1_exchangeBytes(&output, &output, 1);
-    return output;
+    const uint8_t sources[] = {SPI1_CLOCK_FOSC, SPI1_CLOCK_HFINTOSC, SPI1_CLOCK_MFINTOSC};
+    const uint32_t sourceHz[] = {foscHz, SPI1_HFINTOSC_HZ, SPI1_MFINTOSC_HZ};
+    uint32_t best = 0;
+    
+    if (targetHz == 0)
+    {
+        return 0;
+    }
+    
+    for (uint8_t i = 0; i < sizeof(sources); i++)
+    {
+        uint8_t baud;
+        uint32_t achieved = SPI1_computeBaud(targetHz, sourceHz[i], &baud);
+        
+        //Keep the first (lowest power) source on a tie
+        if (achieved > best)
+        {
+            best = achieved;
+            clock->clockSource = sources[i];
+            clock->baud = baud;
+        }
+    }
+    
+    return best;
 }
 
-//Sends a single byte. Received data is discarded.
-void SPI1_sendByte(uint8_t data)
+//Applies a SPI1CON1 image and a SCK setting with one disable / enable
+//Registers are only written if they changed
+void SPI1_applySettings(uint8_t con1, const SPI1_clock_t* clock)
 {
-    SPI1_sendBytes(&data, 1);
+    bool con1Changed = (SPI1CON1 != con1);
+    bool clkChanged = (SPI1CLK != clock->clockSource);
+    bool baudChanged = (SPI1BAUD != clock->baud);
+    
+    if (!(con1Changed || clkChanged || baudChanged))
+    {
+        return;
+    }
+    
+    //Mode and clock can only be changed while the module is disabled
+    SPI1CON0bits.EN = 0;
+    
+    if (con1Changed)
+    {
+        SPI1CON1 = con1;
+    }
+    
+    if (clkChanged)
+    {
+        SPI1CLK = clock->clockSource;
+    }
+    
+    if (baudChanged)
+    {
+        SPI1BAUD = clock->baud;
+    }
+    
+    SPI1CON0bits.EN = 1;
 }
 
-//Receives a single byte. Transmitted data is 0x00
-uint8_t SPI1_recieveByte(void)
+//Applies a SCK setting. Registers are only written if the setting changed
+void SPI1_applyClock(const SPI1_clock_t* clock)
 {
-    uint8_t rx = 0x00;
-    SPI1_receiveBytes(&rx, 1);
-    return rx;
+    SPI1_applySettings(SPI1CON1, clock);
 }
 
-//Send and receives LEN bytes.
-void SPI1_exchangeBytes(uint8_t* txData, uint8_t* rxData, uint8_t len)
+//Computes and applies the fastest SCK setting that does not exceed targetHz
+uint32_t SPI1_setClockFrequency(uint32_t targetHz, uint32_t foscHz)
 {
+    SPI1_clock_t clock;
+    uint32_t achieved = SPI1_computeClock(targetHz, foscHz, &clock);
+    
+    if (achieved != 0)
+    {
+        SPI1_applyClock(&clock);
+    }
+    
+    return achieved;
+}
+
+//Sends and receives a CRC protected frame of LEN data bytes
+//The CRCs are computed as the bytes move, not in a second pass
+SPI1_result_t SPI1_exchangeFrame(uint8_t* txData, uint8_t* rxData, uint16_t len)
+{
+    //The CRC starts from txData[0], and the whole frame must fit the count
+    if ((len == 0) || (len > (UINT16_MAX - CRC_SIZE)))
+    {
+        return SPI1_BAD_ARGUMENT;
+    }
+    
+    //Data bytes plus the CRC
+    uint16_t total = len + CRC_SIZE;
+    
+    SPI1_TRACE_START(txData, len);
+    
+    //TX CRC in software, RX CRC on the CRC module
+    crc_t txCRC = CRC_update(CRC_SEED, txData[0]);
+    CRC_startHardware();
+    
     //Clear data buffers
     SPI1STATUSbits.CLRBF = 1;
     
@@ -95,112 +294,867 @@ void SPI1_exchangeBytes(uint8_t* txData, uint8_t* rxData, uint8_t len)
     //Clear status bit
     SPI1INTFbits.TCZIF = 0;
     
+    //Longer transfers keep SS asserted and the counter topped up. TX data
+    //sets the length, and the transfer ends on the last byte received
+    bool topUp = (total > SPI1_MAX_TCNT);
+    SPI1CON2bits.SSET = topUp ? 1 : 0;
+    
     //Load Byte 0
     SPI1TXB = txData[0];
     
     //Set data length
-    SPI1TCNTL = len;
+    SPI1_loadCount(total);
     
     //Write / Read Index
-    uint8_t wIndex = 1, rIndex = 0;
+    uint16_t wIndex = 1, rIndex = 0;
+    uint8_t data;
+    
+    //Timeout restarts whenever the transfer makes progress
+    uint16_t lastProgress = SPI1_readTimer();
     
     //While counter is not zero
-    while (!SPI1INTFbits.TCZIF)
+    while (topUp ? (rIndex < total) : (!SPI1INTFbits.TCZIF))
     {
-        if ((PIR3bits.SPI1TXIF) && (wIndex < len))
+        if (SPI1_isTimedOut(lastProgress))
         {
-            //TX Buffer has space, load next byte (until we hit the LEN)
-            SPI1TXB = txData[wIndex];
+            //Stuck - reset the module
+            SPI1_recover();
+            SPI1_TRACE_BLOCKING(SPI1_TRACE_TX | SPI1_TRACE_RX, rxData, len, total, SPI1_TIMEOUT);
+            return SPI1_TIMEOUT;
+        }
+        
+        if ((PIR3bits.SPI1TXIF) && (wIndex < total))
+        {
+            if (wIndex < len)
+            {
+                data = txData[wIndex];
+                txCRC = CRC_update(txCRC, data);
+            }
+            else
+            {
+                //Data is done, append the CRC
+                data = CRC_getByte(txCRC, (uint8_t) (wIndex - len));
+            }
+            
+            SPI1TXB = data;
             wIndex++;
+            
+            if (topUp)
+            {
+                SPI1_topUpCount(wIndex);
+            }
+            lastProgress = SPI1_readTimer();
         }
         
         if (PIR3bits.SPI1RXIF)
         {
-            //RX Buffer Ready
-            rxData[rIndex] = SPI1RXB;
+            //RX Buffer Ready - the received CRC is checked, not stored
+            data = SPI1RXB;
+            CRC_updateHardware(data);
+            if (rIndex < len)
+            {
+                rxData[rIndex] = data;
+            }
             rIndex++;
+            lastProgress = SPI1_readTimer();
         }
     }
     
     //Protects against a possible edge case where a byte is received as the module stops
     if (PIR3bits.SPI1RXIF)
+    {
+        data = SPI1RXB;
+        CRC_updateHardware(data);
+        if (rIndex < len)
+        {
+            rxData[rIndex] = data;
+        }
+        rIndex++;
+    }
+    
+    //Release SS
+    SPI1CON2bits.SSET = 0;
+    
+    if (topUp)
+    {
+        SPI1_discardCount();
+    }
+    
+    //CRC over data and CRC bytes is 0 if the frame is intact
+    if ((rIndex != total) || (CRC_getHardware() != CRC_RESIDUE))
+    {
+        SPI1_TRACE_BLOCKING(SPI1_TRACE_TX | SPI1_TRACE_RX, rxData, len, total, SPI1_CRC_ERROR);
+        return SPI1_CRC_ERROR;
+    }
+    
+    SPI1_TRACE_BLOCKING(SPI1_TRACE_TX | SPI1_TRACE_RX, rxData, len, total, SPI1_OK);
+    return SPI1_OK;
+}
+
+//Runs one phase of a command, with SS held by the caller
+//TX-only if rxData is 0, RX-only if txData is 0, fill bytes if both are 0
+static SPI1_result_t SPI1_runPhase(const uint8_t* txData, uint8_t* rxData, uint16_t len)
+{
+    //Longer phases keep the counter topped up. They run full duplex, with
+    //fill bytes sent or the received bytes discarded, and end on the last
+    //byte received
+    bool topUp = (len > SPI1_MAX_TCNT);
+    bool transmit = (txData != 0) || (rxData == 0) || (topUp);
+    bool receive = (rxData != 0) || (topUp);
+    uint8_t data;
+    
+    if (len == 0)
+    {
+        return SPI1_OK;
+    }
+    
+    //Module is idle between phases, so TXR / RXR can be changed
+    SPI1CON2bits.TXR = transmit;
+    SPI1CON2bits.RXR = receive;
+    
+    //Clear status bit
+    SPI1INTFbits.TCZIF = 0;
+    
+    if (transmit)
+    {
+        //Load Byte 0
+        SPI1TXB = (txData != 0) ? txData[0] : SPI1_COMMAND_FILL;
+    }
+    
+    //Set data length
+    SPI1_loadCount(len);
+    
+    //Write / Read Index
+    uint16_t wIndex = 1, rIndex = 0;
+    
+    //Timeout restarts whenever the transfer makes progress
+    uint16_t lastProgress = SPI1_readTimer();
+    
+    //While counter is not zero
+    while (topUp ? (rIndex < len) : (!SPI1INTFbits.TCZIF))
+    {
+        if (SPI1_isTimedOut(lastProgress))
+        {
+            //Stuck - reset the module (also releases SS)
+            SPI1_recover();
+            return SPI1_TIMEOUT;
+        }
+        
+        if ((transmit) && (PIR3bits.SPI1TXIF) && (wIndex < len))
+        {
+            //TX Buffer has space, load next byte (until we hit the LEN)
+            SPI1TXB = (txData != 0) ? txData[wIndex] : SPI1_COMMAND_FILL;
+            wIndex++;
+            
+            if (topUp)
+            {
+                SPI1_topUpCount(wIndex);
+            }
+            lastProgress = SPI1_readTimer();
+        }
+        
+        if ((receive) && (PIR3bits.SPI1RXIF))
+        {
+            //RX Buffer Ready
+            data = SPI1RXB;
+            if (rxData != 0)
+            {
+                rxData[rIndex] = data;
+            }
+            rIndex++;
+            lastProgress = SPI1_readTimer();
+        }
+    }
+    
+    //Bytes received as the module stops. RX-only, the bus can run ahead of
+    //the loop and stop with both FIFO bytes unread
+    while ((receive) && (PIR3bits.SPI1RXIF) && (rIndex < len))
     {
         //RX Buffer Ready
-        rxData[rIndex] = SPI1RXB;
+        data = SPI1RXB;
+        if (rxData != 0)
+        {
+            rxData[rIndex] = data;
+        }
         rIndex++;
     }
+    
+    if (topUp)
+    {
+        //Only the data phase can be this long, so SS is released next
+        SPI1_discardCount();
+    }
+    
+    return SPI1_OK;
 }
 
-//Sends LEN bytes. Received data is discarded.
-void SPI1_sendBytes(uint8_t* txData, uint8_t len)
+//Runs the command, address, dummy and data phases of a command in one SS assertion
+SPI1_result_t SPI1_executeCommand(const SPI1_command_t* command)
 {
+    uint8_t header[1 + SPI1_COMMAND_MAX_ADDRESS];
+    uint8_t headerLen = 1;
+    uint8_t addressLen = command->addressLen;
+    SPI1_result_t result;
+    
+    //A shorter address would reach a different location
+    if (addressLen > SPI1_COMMAND_MAX_ADDRESS)
+    {
+        return SPI1_BAD_ARGUMENT;
+    }
+    
+    //Opcode, then address MSB first
+    header[0] = command->opcode;
+    
+    while (addressLen != 0)
+    {
+        addressLen--;
+        header[headerLen] = (uint8_t) (command->address >> (addressLen * 8));
+        headerLen++;
+    }
+    
+    //Clear data buffers
+    SPI1STATUSbits.CLRBF = 1;
+    
+    //Hold SS across all phases
+    SPI1CON2bits.SSET = 1;
+    
+    //Command and address - TX only, nothing is stored
+    result = SPI1_runPhase(&header[0], 0, headerLen);
+    
+    //Dummy bytes
+    if (result == SPI1_OK)
+    {
+        result = SPI1_runPhase(0, 0, command->dummyLen);
+    }
+    
+    //Data - straight to / from the caller's buffers
+    if (result == SPI1_OK)
+    {
+        result = SPI1_runPhase(command->txData, command->rxData, command->dataLen);
+    }
+    
+    //Release SS
+    SPI1CON2bits.SSET = 0;
+    
+    //Header is recorded as the data sent, and the data phase as the data received
+    SPI1_TRACE_START(&header[0], headerLen);
+    SPI1_TRACE_BLOCKING(SPI1_TRACE_TX | ((command->rxData != 0) ? SPI1_TRACE_RX : 0),
+        command->rxData, command->dataLen, headerLen + command->dummyLen + command->dataLen, result);
+    
+    return result;
+}
+
+//Sends and receives a list of segments in one SS assertion and one transfer count
+SPI1_result_t SPI1_exchangeSegments(const SPI1_segment_t* segments, uint8_t count)
+{
+    uint32_t sum = 0;
+    bool receive = false;
+    
+    for (uint8_t i = 0; i < count; i++)
+    {
+        sum += segments[i].len;
+        
+        if ((segments[i].rxData != 0) && (segments[i].len != 0))
+        {
+            receive = true;
+        }
+    }
+    
+    //The whole list runs from one count
+    if (sum > UINT16_MAX)
+    {
+        return SPI1_BAD_ARGUMENT;
+    }
+    
+    uint16_t total = (uint16_t) sum;
+    
+    if (total == 0)
+    {
+        return SPI1_OK;
+    }
+    
+    SPI1_TRACE_START_SEGMENTS(segments, count);
+    
+    //TX and RX cursors - the segment, the next byte, and the bytes left in it
+    uint8_t txIndex = 0, rxIndex = 0;
+    const uint8_t* txPtr = segments[0].txData;
+    uint8_t* rxPtr = segments[0].rxData;
+    uint16_t txLeft = segments[0].len, rxLeft = segments[0].len;
+    
     //Clear data buffers
     SPI1STATUSbits.CLRBF = 1;
     
-    //Enable TX and Disable RX
+    //Longer transfers keep SS asserted and the counter topped up. TX data
+    //sets the length, and the transfer ends on the last byte received
+    bool topUp = (total > SPI1_MAX_TCNT);
+    
+    //Direction is handled per segment. A list with nothing to store runs TX
+    //only, so the loop does not read and drop each byte
+    receive = receive || topUp;
+    
+    //Enable TX, and RX if stored
     SPI1CON2bits.TXR = 1;
-    SPI1CON2bits.RXR = 0;
+    SPI1CON2bits.RXR = receive;
     
     //Clear status bit
     SPI1INTFbits.TCZIF = 0;
     
-    //Load Byte 0
-    SPI1TXB = txData[0];
+    SPI1CON2bits.SSET = topUp ? 1 : 0;
     
-    //Set data length
-    SPI1TCNTL = len;
+    //Set data length - transfer starts when byte 0 is loaded
+    SPI1_loadCount(total);
     
     //Write / Read Index
-    uint8_t wIndex = 1;
+    uint16_t wIndex = 0, rIndex = 0;
+    uint8_t data;
+    
+    //Timeout restarts whenever the transfer makes progress
+    uint16_t lastProgress = SPI1_readTimer();
     
     //While counter is not zero
-    while (!SPI1INTFbits.TCZIF)
+    while (topUp ? (rIndex < total) : (!SPI1INTFbits.TCZIF))
     {
-        if ((PIR3bits.SPI1TXIF) && (wIndex < len))
+        if (SPI1_isTimedOut(lastProgress))
         {
-            //TX Buffer has space, load next byte (until we hit the LEN)
-            SPI1TXB = txData[wIndex];
+            //Stuck - reset the module
+            SPI1_recover();
+            SPI1_TRACE_BLOCKING(traceFlags, &traceRX[0], traceRXCount, total, SPI1_TIMEOUT);
+            return SPI1_TIMEOUT;
+        }
+        
+        if ((PIR3bits.SPI1TXIF) && (wIndex < total))
+        {
+            while (txLeft == 0)
+            {
+                //Next segment (empty segments are skipped)
+                txIndex++;
+                txPtr = segments[txIndex].txData;
+                txLeft = segments[txIndex].len;
+            }
+            
+            if (txPtr != 0)
+            {
+                SPI1TXB = *txPtr;
+                txPtr++;
+            }
+            else
+            {
+                SPI1TXB = SPI1_SEGMENT_FILL;
+            }
+            
+            txLeft--;
             wIndex++;
+            
+            if (topUp)
+            {
+                SPI1_topUpCount(wIndex);
+            }
+            lastProgress = SPI1_readTimer();
+        }
+        
+        if ((receive) && (PIR3bits.SPI1RXIF))
+        {
+            //RX Buffer Ready
+            data = SPI1RXB;
+            SPI1_TRACE_RX_BYTE(data);
+            
+            while (rxLeft == 0)
+            {
+                rxIndex++;
+                rxPtr = segments[rxIndex].rxData;
+                rxLeft = segments[rxIndex].len;
+            }
+            
+            if (rxPtr != 0)
+            {
+                *rxPtr = data;
+                rxPtr++;
+            }
+            
+            rxLeft--;
+            rIndex++;
+            lastProgress = SPI1_readTimer();
+        }
+    }
+    
+    //Protects against a possible edge case where a byte is received as the module stops
+    if ((receive) && (PIR3bits.SPI1RXIF))
+    {
+        data = SPI1RXB;
+        SPI1_TRACE_RX_BYTE(data);
+        
+        while (rxLeft == 0)
+        {
+            rxIndex++;
+            rxPtr = segments[rxIndex].rxData;
+            rxLeft = segments[rxIndex].len;
+        }
+        
+        if (rxPtr != 0)
+        {
+            *rxPtr = data;
         }
     }
+    
+    //Release SS
+    SPI1CON2bits.SSET = 0;
+    
+    if (topUp)
+    {
+        SPI1_discardCount();
+    }
+    
+    //The whole list is recorded as 1 transfer
+    SPI1_TRACE_BLOCKING(traceFlags, &traceRX[0], traceRXCount, total, SPI1_OK);
+    return SPI1_OK;
 }
 
-//Receives LEN bytes. Transmitted data is 0x00
-void SPI1_receiveBytes(uint8_t* rxData, uint8_t len)
+//Returns the address of the byte sent at position POS of a word
+static uint8_t* SPI1_wordByte(uint8_t* word, uint8_t pos, uint8_t size, uint8_t order)
 {
+    //Memory is little endian
+    return (order == SPI1_MSB_FIRST) ? &word[size - 1 - pos] : &word[pos];
+}
+
+//Stores byte POS of a received word. The unused upper bytes of the word are
+//cleared with its last byte, so the TX data of an in-place exchange is kept
+static void SPI1_storeWordByte(uint8_t* word, uint8_t pos, uint8_t size, uint8_t stride, uint8_t order, uint8_t data)
+{
+    *SPI1_wordByte(word, pos, size, order) = data;
+    
+    if (pos == (size - 1))
+    {
+        for (uint8_t i = size; i < stride; i++)
+        {
+            word[i] = 0x00;
+        }
+    }
+}
+
+//Sends and receives COUNT words of SIZE bytes, stored STRIDE bytes apart
+static SPI1_result_t SPI1_exchangePacked(uint8_t* txData, uint8_t* rxData, uint16_t count, uint8_t size, uint8_t stride, uint8_t order)
+{
+    //The bytes must fit the 16-bit length
+    if (count > (UINT16_MAX / size))
+    {
+        return SPI1_BAD_ARGUMENT;
+    }
+    
+    uint16_t len = count * size;
+    
+    if (len == 0)
+    {
+        return SPI1_OK;
+    }
+    
     //Clear data buffers
     SPI1STATUSbits.CLRBF = 1;
     
-    //Enable RX and Disable TX
-    SPI1CON2bits.TXR = 0;
+    //Enable TX and RX
+    SPI1CON2bits.TXR = 1;
     SPI1CON2bits.RXR = 1;
     
     //Clear status bit
     SPI1INTFbits.TCZIF = 0;
     
+    //Longer transfers keep SS asserted and the counter topped up. TX data
+    //sets the length, and the transfer ends on the last byte received
+    bool topUp = (len > SPI1_MAX_TCNT);
+    SPI1CON2bits.SSET = topUp ? 1 : 0;
+    
+    //Word and byte position of the next byte to write / read
+    uint8_t* txWord = txData;
+    uint8_t* rxWord = rxData;
+    uint8_t txPos = 0, rxPos = 0;
+    
+    //Load Byte 0
+    SPI1TXB = *SPI1_wordByte(txWord, txPos, size, order);
+    txPos++;
+    
     //Set data length
-    SPI1TCNTL = len;
+    SPI1_loadCount(len);
     
     //Write / Read Index
-    uint8_t rIndex = 0;
+    uint16_t wIndex = 1, rIndex = 0;
+    
+    //Timeout restarts whenever the transfer makes progress
+    uint16_t lastProgress = SPI1_readTimer();
     
     //While counter is not zero
-    while (!SPI1INTFbits.TCZIF)
+    while (topUp ? (rIndex < len) : (!SPI1INTFbits.TCZIF))
     {
-        //Protects against a possible edge case where a byte is received as the module stops
+        if (SPI1_isTimedOut(lastProgress))
+        {
+            //Stuck - reset the module
+            SPI1_recover();
+            return SPI1_TIMEOUT;
+        }
+        
+        if ((PIR3bits.SPI1TXIF) && (wIndex < len))
+        {
+            if (txPos == size)
+            {
+                //Next word
+                txPos = 0;
+                txWord += stride;
+            }
+            
+            //TX Buffer has space, load next byte (until we hit the LEN)
+            SPI1TXB = *SPI1_wordByte(txWord, txPos, size, order);
+            txPos++;
+            wIndex++;
+            
+            if (topUp)
+            {
+                SPI1_topUpCount(wIndex);
+            }
+            lastProgress = SPI1_readTimer();
+        }
+        
         if (PIR3bits.SPI1RXIF)
         {
+            if (rxPos == size)
+            {
+                //Next word
+                rxPos = 0;
+                rxWord += stride;
+            }
+            
             //RX Buffer Ready
-            rxData[rIndex] = SPI1RXB;
+            SPI1_storeWordByte(rxWord, rxPos, size, stride, order, SPI1RXB);
+            rxPos++;
             rIndex++;
+            lastProgress = SPI1_readTimer();
         }
     }
     
     //Protects against a possible edge case where a byte is received as the module stops
     if (PIR3bits.SPI1RXIF)
     {
-        //RX Buffer Ready
-        rxData[rIndex] = SPI1RXB;
-        rIndex++;
+        if (rxPos == size)
+        {
+            rxPos = 0;
+            rxWord += stride;
+        }
+        
+        SPI1_storeWordByte(rxWord, rxPos, size, stride, order, SPI1RXB);
+    }
+    
+    //Release SS
+    SPI1CON2bits.SSET = 0;
+    
+    if (topUp)
+    {
+        SPI1_discardCount();
+    }
+    
+    return SPI1_OK;
+}
+
+//Sends and receives COUNT 16-bit words
+SPI1_result_t SPI1_exchangeWords16(uint16_t* txData, uint16_t* rxData, uint16_t count, uint8_t order)
+{
+    return SPI1_exchangePacked((uint8_t*) txData, (uint8_t*) rxData, count, 2, 2, order);
+}
+
+//Sends and receives COUNT 24-bit words, stored in the low bytes of 32-bit values
+SPI1_result_t SPI1_exchangeWords24(uint32_t* txData, uint32_t* rxData, uint16_t count, uint8_t order)
+{
+    return SPI1_exchangePacked((uint8_t*) txData, (uint8_t*) rxData, count, 3, 4, order);
+}
+
+//Sends and receives COUNT 32-bit words
+SPI1_result_t SPI1_exchangeWords32(uint32_t* txData, uint32_t* rxData, uint16_t count, uint8_t order)
+{
+    return SPI1_exchangePacked((uint8_t*) txData, (uint8_t*) rxData, count, 4, 4, order);
+}
+
+//Sends and receives COUNT frames of WIDTH (1 to 8) bits
+SPI1_result_t SPI1_exchangeBits(uint8_t* txData, uint8_t* rxData, uint16_t count, uint8_t width)
+{
+    if ((width == 0) || (width > 8))
+    {
+        return SPI1_BAD_ARGUMENT;
+    }
+    
+    uint8_t oldWidth = SPI1TWIDTH;
+    
+    //Every byte transfers TWIDTH bits (0 = 8 bits)
+    SPI1CON0bits.EN = 0;
+    SPI1CON0bits.BMODE = 1;
+    SPI1TWIDTH = width & 0x07;
+    SPI1CON0bits.EN = 1;
+    
+    //Data is right aligned in each byte
+    SPI1_result_t result = SPI1_exchangeBytes(txData, rxData, count);
+    
+    //Restore Bit Mode
+    SPI1CON0bits.EN = 0;
+    SPI1CON0bits.BMODE = 0;
+    SPI1TWIDTH = oldWidth;
+    SPI1CON0bits.EN = 1;
+    
+    return result;
+}
+
+//Starts the transaction at the tail of the queue
+static void SPI1_loadTransaction(void)
+{
+    SPI1_transaction_t* transaction = &queue[queueTail % SPI1_QUEUE_SIZE];
+    
+    if (transaction->cs != activeCS)
+    {
+        //Switch devices
+        if (csCallback != 0)
+        {
+            if (activeCS != SPI1_CS_NONE)
+            {
+                csCallback(activeCS, false);
+            }
+            
+            if (transaction->cs != SPI1_CS_NONE)
+            {
+                csCallback(transaction->cs, true);
+            }
+        }
+        
+        activeCS = transaction->cs;
+    }
+    
+    //Longer transactions keep the counter topped up. They run full duplex,
+    //with fill bytes sent or the received bytes discarded, and end on the
+    //last byte received
+    asyncTopUp = (transaction->len > SPI1_MAX_TCNT);
+    uint8_t mode = asyncTopUp ? (SPI1_XFER_TX | SPI1_XFER_RX) : transaction->flags;
+    
+    if (mode != activeFlags)
+    {
+        //Clear data buffers
+        SPI1STATUSbits.CLRBF = 1;
+        
+        //Enable TX and RX as requested
+        SPI1CON2bits.TXR = (mode & SPI1_XFER_TX) ? 1 : 0;
+        SPI1CON2bits.RXR = (mode & SPI1_XFER_RX) ? 1 : 0;
+        
+        activeFlags = mode;
+    }
+    
+    //0 if the direction is not requested
+    asyncTXData = (transaction->flags & SPI1_XFER_TX) ? transaction->txData : 0;
+    asyncRXData = (transaction->flags & SPI1_XFER_RX) ? transaction->rxData : 0;
+    asyncLen = transaction->len;
+    
+    SPI1_TRACE_START((transaction->flags & SPI1_XFER_TX) ? transaction->txData : 0, transaction->len);
+    asyncWIndex = 0;
+    asyncRIndex = 0;
+    
+    //Clear status bit
+    SPI1INTFbits.TCZIF = 0;
+    
+    //Keep SS asserted while the counter is topped up
+    SPI1CON2bits.SSET = asyncTopUp ? 1 : 0;
+    
+    if (mode & SPI1_XFER_TX)
+    {
+        //Load Byte 0
+        SPI1TXB = (asyncTXData != 0) ? asyncTXData[0] : 0x00;
+        asyncWIndex = 1;
+    }
+    
+    //Set data length
+    SPI1_loadCount(asyncLen);
+    
+    //Enable interrupts needed for this transaction
+    PIE3bits.SPI1RXIE = (mode & SPI1_XFER_RX) ? 1 : 0;
+    PIE3bits.SPI1TXIE = ((mode & SPI1_XFER_TX) && (asyncWIndex < asyncLen)) ? 1 : 0;
+}
+
+//Finishes the running transaction, and starts the next one
+static void SPI1_endTransaction(void)
+{
+    SPI1CON2bits.SSET = 0;
+    
+    if (asyncTopUp)
+    {
+        SPI1_discardCount();
+    }
+    
+    //Protects against a possible edge case where a byte is received as the module stops
+    if ((asyncRXData != 0) && (PIR3bits.SPI1RXIF))
+    {
+        asyncRXData[asyncRIndex] = SPI1RXB;
+        asyncRIndex++;
+    }
+    
+    void (*callback)(void) = queue[queueTail % SPI1_QUEUE_SIZE].callback;
+    
+    SPI1_TRACE_QUEUED(&queue[queueTail % SPI1_QUEUE_SIZE]);
+    
+    //Release the descriptor
+    queueTail++;
+    
+    if (queueHead != queueTail)
+    {
+        //Start the next transaction back-to-back
+        SPI1_loadTransaction();
+    }
+    else
+    {
+        //Queue is empty, stop interrupts
+        PIE3bits.SPI1TXIE = 0;
+        PIE3bits.SPI1RXIE = 0;
+        PIE3bits.SPI1IE = 0;
+        SPI1INTEbits.TCZIE = 0;
+        
+        if ((csCallback != 0) && (activeCS != SPI1_CS_NONE))
+        {
+            csCallback(activeCS, false);
+        }
+        
+        //Blocking functions may change the settings while idle
+        activeCS = SPI1_CS_NONE;
+        activeFlags = 0xFF;
+        asyncRunning = false;
+    }
+    
+    if (callback != 0)
+    {
+        callback();
+    }
+}
+
+//Adds a transaction to the queue, and starts it if the bus is idle
+bool SPI1_queueTransaction(const SPI1_transaction_t* transaction)
+{
+    if ((transaction->len == 0) || (SPI1_getQueueCount() >= SPI1_QUEUE_SIZE))
+    {
+        return false;
+    }
+    
+    //Copy the descriptor, then publish it
+    queue[queueHead % SPI1_QUEUE_SIZE] = *transaction;
+    queueHead++;
+    
+    if (!asyncRunning)
+    {
+        asyncRunning = true;
+        
+        //Clears TCZIF left by a blocking transfer before the interrupt is enabled
+        SPI1_loadTransaction();
+        
+        //Interrupt when the counter reaches zero
+        SPI1INTEbits.TCZIE = 1;
+        PIE3bits.SPI1IE = 1;
+    }
+    
+    return true;
+}
+
+//Returns the number of transactions waiting or running
+uint8_t SPI1_getQueueCount(void)
+{
+    return (uint8_t) (queueHead - queueTail);
+}
+
+//Sets a callback function to select and de-select devices
+void SPI1_setChipSelectHandler(void (*callback)(uint8_t, bool))
+{
+    csCallback = callback;
+}
+
+//Starts sending and receiving LEN bytes in the background
+bool SPI1_exchangeBytesAsync(uint8_t* txData, uint8_t* rxData, uint16_t len, void (*doneCallback)(void))
+{
+    SPI1_transaction_t transaction;
+    
+    transaction.txData = txData;
+    transaction.rxData = rxData;
+    transaction.len = len;
+    transaction.cs = SPI1_CS_NONE;
+    transaction.flags = SPI1_XFER_TX | SPI1_XFER_RX;
+    transaction.callback = doneCallback;
+    
+    return SPI1_queueTransaction(&transaction);
+}
+
+//Returns the state of the async transfer engine
+SPI1_status_t SPI1_getStatus(void)
+{
+    uint8_t count = SPI1_getQueueCount();
+    
+    if (count == 0)
+    {
+        return SPI1_STATUS_IDLE;
+    }
+    else if (count == 1)
+    {
+        return SPI1_STATUS_BUSY;
+    }
+    
+    return SPI1_STATUS_QUEUED;
+}
+
+//Returns true while an async transfer is running
+bool SPI1_isBusy(void)
+{
+    return asyncRunning;
+}
+
+#ifdef SPI1_TRACE
+
+//Clears the trace. Transfers are recorded from now on
+void SPI1_initTrace(void)
+{
+    SPI1_traceClear();
+}
+
+#endif
+
+void __interrupt(irq(SPI1TX), base(INTERRUPT_BASE)) SPI1_TX_ISR(void)
+{
+    //TX Buffer has space, load next byte (or a fill byte)
+    SPI1TXB = (asyncTXData != 0) ? asyncTXData[asyncWIndex] : 0x00;
+    asyncWIndex++;
+    
+    if (asyncTopUp)
+    {
+        SPI1_topUpCount(asyncWIndex);
+    }
+    
+    if (asyncWIndex >= asyncLen)
+    {
+        //All bytes are loaded, TX flag stays set until the next transfer
+        PIE3bits.SPI1TXIE = 0;
+    }
+    
+    //Interrupt flag is cleared automatically by writing
+}
+
+void __interrupt(irq(SPI1RX), base(INTERRUPT_BASE)) SPI1_RX_ISR(void)
+{
+    //RX Buffer Ready (discarded if RX was not requested)
+    uint8_t data = SPI1RXB;
+    
+    if (asyncRXData != 0)
+    {
+        asyncRXData[asyncRIndex] = data;
+    }
+    asyncRIndex++;
+    
+    //The counter of a longer transaction never reaches zero
+    if ((asyncTopUp) && (asyncRIndex == asyncLen))
+    {
+        SPI1_endTransaction();
+    }
+    
+    //Interrupt flag is cleared automatically by reading
+}
+
+void __interrupt(irq(SPI1), base(INTERRUPT_BASE)) SPI1_status_ISR(void)
+{
+    if (SPI1INTFbits.TCZIF)
+    {
+        SPI1INTFbits.TCZIF = 0;
+        SPI1_endTransaction();
     }
 }
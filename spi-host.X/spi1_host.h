@@ -26,10 +26,99 @@ extern "C" {
 #endif
     
 #include <stdint.h>
+#include <stdbool.h>
     
 //If defined, the HW will assert Serial Select (SS) automatically
 #define HW_SS_ENABLE
     
+//If defined, transfers are recorded in a RAM ring (see spi1_trace.h)
+//#define SPI1_TRACE
+    
+    //State of the interrupt driven (async) transfer engine
+    typedef enum {
+        SPI1_STATUS_IDLE = 0, SPI1_STATUS_BUSY, SPI1_STATUS_QUEUED
+    } SPI1_status_t;
+    
+//SPI1CLK clock sources
+#define SPI1_CLOCK_FOSC 0x00
+#define SPI1_CLOCK_HFINTOSC 0x01
+#define SPI1_CLOCK_MFINTOSC 0x02
+    
+//Frequencies of the internal clock sources
+#define SPI1_HFINTOSC_HZ 64000000UL
+#define SPI1_MFINTOSC_HZ 500000UL
+    
+    //Result of a blocking transfer
+    //SPI1_BAD_ARGUMENT is returned before anything is sent
+    typedef enum {
+        SPI1_OK = 0, SPI1_TIMEOUT, SPI1_CRC_ERROR, SPI1_BAD_ARGUMENT
+    } SPI1_result_t;
+    
+    //SCK clock setting
+    typedef struct {
+        uint8_t clockSource;        //SPI1CLK value
+        uint8_t baud;               //SPI1BAUD value
+    } SPI1_clock_t;
+    
+//Byte order of words on the bus
+#define SPI1_MSB_FIRST 0
+#define SPI1_LSB_FIRST 1
+    
+//Largest count the transfer counter (SPI1TCNTH:L) can hold
+//Longer transfers hold SS asserted and keep the counter topped up
+#define SPI1_MAX_TCNT 2047
+    
+//Bytes loaded between top-ups of the counter (power of 2), leaving room for
+//the bytes in the TX FIFO and the shift register
+#define SPI1_TOPUP_BYTES 1024
+    
+//Number of transactions that can be queued (power of 2)
+#define SPI1_QUEUE_SIZE 8
+    
+//Transaction flags
+#define SPI1_XFER_TX 0x01
+#define SPI1_XFER_RX 0x02
+    
+//Chip select value for "no device selected"
+#define SPI1_CS_NONE 0xFF
+    
+//Longest address phase of a command, in bytes
+#define SPI1_COMMAND_MAX_ADDRESS 4
+    
+//Byte sent during dummy phases
+#define SPI1_COMMAND_FILL 0x00
+    
+    //Command descriptor (opcode, address, dummy and data phases)
+    typedef struct {
+        uint8_t opcode;             //Sent first
+        uint8_t addressLen;         //Address bytes (0 to 4), sent MSB first
+        uint32_t address;
+        uint8_t dummyLen;           //Dummy bytes sent after the address
+        uint8_t* txData;            //Data to write (0 for a read)
+        uint8_t* rxData;            //Data read (0 for a write)
+        uint16_t dataLen;           //Number of data bytes
+    } SPI1_command_t;
+    
+//Byte sent for segments without txData
+#define SPI1_SEGMENT_FILL 0x00
+    
+    //Scatter-gather segment
+    typedef struct {
+        const uint8_t* txData;      //Data to send (0 sends SPI1_SEGMENT_FILL)
+        uint8_t* rxData;            //Received data (0 discards it). Can be txData
+        uint16_t len;               //Number of bytes
+    } SPI1_segment_t;
+    
+    //Queued transaction descriptor
+    typedef struct {
+        uint8_t* txData;            //Data to send (SPI1_XFER_TX)
+        uint8_t* rxData;            //Received data (SPI1_XFER_RX)
+        uint16_t len;               //Number of bytes
+        uint8_t cs;                 //Chip select passed to the CS handler
+        uint8_t flags;              //SPI1_XFER_TX and/or SPI1_XFER_RX
+        void (*callback)(void);     //Run from the ISR when complete (can be 0)
+    } SPI1_transaction_t;
+    
     //Initializes a SPI Host
     //I/O must be initialized separately
     void SPI1_initHost(void);
@@ -37,6 +126,50 @@ extern "C" {
     //Initializes the I/O for the SPI Host
     void SPI1_initPins(void);
     
+    //Computes the fastest SCK setting that does not exceed targetHz
+    //foscHz is the system clock, used for the FOSC clock source
+    //Returns the achieved SCK frequency, or 0 if targetHz can't be reached
+    uint32_t SPI1_computeClock(uint32_t targetHz, uint32_t foscHz, SPI1_clock_t* clock);
+    
+    //Applies a SCK setting. Registers are only written if the setting changed
+    //Must not be called while a transfer is running
+    void SPI1_applyClock(const SPI1_clock_t* clock);
+    
+    //Applies a SPI1CON1 image (mode, SS polarity) and a SCK setting with one
+    //disable / enable of the module. Registers are only written if they changed
+    //Must not be called while a transfer is running
+    void SPI1_applySettings(uint8_t con1, const SPI1_clock_t* clock);
+    
+    //Computes and applies the fastest SCK setting that does not exceed targetHz
+    //Returns the achieved SCK frequency, or 0 if targetHz can't be reached
+    uint32_t SPI1_setClockFrequency(uint32_t targetHz, uint32_t foscHz);
+    
+    //Sets the timeout for blocking transfers, in us (0 disables the timeout)
+    //A transfer times out if no byte moves for this long (max. 65535 us)
+    //Rounded down to a Timer0 tick (SPI_TIMER0_TICK_US in spi_config.h)
+    void SPI1_setTimeout(uint16_t timeoutUs);
+    
+    //Resets the SPI module after a fault, keeping SPI1CON0/1/2
+    void SPI1_recover(void);
+    
+    //Returns the free-running Timer0 count, the timebase of the timeouts
+    uint16_t SPI1_readTimer(void);
+    
+    //Returns true if no progress has been made for the timeout since the
+    //Timer0 count lastProgress (always false if the timeout is disabled)
+    bool SPI1_isTimedOut(uint16_t lastProgress);
+    
+    //Loads the next block (up to SPI1_MAX_TCNT) of the transfer counter
+    //Returns the number of bytes left for later blocks
+    uint16_t SPI1_loadCount(uint16_t remaining);
+    
+    //Sets the counter back to SPI1_MAX_TCNT every SPI1_TOPUP_BYTES bytes
+    //loaded, for transfers longer than the counter
+    void SPI1_topUpCount(uint16_t loaded);
+    
+    //Drops the count left by a topped up transfer
+    void SPI1_discardCount(void);
+    
     //Sends and receives a single byte
     uint8_t SPI1_exchangeByte(uint8_t data);
     
@@ -47,13 +180,81 @@ extern "C" {
     uint8_t SPI1_recieveByte(void);
     
     //Send and receives LEN bytes
-    void SPI1_exchangeBytes(uint8_t* txData, uint8_t* rxData, uint8_t len);
+    //Blocking transfers return SPI1_TIMEOUT if the bus stalls (see SPI1_setTimeout)
+    SPI1_result_t SPI1_exchangeBytes(uint8_t* txData, uint8_t* rxData, uint16_t len);
+    
+    //Sends and receives a frame of LEN data bytes followed by a CRC (see crc.h)
+    //Only the LEN data bytes are stored in rxData
+    //Returns SPI1_CRC_ERROR if the received CRC does not match, and
+    //SPI1_BAD_ARGUMENT if LEN is 0 or the frame does not fit 65535 bytes
+    SPI1_result_t SPI1_exchangeFrame(uint8_t* txData, uint8_t* rxData, uint16_t len);
     
     //Sends LEN bytes. Received data is discarded
-    void SPI1_sendBytes(uint8_t* txData, uint8_t len);
+    SPI1_result_t SPI1_sendBytes(uint8_t* txData, uint16_t len);
     
     //Receives LEN bytes
-    void SPI1_receiveBytes(uint8_t* rxData, uint8_t len);
+    SPI1_result_t SPI1_receiveBytes(uint8_t* rxData, uint16_t len);
+    
+    //Runs a command in one SS assertion: opcode and address (TX only),
+    //dummy bytes, then the data phase (RX only, TX only or both)
+    //Received data goes straight to rxData - nothing else is stored
+    //Returns SPI1_BAD_ARGUMENT if addressLen is over SPI1_COMMAND_MAX_ADDRESS
+    SPI1_result_t SPI1_executeCommand(const SPI1_command_t* command);
+    
+    //Sends and receives COUNT segments in one SS assertion and one transfer count
+    //Data is read from and written to each segment in place - no staging buffer
+    //Returns SPI1_BAD_ARGUMENT if the segments add up to more than 65535 bytes
+    SPI1_result_t SPI1_exchangeSegments(const SPI1_segment_t* segments, uint8_t count);
+    
+    //Sends and receives COUNT 16-bit words
+    //ORDER is SPI1_MSB_FIRST or SPI1_LSB_FIRST. txData and rxData can be the same
+    //Returns SPI1_BAD_ARGUMENT if the words are more than 65535 bytes
+    SPI1_result_t SPI1_exchangeWords16(uint16_t* txData, uint16_t* rxData, uint16_t count, uint8_t order);
+    
+    //Sends and receives COUNT 24-bit words, stored in the low bytes of 32-bit values
+    SPI1_result_t SPI1_exchangeWords24(uint32_t* txData, uint32_t* rxData, uint16_t count, uint8_t order);
+    
+    //Sends and receives COUNT 32-bit words
+    SPI1_result_t SPI1_exchangeWords32(uint32_t* txData, uint32_t* rxData, uint16_t count, uint8_t order);
+    
+    //Sends and receives COUNT frames of WIDTH (1 to 8) bits, one frame per byte
+    //Data is right aligned in each byte. Other widths return SPI1_BAD_ARGUMENT
+    SPI1_result_t SPI1_exchangeBits(uint8_t* txData, uint8_t* rxData, uint16_t count, uint8_t width);
+    
+    //Starts sending and receiving LEN bytes in the background, on chip select SPI1_CS_NONE
+    //doneCallback is run from the ISR when complete (can be 0)
+    //Returns false if the transaction queue is full
+    //Interrupts must be enabled for the transfer to run
+    bool SPI1_exchangeBytesAsync(uint8_t* txData, uint8_t* rxData, uint16_t len, void (*doneCallback)(void));
+    
+    //Adds a transaction to the queue. The descriptor is copied
+    //Returns false if the queue is full
+    //Interrupts must be enabled for the transfer to run
+    bool SPI1_queueTransaction(const SPI1_transaction_t* transaction);
+    
+    //Returns the number of transactions waiting or running
+    uint8_t SPI1_getQueueCount(void);
+    
+    //Sets a callback function to select (true) and de-select (false) devices
+    //Only called when the chip select changes between transactions
+    //SPI1_CS_NONE selects no device: the previous device is de-selected, but the
+    //handler is not called to select. SPI1_exchangeBytesAsync uses SPI1_CS_NONE,
+    //so its transfers only drive the module's SS
+    void SPI1_setChipSelectHandler(void (*callback)(uint8_t, bool));
+    
+    //Returns the state of the async transfer engine
+    SPI1_status_t SPI1_getStatus(void);
+    
+    //Returns true while an async transfer is running
+    bool SPI1_isBusy(void);
+    
+#ifdef SPI1_TRACE
+    
+    //Clears the trace. Transfers are recorded from now on
+    //Blocking transfers use the device ID set by SPI1_traceSetDevice
+    void SPI1_initTrace(void);
+    
+#endif
     
 #ifdef	__cplusplus
 }
@@ -0,0 +1,370 @@
+#include "spi1_host_dma.h"
+#include "spi1_host.h"
+#include "interrupts.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Set when the RX channel is part of the current transfer
+static volatile bool rxActive = false;
+
+//Bytes not yet loaded into the transfer counter
+static uint16_t dmaPending = 0;
+
+//Stream state
+static uint8_t* streamRXData = 0;
+static uint16_t streamHalfLen = 0;
+static volatile uint8_t streamNextHalf = 0;
+static void (*streamCallback)(uint8_t) = 0;
+
+//Loads the TX channel to move LEN bytes from txData into SPI1TXB
+static void SPI1_DMA_armTX(uint8_t* txData, uint16_t len)
+{
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    //Source increments and stops at the end, destination is fixed
+    DMAnCON1 = 0x03;
+    
+    //Source is the user buffer
+    DMAnSSA = (uint24_t) txData;
+    DMAnSSZ = len;
+    
+    //Destination is the TX FIFO
+    DMAnDSA = (uint16_t) &SPI1TXB;
+    DMAnDSZ = 1;
+    
+    //Move a byte every time the TX FIFO has space
+    DMAnSIRQ = SPI1_DMA_TRIGGER_TX;
+    
+    //Enable channel, start on trigger
+    DMAnCON0 = 0xC0;
+}
+
+//Loads the RX channel to move LEN bytes from SPI1RXB into rxData
+static void SPI1_DMA_armRX(uint8_t* rxData, uint16_t len)
+{
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    //Source is fixed, destination increments and stops at the end
+    DMAnCON1 = 0x60;
+    
+    //Source is the RX FIFO
+    DMAnSSA = (uint24_t) &SPI1RXB;
+    DMAnSSZ = 1;
+    
+    //Destination is the user buffer
+    DMAnDSA = (uint16_t) rxData;
+    DMAnDSZ = len;
+    
+    //Move a byte every time the RX FIFO has data
+    DMAnSIRQ = SPI1_DMA_TRIGGER_RX;
+    
+    //Enable channel, start on trigger
+    DMAnCON0 = 0xC0;
+    
+    rxActive = true;
+}
+
+//Initializes the DMA channels used by the SPI Host
+//Locks the system arbiter priorities - call with interrupts disabled
+void SPI1_DMA_init(void)
+{
+    //Make sure both channels are off
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    //Priorities (lower is higher) - RX is drained before TX is filled
+    ISRPR = 0;
+    DMA2PR = 1;
+    DMA1PR = 2;
+    MAINPR = 3;
+    
+    //Lock priorities - required for the DMA to run
+    PRLOCK = 0x55;
+    PRLOCK = 0xAA;
+    PRLOCKbits.PRLOCKED = 1;
+}
+
+//Returns true if LEN fits the 12-bit DMA counters
+static bool SPI1_DMA_isValidLength(uint16_t len)
+{
+    return (len != 0) && (len <= SPI1_DMA_MAX_LEN);
+}
+
+//Starts sending and receiving LEN bytes. Returns immediately
+bool SPI1_DMA_startExchange(uint8_t* txData, uint8_t* rxData, uint16_t len)
+{
+    if (!SPI1_DMA_isValidLength(len))
+    {
+        return false;
+    }
+    
+    //Clear data buffers
+    SPI1STATUSbits.CLRBF = 1;
+    
+    //Enable TX and RX
+    SPI1CON2bits.TXR = 1;
+    SPI1CON2bits.RXR = 1;
+    
+    //Clear status bit
+    SPI1INTFbits.TCZIF = 0;
+    
+    //Keep SS asserted while the counter is reloaded
+    SPI1CON2bits.SSET = (len > SPI1_MAX_TCNT) ? 1 : 0;
+    
+    //Set data length
+    dmaPending = SPI1_loadCount(len);
+    
+    //RX is armed first so no bytes are missed
+    SPI1_DMA_armRX(rxData, len);
+    
+    //Transfer starts when the TX channel loads byte 0
+    SPI1_DMA_armTX(txData, len);
+    
+    return true;
+}
+
+//Starts sending LEN bytes. Received data is discarded
+bool SPI1_DMA_startSend(uint8_t* txData, uint16_t len)
+{
+    if (!SPI1_DMA_isValidLength(len))
+    {
+        return false;
+    }
+    
+    //Clear data buffers
+    SPI1STATUSbits.CLRBF = 1;
+    
+    //Enable TX and Disable RX
+    SPI1CON2bits.TXR = 1;
+    SPI1CON2bits.RXR = 0;
+    
+    //Clear status bit
+    SPI1INTFbits.TCZIF = 0;
+    
+    //Keep SS asserted while the counter is reloaded
+    SPI1CON2bits.SSET = (len > SPI1_MAX_TCNT) ? 1 : 0;
+    
+    //Set data length
+    dmaPending = SPI1_loadCount(len);
+    
+    rxActive = false;
+    
+    //Transfer starts when the TX channel loads byte 0
+    SPI1_DMA_armTX(txData, len);
+    
+    return true;
+}
+
+//Starts receiving LEN bytes
+bool SPI1_DMA_startReceive(uint8_t* rxData, uint16_t len)
+{
+    if (!SPI1_DMA_isValidLength(len))
+    {
+        return false;
+    }
+    
+    //Clear data buffers
+    SPI1STATUSbits.CLRBF = 1;
+    
+    //Enable RX and Disable TX
+    SPI1CON2bits.TXR = 0;
+    SPI1CON2bits.RXR = 1;
+    
+    //Clear status bit
+    SPI1INTFbits.TCZIF = 0;
+    
+    SPI1_DMA_armRX(rxData, len);
+    
+    //Keep SS asserted while the counter is reloaded
+    SPI1CON2bits.SSET = (len > SPI1_MAX_TCNT) ? 1 : 0;
+    
+    //Transfer starts when the counter is written
+    dmaPending = SPI1_loadCount(len);
+    
+    return true;
+}
+
+//Returns true while a DMA transfer is in progress
+bool SPI1_DMA_isBusy(void)
+{
+    if (!SPI1INTFbits.TCZIF)
+    {
+        //Bytes are still being clocked
+        return true;
+    }
+    
+    if (dmaPending != 0)
+    {
+        //Reload the counter, SS stays asserted
+        SPI1INTFbits.TCZIF = 0;
+        dmaPending = SPI1_loadCount(dmaPending);
+        return true;
+    }
+    
+    if (rxActive)
+    {
+        //SIRQEN is cleared by hardware once the last byte is stored
+        DMASELECT = SPI1_DMA_RX_CHANNEL;
+        return DMAnCON0bits.SIRQEN;
+    }
+    
+    return false;
+}
+
+//Returns the bytes the transfer still has to move (RX channel if it is used)
+static uint16_t SPI1_DMA_getRemaining(void)
+{
+    if (rxActive)
+    {
+        DMASELECT = SPI1_DMA_RX_CHANNEL;
+        return DMAnDCNT;
+    }
+    
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    return DMAnSCNT;
+}
+
+//Waits for the current DMA transfer to finish and releases the channels
+SPI1_result_t SPI1_DMA_complete(void)
+{
+    SPI1_result_t result = SPI1_OK;
+    
+    //Timeout restarts whenever the channels move a byte
+    uint16_t remaining = SPI1_DMA_getRemaining();
+    uint16_t lastProgress = SPI1_readTimer();
+    
+    while (SPI1_DMA_isBusy())
+    {
+        uint16_t count = SPI1_DMA_getRemaining();
+        
+        if (count != remaining)
+        {
+            remaining = count;
+            lastProgress = SPI1_readTimer();
+        }
+        else if (SPI1_isTimedOut(lastProgress))
+        {
+            result = SPI1_TIMEOUT;
+            break;
+        }
+    }
+    
+    //Release SS
+    SPI1CON2bits.SSET = 0;
+    
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    rxActive = false;
+    dmaPending = 0;
+    
+    if (result == SPI1_TIMEOUT)
+    {
+        //Stuck - reset the module once the channels are off
+        SPI1_recover();
+    }
+    
+    return result;
+}
+
+//Starts a continuous full-duplex stream
+bool SPI1_DMA_startStream(uint8_t* txData, uint8_t* rxData, uint16_t halfLen, void (*halfCallback)(uint8_t))
+{
+    if ((halfLen == 0) || (halfLen > SPI1_STREAM_MAX_HALF))
+    {
+        return false;
+    }
+    
+    streamRXData = rxData;
+    streamHalfLen = halfLen;
+    streamCallback = halfCallback;
+    
+    //Clear data buffers
+    SPI1STATUSbits.CLRBF = 1;
+    
+    //Enable TX and RX
+    SPI1CON2bits.TXR = 1;
+    SPI1CON2bits.RXR = 1;
+    
+    //SS stays asserted for the whole stream
+    SPI1CON2bits.SSET = 1;
+    
+    //Clear status bit
+    SPI1INTFbits.TCZIF = 0;
+    
+    //Counter is topped up every half, so it never reaches zero
+    SPI1_loadCount(SPI1_MAX_TCNT);
+    
+    //RX fills 1 half at a time, starting with half 0
+    SPI1_DMA_armRX(rxData, halfLen);
+    
+    //Keep running when the destination count reloads (DSTP would clear
+    //SIRQEN after the first half). The ISR moves the pointer between halves
+    DMAnCON1bits.DSTP = 0;
+    
+    //Next reload of the destination pointer uses half 1
+    DMAnDSA = (uint16_t) &rxData[halfLen];
+    streamNextHalf = 0;
+    
+    SPI1_DMA_RX_DCNTIF = 0;
+    SPI1_DMA_RX_DCNTIE = 1;
+    
+    //TX source wraps around both halves
+    SPI1_DMA_armTX(txData, halfLen * 2);
+    DMAnCON1bits.SSTP = 0;
+    
+    return true;
+}
+
+//Stops the stream once the TX FIFO is empty and releases the channels
+void SPI1_DMA_stopStream(void)
+{
+    SPI1_DMA_RX_DCNTIE = 0;
+    
+    //Stop feeding the TX FIFO - SCK stops once it is empty
+    DMASELECT = SPI1_DMA_TX_CHANNEL;
+    DMAnCON0 = 0x00;
+    
+    while (SPI1CON2bits.BUSY);
+    
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnCON0 = 0x00;
+    rxActive = false;
+    
+    //Release SS and discard the remaining count
+    SPI1CON2bits.SSET = 0;
+    SPI1STATUSbits.CLRBF = 1;
+}
+
+void __interrupt(irq(SPI1_DMA_RX_DCNT_IRQ), base(INTERRUPT_BASE)) SPI1_DMA_streamISR(void)
+{
+    //The main code may be using another channel
+    uint8_t select = DMASELECT;
+    
+    SPI1_DMA_RX_DCNTIF = 0;
+    
+    //Keep the counter from reaching zero
+    SPI1_loadCount(SPI1_MAX_TCNT);
+    
+    //Pointer was reloaded with the other half, so this half is next after it
+    uint8_t completed = streamNextHalf;
+    streamNextHalf ^= 1;
+    
+    DMASELECT = SPI1_DMA_RX_CHANNEL;
+    DMAnDSA = (uint16_t) &streamRXData[completed ? streamHalfLen : 0];
+    
+    DMASELECT = select;
+    
+    if (streamCallback != 0)
+    {
+        streamCallback(completed);
+    }
+}
@@ -0,0 +1,92 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI1_HOST_DMA_H
+#define	SPI1_HOST_DMA_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include "spi1_host.h"
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+//DMA channels used for transfers (DMASELECT value, 0 = DMA1)
+#define SPI1_DMA_TX_CHANNEL 0
+#define SPI1_DMA_RX_CHANNEL 1
+    
+//Largest transfer the DMA counters can move
+#define SPI1_DMA_MAX_LEN 4095
+    
+//DMA trigger sources (interrupt vector numbers of the SPI1 flags)
+#define SPI1_DMA_TRIGGER_RX 0x18
+#define SPI1_DMA_TRIGGER_TX 0x19
+    
+//Destination count interrupt of the RX channel (must match SPI1_DMA_RX_CHANNEL)
+#define SPI1_DMA_RX_DCNT_IRQ DMA2DCNT
+#define SPI1_DMA_RX_DCNTIF DMA2DCNTIF
+#define SPI1_DMA_RX_DCNTIE DMA2DCNTIE
+    
+//Largest half buffer for streaming
+//The transfer counter is topped up once per half, so it can't reach zero
+#define SPI1_STREAM_MAX_HALF 1023
+    
+    //Initializes the DMA channels used by the SPI Host
+    //Locks the system arbiter priorities - call with interrupts disabled
+    void SPI1_DMA_init(void);
+    
+    //Starts sending and receiving LEN bytes. Returns immediately
+    //Buffers must remain valid until the transfer is complete
+    //Returns false, without starting, if LEN is 0 or above SPI1_DMA_MAX_LEN
+    bool SPI1_DMA_startExchange(uint8_t* txData, uint8_t* rxData, uint16_t len);
+    
+    //Starts sending LEN bytes. Received data is discarded
+    bool SPI1_DMA_startSend(uint8_t* txData, uint16_t len);
+    
+    //Starts receiving LEN bytes
+    bool SPI1_DMA_startReceive(uint8_t* rxData, uint16_t len);
+    
+    //Returns true while a DMA transfer is in progress
+    //Transfers longer than SPI1_MAX_TCNT are only advanced while this is polled
+    bool SPI1_DMA_isBusy(void);
+    
+    //Waits for the current DMA transfer to finish and releases the channels
+    //Returns SPI1_TIMEOUT, after SPI1_recover, if no byte moves for the
+    //timeout of the blocking transfers (see SPI1_setTimeout)
+    SPI1_result_t SPI1_DMA_complete(void);
+    
+    //Starts a continuous full-duplex stream. Buffers hold 2 halves of halfLen bytes
+    //halfCallback is run from the ISR with the half (0 or 1) that was just completed
+    //That half can then be refilled (TX) and read (RX) while the other half is clocked
+    //Returns false if halfLen is 0 or above SPI1_STREAM_MAX_HALF
+    //Interrupts must be enabled for the stream to run
+    bool SPI1_DMA_startStream(uint8_t* txData, uint8_t* rxData, uint16_t halfLen, void (*halfCallback)(uint8_t));
+    
+    //Stops the stream once the TX FIFO is empty and releases the channels
+    void SPI1_DMA_stopStream(void);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI1_HOST_DMA_H */
+
@@ -0,0 +1,44 @@
+#include "spi2_host.h"
+#include "spi_config.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//Only built on devices with a second SPI module
+#ifdef SPI2CON0
+
+//Core blocking functions are generated from the host template
+#define SPI_INSTANCE 2
+#define SPIx_TXIF PIR7bits.SPI2TXIF
+#define SPIx_RXIF PIR7bits.SPI2RXIF
+#include "spi_host_template.h"
+
+//Initializes the I/O for the SPI2 Host
+void SPI2_initPins(void)
+{
+    //Pins are set in spi_config.h
+    //RB2 - SDO
+    //RB3 - SDI
+    //RB1 - SCK
+    //RB4 - SS2
+    
+    //SDO Config
+    SPI_PIN_TRIS(SPI2_CFG_SDO_PIN) = 0;
+    SPI_PIN_PPS(SPI2_CFG_SDO_PIN) = SPI2_PPS_SDO;
+    
+    //SDI Config
+    SPI_PIN_TRIS(SPI2_CFG_SDI_PIN) = 1;
+    SPI_PIN_ANSEL(SPI2_CFG_SDI_PIN) = 0;
+    SPI2SDIPPS = SPI_PIN_INPUT(SPI2_CFG_SDI_PIN);
+    
+    //SCK Config
+    SPI_PIN_TRIS(SPI2_CFG_SCK_PIN) = 0;
+    SPI_PIN_PPS(SPI2_CFG_SCK_PIN) = SPI2_PPS_SCK;
+    
+    //SS Config
+    SPI_PIN_TRIS(SPI2_CFG_SS_PIN) = 0;
+    SPI_PIN_PPS(SPI2_CFG_SS_PIN) = SPI2_PPS_SS;
+}
+
+#endif
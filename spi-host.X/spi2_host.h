@@ -0,0 +1,97 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+#ifndef SPI2_HOST_H
+#define	SPI2_HOST_H
+
+#ifdef	__cplusplus
+extern "C" {
+#endif
+    
+#include <stdint.h>
+#include <stdbool.h>
+    
+    //Result of a blocking transfer
+    typedef enum {
+        SPI2_OK = 0, SPI2_TIMEOUT
+    } SPI2_result_t;
+    
+//Largest count the transfer counter (SPI2TCNTH:L) can hold
+#define SPI2_MAX_TCNT 2047
+    
+//Bytes loaded between top-ups of the counter (power of 2), leaving room for
+//the bytes in the TX FIFO and the shift register
+#define SPI2_TOPUP_BYTES 1024
+    
+    //Initializes SPI2 as a Host
+    //I/O must be initialized separately
+    void SPI2_initHost(void);
+    
+    //Initializes the I/O for the SPI2 Host
+    void SPI2_initPins(void);
+    
+    //Sets the timeout for blocking transfers, in us (0 disables the timeout)
+    void SPI2_setTimeout(uint16_t timeoutUs);
+    
+    //Resets the SPI module after a fault, keeping SPI2CON0/1/2
+    void SPI2_recover(void);
+    
+    //Returns the free-running Timer0 count, the timebase of the timeouts
+    uint16_t SPI2_readTimer(void);
+    
+    //Returns true if no progress has been made for the timeout since the
+    //Timer0 count lastProgress (always false if the timeout is disabled)
+    bool SPI2_isTimedOut(uint16_t lastProgress);
+    
+    //Loads the next block (up to SPI2_MAX_TCNT) of the transfer counter
+    //Returns the number of bytes left for later blocks
+    uint16_t SPI2_loadCount(uint16_t remaining);
+    
+    //Sets the counter back to SPI2_MAX_TCNT every SPI2_TOPUP_BYTES bytes
+    //loaded, for transfers longer than the counter
+    void SPI2_topUpCount(uint16_t loaded);
+    
+    //Drops the count left by a topped up transfer
+    void SPI2_discardCount(void);
+    
+    //Sends and receives a single byte
+    uint8_t SPI2_exchangeByte(uint8_t data);
+    
+    //Sends a single byte. Received data is discarded
+    void SPI2_sendByte(uint8_t data);
+    
+    //Receives a single byte
+    uint8_t SPI2_recieveByte(void);
+    
+    //Send and receives LEN bytes
+    SPI2_result_t SPI2_exchangeBytes(uint8_t* txData, uint8_t* rxData, uint16_t len);
+    
+    //Sends LEN bytes. Received data is discarded
+    SPI2_result_t SPI2_sendBytes(uint8_t* txData, uint16_t len);
+    
+    //Receives LEN bytes
+    SPI2_result_t SPI2_receiveBytes(uint8_t* rxData, uint16_t len);
+    
+#ifdef	__cplusplus
+}
+#endif
+
+#endif	/* SPI2_HOST_H */
+
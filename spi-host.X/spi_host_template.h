@@ -0,0 +1,451 @@
+/*
+ [2022] Microchip Technology Inc. and its subsidiaries.
+    Subject to your compliance with these terms, you may use Microchip 
+    software and any derivatives exclusively with Microchip products. 
+    You are responsible for complying with 3rd party license terms  
+    applicable to your use of 3rd party software (including open source  
+    software) that may accompany Microchip software. SOFTWARE IS ?AS IS.? 
+    NO WARRANTIES, WHETHER EXPRESS, IMPLIED OR STATUTORY, APPLY TO THIS 
+    SOFTWARE, INCLUDING ANY IMPLIED WARRANTIES OF NON-INFRINGEMENT,  
+    MERCHANTABILITY, OR FITNESS FOR A PARTICULAR PURPOSE. IN NO EVENT 
+    WILL MICROCHIP BE LIABLE FOR ANY INDIRECT, SPECIAL, PUNITIVE, 
+    INCIDENTAL OR CONSEQUENTIAL LOSS, DAMAGE, COST OR EXPENSE OF ANY 
+    KIND WHATSOEVER RELATED TO THE SOFTWARE, HOWEVER CAUSED, EVEN IF 
+    MICROCHIP HAS BEEN ADVISED OF THE POSSIBILITY OR THE DAMAGES ARE 
+    FORESEEABLE. TO THE FULLEST EXTENT ALLOWED BY LAW, MICROCHIP?S 
+    TOTAL LIABILITY ON ALL CLAIMS RELATED TO THE SOFTWARE WILL NOT 
+    EXCEED AMOUNT OF FEES, IF ANY, YOU PAID DIRECTLY TO MICROCHIP FOR 
+    THIS SOFTWARE.
+*/
+
+//SPI Host driver template
+//Generates the core blocking functions of a host driver for one SPI module
+//Registers and functions are pasted at compile time, so there is no runtime
+//indirection. Not a stand-alone header - include once from spiN_host.c with:
+//
+//  #define SPI_INSTANCE n          //Module number (SPInCON0, SPIn_exchangeBytes, ...)
+//  #define SPIx_TXIF PIRybits.SPInTXIF
+//  #define SPIx_RXIF PIRybits.SPInRXIF
+//
+//spiN_host.h must define SPIn_result_t (SPIn_OK, SPIn_TIMEOUT), SPIn_MAX_TCNT
+//and SPIn_TOPUP_BYTES
+//spi_config.h must define the SPIn register images and the Timer0 settings
+//spiN_host.c can also define SPIx_TRACE_START(txData, len) and
+//SPIx_TRACE(txData, rxData, len, result)
+
+#if !defined(SPI_INSTANCE) || !defined(SPIx_TXIF) || !defined(SPIx_RXIF)
+#error "Define SPI_INSTANCE, SPIx_TXIF and SPIx_RXIF before including spi_host_template.h"
+#endif
+
+#include "spi_config.h"
+
+#include <xc.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+//SPIx(name) expands to SPIn##name for the instance being generated
+#define SPI_PASTE(n, name) SPI ## n ## name
+#define SPI_EXPAND(n, name) SPI_PASTE(n, name)
+#define SPIx(name) SPI_EXPAND(SPI_INSTANCE, name)
+
+//Optional trace hooks, run before a transfer starts and when it ends (TX or
+//RX data is 0 if not used)
+#ifndef SPIx_TRACE_START
+#define SPIx_TRACE_START(txData, len)
+#endif
+
+#ifndef SPIx_TRACE
+#define SPIx_TRACE(txData, rxData, len, result)
+#endif
+
+//Transfers longer than the counter set it back to SPIx_MAX_TCNT before it
+//reaches zero. 2 bytes in the TX FIFO and 1 in the shift register are loaded
+//but not yet counted
+_Static_assert((SPIx(_TOPUP_BYTES) & (SPIx(_TOPUP_BYTES) - 1)) == 0, "SPIn_TOPUP_BYTES must be a power of 2");
+_Static_assert(SPIx(_TOPUP_BYTES) + 3 < SPIx(_MAX_TCNT), "SPIn_TOPUP_BYTES must leave the counter running");
+
+//Timeout for blocking transfers, in Timer0 ticks (0 = disabled)
+static uint16_t timeoutTicks = 0;
+
+//Returns the free-running Timer0 count
+uint16_t SPIx(_readTimer)(void)
+{
+    //Reading TMR0L latches TMR0H
+    uint8_t low = TMR0L;
+    return ((uint16_t) TMR0H << 8) | low;
+}
+
+//Returns true if no progress has been made for the timeout
+bool SPIx(_isTimedOut)(uint16_t lastProgress)
+{
+    return (timeoutTicks != 0) && ((uint16_t) (SPIx(_readTimer)() - lastProgress) >= timeoutTicks);
+}
+
+//Loads the next block of the transfer counter
+//Returns the number of bytes left for later blocks
+uint16_t SPIx(_loadCount)(uint16_t remaining)
+{
+    uint16_t count = (remaining > SPIx(_MAX_TCNT)) ? SPIx(_MAX_TCNT) : remaining;
+    
+    //High byte first, writing the low byte loads the counter
+    SPIx(TCNTH) = (uint8_t) (count >> 8);
+    SPIx(TCNTL) = (uint8_t) count;
+    
+    return remaining - count;
+}
+
+//Tops up the counter of a transfer longer than SPIx_MAX_TCNT
+//Called with the number of bytes loaded so far, after each byte is loaded
+void SPIx(_topUpCount)(uint16_t loaded)
+{
+    if ((loaded & (SPIx(_TOPUP_BYTES) - 1)) == 0)
+    {
+        //Set back to the maximum while bytes are still moving
+        SPIx(_loadCount)(SPIx(_MAX_TCNT));
+    }
+}
+
+//Discards the rest of a topped up count once the last byte is received
+//Disabling the module resets the counter and keeps the settings
+void SPIx(_discardCount)(void)
+{
+    SPIx(CON0bits).EN = 0;
+    SPIx(CON0bits).EN = 1;
+}
+
+//Initializes a SPI Host
+//I/O must be initialized separately
+void SPIx(_initHost)(void)
+{
+    //Images are from spi_config.h
+    //Configure with the module disabled
+    SPIx(CON0) = SPIx(_HOST_CON0_IMAGE) & 0x7F;
+    SPIx(CON1) = SPIx(_CON1_IMAGE);
+    SPIx(CON2) = SPIx(_CON2_IMAGE);
+    SPIx(CLK) = SPIx(_CLK_IMAGE);
+    SPIx(BAUD) = SPIx(_BAUD_IMAGE);
+    SPIx(TWIDTH) = SPIx(_TWIDTH_IMAGE);
+    
+    //Enable SPI
+    SPIx(CON0) = SPIx(_HOST_CON0_IMAGE);
+    
+    //Timer0 is the timebase for transfer timeouts, shared with the other
+    //instances and the trace. It is only started here if it is not running,
+    //so it is not reset under a transfer or timer running elsewhere
+    if (!T0CON0bits.EN)
+    {
+        //16-bit, settings from spi_config.h
+        T0CON0 = 0x00;
+        T0CON1 = SPI_TIMER0_CON1_IMAGE;
+        T0CON0bits.MD16 = 1;
+        T0CON0bits.EN = 1;
+    }
+}
+
+//Resets the SPI module after a fault, keeping its configuration
+void SPIx(_recover)(void)
+{
+    uint8_t con0 = SPIx(CON0);
+    uint8_t con1 = SPIx(CON1);
+    
+    //Keep TXR and RXR, release SS
+    uint8_t con2 = SPIx(CON2) & 0x03;
+    
+    //Disabling the module resets the shift register and the counter
+    SPIx(CON0bits).EN = 0;
+    SPIx(STATUSbits).CLRBF = 1;
+    SPIx(INTF) = 0x00;
+    
+    SPIx(CON1) = con1;
+    SPIx(CON2) = con2;
+    
+    //Re-enable with the original settings
+    SPIx(CON0) = con0;
+}
+
+//Sets the timeout for blocking transfers
+void SPIx(_setTimeout)(uint16_t timeoutUs)
+{
+    timeoutTicks = timeoutUs / SPI_TIMER0_TICK_US;
+    
+    if ((timeoutUs != 0) && (timeoutTicks == 0))
+    {
+        //Shortest timeout
+        timeoutTicks = 1;
+    }
+}
+
+//Sends and receives a single byte
+uint8_t SPIx(_exchangeByte)(uint8_t data)
+{
+    uint8_t output = data;
+    SPIx(_exchangeBytes)(&output, &output, 1);
+    return output;
+}
+
+//Sends a single byte. Received data is discarded.
+void SPIx(_sendByte)(uint8_t data)
+{
+    SPIx(_sendBytes)(&data, 1);
+}
+
+//Receives a single byte. Transmitted data is 0x00
+uint8_t SPIx(_recieveByte)(void)
+{
+    uint8_t rx = 0x00;
+    SPIx(_receiveBytes)(&rx, 1);
+    return rx;
+}
+
+//Send and receives LEN bytes.
+SPIx(_result_t) SPIx(_exchangeBytes)(uint8_t* txData, uint8_t* rxData, uint16_t len)
+{
+    SPIx_TRACE_START(txData, len);
+    
+    //Clear data buffers
+    SPIx(STATUSbits).CLRBF = 1;
+    
+    //Enable TX and RX
+    SPIx(CON2bits).TXR = 1;
+    SPIx(CON2bits).RXR = 1;
+    
+    //Clear status bit
+    SPIx(INTFbits).TCZIF = 0;
+    
+    //Longer transfers keep SS asserted and the counter topped up. TX data
+    //sets the length, and the transfer ends on the last byte received
+    bool topUp = (len > SPIx(_MAX_TCNT));
+    SPIx(CON2bits).SSET = topUp ? 1 : 0;
+    
+    //Load Byte 0
+    SPIx(TXB) = txData[0];
+    
+    //Set data length
+    SPIx(_loadCount)(len);
+    
+    //Write / Read Index
+    uint16_t wIndex = 1, rIndex = 0;
+    
+    //Timeout restarts whenever the transfer makes progress
+    uint16_t lastProgress = SPIx(_readTimer)();
+    
+    //While counter is not zero
+    while (topUp ? (rIndex < len) : (!SPIx(INTFbits).TCZIF))
+    {
+        if (SPIx(_isTimedOut)(lastProgress))
+        {
+            //Stuck - reset the module
+            SPIx(_recover)();
+            SPIx_TRACE(txData, rxData, len, SPIx(_TIMEOUT));
+            return SPIx(_TIMEOUT);
+        }
+        
+        if ((SPIx_TXIF) && (wIndex < len))
+        {
+            //TX Buffer has space, load next byte (until we hit the LEN)
+            SPIx(TXB) = txData[wIndex];
+            wIndex++;
+            
+            if (topUp)
+            {
+                SPIx(_topUpCount)(wIndex);
+            }
+            lastProgress = SPIx(_readTimer)();
+        }
+        
+        if (SPIx_RXIF)
+        {
+            //RX Buffer Ready
+            rxData[rIndex] = SPIx(RXB);
+            rIndex++;
+            lastProgress = SPIx(_readTimer)();
+        }
+    }
+    
+    //Protects against a possible edge case where a byte is received as the module stops
+    if (SPIx_RXIF)
+    {
+        //RX Buffer Ready
+        rxData[rIndex] = SPIx(RXB);
+        rIndex++;
+    }
+    
+    //Release SS
+    SPIx(CON2bits).SSET = 0;
+    
+    if (topUp)
+    {
+        SPIx(_discardCount)();
+    }
+    
+    SPIx_TRACE(txData, rxData, len, SPIx(_OK));
+    return SPIx(_OK);
+}
+
+//Sends LEN bytes. Received data is discarded.
+SPIx(_result_t) SPIx(_sendBytes)(uint8_t* txData, uint16_t len)
+{
+    SPIx_TRACE_START(txData, len);
+    
+    //Clear data buffers
+    SPIx(STATUSbits).CLRBF = 1;
+    
+    //Longer transfers keep the counter topped up and end on the last byte
+    //received, so RX is enabled and the data discarded
+    bool topUp = (len > SPIx(_MAX_TCNT));
+    
+    //Enable TX, and RX only to count the bytes of a longer transfer
+    SPIx(CON2bits).TXR = 1;
+    SPIx(CON2bits).RXR = topUp;
+    
+    //Clear status bit
+    SPIx(INTFbits).TCZIF = 0;
+    
+    //Keep SS asserted while the counter is topped up
+    SPIx(CON2bits).SSET = topUp ? 1 : 0;
+    
+    //Load Byte 0
+    SPIx(TXB) = txData[0];
+    
+    //Set data length
+    SPIx(_loadCount)(len);
+    
+    //Write / Read Index
+    uint16_t wIndex = 1, rIndex = 0;
+    
+    //Timeout restarts whenever the transfer makes progress
+    uint16_t lastProgress = SPIx(_readTimer)();
+    
+    //While counter is not zero
+    while (topUp ? (rIndex < len) : (!SPIx(INTFbits).TCZIF))
+    {
+        if (SPIx(_isTimedOut)(lastProgress))
+        {
+            //Stuck - reset the module
+            SPIx(_recover)();
+            SPIx_TRACE(txData, 0, len, SPIx(_TIMEOUT));
+            return SPIx(_TIMEOUT);
+        }
+        
+        if ((SPIx_TXIF) && (wIndex < len))
+        {
+            //TX Buffer has space, load next byte (until we hit the LEN)
+            SPIx(TXB) = txData[wIndex];
+            wIndex++;
+            
+            if (topUp)
+            {
+                SPIx(_topUpCount)(wIndex);
+            }
+            lastProgress = SPIx(_readTimer)();
+        }
+        
+        if (SPIx_RXIF)
+        {
+            //Byte of a longer transfer done - the data is discarded
+            (void) SPIx(RXB);
+            rIndex++;
+            lastProgress = SPIx(_readTimer)();
+        }
+    }
+    
+    //Release SS
+    SPIx(CON2bits).SSET = 0;
+    
+    if (topUp)
+    {
+        SPIx(_discardCount)();
+    }
+    
+    SPIx_TRACE(txData, 0, len, SPIx(_OK));
+    return SPIx(_OK);
+}
+
+//Receives LEN bytes. Transmitted data is 0x00
+SPIx(_result_t) SPIx(_receiveBytes)(uint8_t* rxData, uint16_t len)
+{
+    SPIx_TRACE_START(0, len);
+    
+    //Clear data buffers
+    SPIx(STATUSbits).CLRBF = 1;
+    
+    //Longer transfers keep the counter topped up, so the bytes are paced by
+    //0x00 fill bytes on TX instead of the count
+    bool topUp = (len > SPIx(_MAX_TCNT));
+    
+    //Enable RX, and TX only for the fill bytes of a longer transfer
+    SPIx(CON2bits).TXR = topUp;
+    SPIx(CON2bits).RXR = 1;
+    
+    //Clear status bit
+    SPIx(INTFbits).TCZIF = 0;
+    
+    //Keep SS asserted while the counter is topped up
+    SPIx(CON2bits).SSET = topUp ? 1 : 0;
+    
+    //Write / Read Index
+    uint16_t wIndex = 0, rIndex = 0;
+    
+    if (topUp)
+    {
+        //Load Byte 0
+        SPIx(TXB) = 0x00;
+        wIndex = 1;
+    }
+    
+    //Set data length
+    SPIx(_loadCount)(len);
+    
+    //Timeout restarts whenever the transfer makes progress
+    uint16_t lastProgress = SPIx(_readTimer)();
+    
+    //While counter is not zero
+    while (topUp ? (rIndex < len) : (!SPIx(INTFbits).TCZIF))
+    {
+        if (SPIx(_isTimedOut)(lastProgress))
+        {
+            //Stuck - reset the module
+            SPIx(_recover)();
+            SPIx_TRACE(0, rxData, len, SPIx(_TIMEOUT));
+            return SPIx(_TIMEOUT);
+        }
+        
+        if ((topUp) && (SPIx_TXIF) && (wIndex < len))
+        {
+            //Fill byte of a longer transfer
+            SPIx(TXB) = 0x00;
+            wIndex++;
+            SPIx(_topUpCount)(wIndex);
+            lastProgress = SPIx(_readTimer)();
+        }
+        
+        //Protects against a possible edge case where a byte is received as the module stops
+        if (SPIx_RXIF)
+        {
+            //RX Buffer Ready
+            rxData[rIndex] = SPIx(RXB);
+            rIndex++;
+            lastProgress = SPIx(_readTimer)();
+        }
+    }
+    
+    //Bytes received as the module stops. RX-only, the bus can run ahead of
+    //the loop and stop with both FIFO bytes unread
+    while ((SPIx_RXIF) && (rIndex < len))
+    {
+        //RX Buffer Ready
+        rxData[rIndex] = SPIx(RXB);
+        rIndex++;
+    }
+    
+    //Release SS
+    SPIx(CON2bits).SSET = 0;
+    
+    if (topUp)
+    {
+        SPIx(_discardCount)();
+    }
+    
+    SPIx_TRACE(0, rxData, len, SPIx(_OK));
+    return SPIx(_OK);
+}
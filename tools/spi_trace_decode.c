@@ -0,0 +1,246 @@
+//Decodes the binary log written by SPI1_traceDump
+//
+//Build:  cc -std=c99 -O2 -o spi_trace_decode tools/spi_trace_decode.c
+//        (make -C sim build/spi_trace_decode builds it with the tests)
+//Usage:  spi_trace_decode [log.bin]   (reads stdin if no file is given)
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+//Must match spi1_trace.h
+#define TRACE_VERSION 2
+
+#define TRACE_TX 0x01
+#define TRACE_RX 0x02
+#define TRACE_CLIENT 0x04
+#define TRACE_ASYNC 0x08
+
+#define TRACE_HEADER_SIZE 10
+#define TRACE_RECORD_FIXED 8
+#define TRACE_MAX_DATA 255
+#define TRACE_DEVICE_NONE 0xFF
+
+static const char* statusNames[] = {
+    "OK", "TIMEOUT", "CRC_ERROR", "RX_OVERFLOW", "TX_UNDERFLOW"
+};
+
+//Reads exactly COUNT bytes, returns false at the end of the input
+static bool readBytes(FILE* in, uint8_t* buffer, size_t count)
+{
+    return fread(buffer, 1, count, in) == count;
+}
+
+//Reads until the "SPTR" magic, returns false if it was not found
+static bool findMagic(FILE* in)
+{
+    static const uint8_t magic[4] = {'S', 'P', 'T', 'R'};
+    uint8_t matched = 0;
+    int c;
+
+    while ((c = fgetc(in)) != EOF)
+    {
+        if (c == magic[matched])
+        {
+            matched++;
+            if (matched == sizeof(magic))
+            {
+                return true;
+            }
+        }
+        else
+        {
+            matched = (c == magic[0]) ? 1 : 0;
+        }
+    }
+
+    return false;
+}
+
+//Prints COUNT bytes as hex
+static void printBytes(const char* label, const uint8_t* data, unsigned count)
+{
+    printf(" %s", label);
+
+    if (count == 0)
+    {
+        printf(" -");
+    }
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        printf(" %02X", data[i]);
+    }
+}
+
+static unsigned minLength(unsigned a, unsigned b)
+{
+    return (a < b) ? a : b;
+}
+
+//Decodes one log, returns false if the input ended early
+static bool decodeLog(FILE* in)
+{
+    uint8_t header[TRACE_HEADER_SIZE - 4];
+    if (!readBytes(in, header, sizeof(header)))
+    {
+        fprintf(stderr, "error: truncated header\n");
+        return false;
+    }
+
+    uint8_t version = header[0];
+    uint8_t dataBytes = header[1];
+    uint8_t tickUs = header[2];
+    uint8_t count = header[3];
+    uint16_t lost = header[4] | ((uint16_t) header[5] << 8);
+
+    if (version != TRACE_VERSION)
+    {
+        fprintf(stderr, "error: unsupported version %u\n", version);
+        return false;
+    }
+
+    printf("trace v%u: %u records, %u data bytes, %u us/tick", version, count, dataBytes, tickUs);
+    if (lost != 0)
+    {
+        printf(", %u%s older records lost", lost, (lost == 0xFFFF) ? "+" : "");
+    }
+    printf("\n");
+
+    uint8_t record[TRACE_RECORD_FIXED + TRACE_MAX_DATA];
+    uint32_t lastTimestamp = 0;
+    unsigned long long timeUs = 0;
+
+    for (unsigned i = 0; i < count; i++)
+    {
+        if (!readBytes(in, record, TRACE_RECORD_FIXED + dataBytes))
+        {
+            fprintf(stderr, "error: truncated record %u\n", i);
+            return false;
+        }
+
+        uint32_t timestamp = record[0] | ((uint32_t) record[1] << 8) |
+                             ((uint32_t) record[2] << 16) | ((uint32_t) record[3] << 24);
+        uint8_t flags = record[4];
+        uint8_t device = record[5];
+        uint16_t len = record[6] | ((uint16_t) record[7] << 8);
+        const uint8_t* data = &record[TRACE_RECORD_FIXED];
+
+        uint32_t ticks = timestamp - lastTimestamp;
+        unsigned long long deltaUs = (unsigned long long) ticks * tickUs;
+        if (i != 0)
+        {
+            timeUs += deltaUs;
+        }
+        else
+        {
+            deltaUs = 0;
+        }
+        lastTimestamp = timestamp;
+
+        const char* dir;
+        switch (flags & (TRACE_TX | TRACE_RX))
+        {
+            case TRACE_TX | TRACE_RX:
+                dir = "XCHG";
+                break;
+            case TRACE_TX:
+                dir = "TX";
+                break;
+            case TRACE_RX:
+                dir = "RX";
+                break;
+            default:
+                dir = "-";
+                break;
+        }
+
+        uint8_t status = flags >> 4;
+
+        printf("%4u %10llu us (+%llu) %-6s %-4s %-5s", i, timeUs, deltaUs,
+               (flags & TRACE_CLIENT) ? "client" : "host", dir, (flags & TRACE_ASYNC) ? "async" : "");
+
+        if (device == TRACE_DEVICE_NONE)
+        {
+            printf(" dev  -");
+        }
+        else
+        {
+            printf(" dev %2u", device);
+        }
+
+        if (status < sizeof(statusNames) / sizeof(statusNames[0]))
+        {
+            printf(" len %5u %-12s", len, statusNames[status]);
+        }
+        else
+        {
+            printf(" len %5u STATUS_%-5u", len, status);
+        }
+
+        if ((flags & (TRACE_TX | TRACE_RX)) == (TRACE_TX | TRACE_RX))
+        {
+            //First half sent, then first half received
+            printBytes("tx", &data[0], minLength(len, dataBytes / 2));
+            printBytes(" rx", &data[dataBytes / 2], minLength(len, dataBytes / 2));
+        }
+        else if (flags & (TRACE_TX | TRACE_RX))
+        {
+            printBytes((flags & TRACE_TX) ? "tx" : "rx", &data[0], minLength(len, dataBytes));
+        }
+
+        printf("\n");
+    }
+
+    return true;
+}
+
+int main(int argc, char** argv)
+{
+    FILE* in = stdin;
+
+    if (argc > 2)
+    {
+        fprintf(stderr, "usage: %s [log.bin]\n", argv[0]);
+        return 2;
+    }
+
+    if ((argc == 2) && (strcmp(argv[1], "-") != 0))
+    {
+        in = fopen(argv[1], "rb");
+        if (in == NULL)
+        {
+            perror(argv[1]);
+            return 2;
+        }
+    }
+
+    //A capture may hold several dumps, and other UART output between them
+    unsigned logs = 0;
+    bool ok = true;
+
+    while (ok && findMagic(in))
+    {
+        if (logs != 0)
+        {
+            printf("\n");
+        }
+
+        ok = decodeLog(in);
+        logs++;
+    }
+
+    if (in != stdin)
+    {
+        fclose(in);
+    }
+
+    if (logs == 0)
+    {
+        fprintf(stderr, "error: no trace log found\n");
+        return 1;
+    }
+
+    return ok ? 0 : 1;
+}